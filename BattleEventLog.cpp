@@ -0,0 +1,383 @@
+/*
+Append-only binary log of battle events: block writer with per block checksums, reader that stops at a torn tail,
+and a replayer that rebuilds trainer histories from the events.
+*/
+
+#include "battleeventlog.h"
+#include "gamedata.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// Layout, in native byte order: FileHeader, then blocks, each a BlockHeader followed by its EventRecords. The
+// checksum covers the records, and the count is checked against the bytes left, so a block cut short or written over
+// is found. Blocks are only ever added at the end.
+namespace {
+    struct FileHeader {
+        char magic[8];
+        uint32_t formatVersion;
+        uint32_t recordBytes;
+    };
+
+    struct BlockHeader {
+        uint32_t eventCount;
+        uint32_t checksum; // CRC-32 of the block's records
+    };
+
+    struct EventRecord {
+        uint32_t frame;
+        uint32_t milliseconds; // Timestamp, which covers 49 days of capture
+        int32_t value;
+        uint8_t type;
+        uint8_t padding[3];
+    };
+
+    static_assert(sizeof(EventRecord) == 16, "Event records are written as plain bytes");
+
+    const char MAGIC[8] = { 'P', 'K', 'M', 'N', 'E', 'V', 'T', 'S' };
+
+    // Table for the reflected CRC-32 used by zip and PNG, built once at compile time.
+    constexpr std::array<uint32_t, 256> makeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0u);
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+    uint32_t crc32(const char* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) crc = (crc >> 8) ^ CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF];
+        return ~crc;
+    }
+
+    FileHeader makeFileHeader() {
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.formatVersion = BattleEventLog::FORMAT_VERSION;
+        header.recordBytes = sizeof(EventRecord);
+        return header;
+    }
+
+    bool readWholeFile(const std::string& path, std::vector<char>& bytes) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        return static_cast<bool>(file.read(bytes.data(), bytes.size()));
+    }
+
+    // Checks the header and hands each intact block's records to visit, stopping at the first damaged block. Returns
+    // false when the bytes are not an event log of this format.
+    template <typename Visit>
+    bool forEachBlock(const std::vector<char>& bytes, BattleEventLogStats& stats, const Visit& visit) {
+        FileHeader header;
+        if (bytes.size() < sizeof(header)) return false;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.formatVersion != BattleEventLog::FORMAT_VERSION
+            || header.recordBytes != sizeof(EventRecord)) {
+            return false;
+        }
+
+        size_t offset = sizeof(header);
+        while (offset < bytes.size()) {
+            BlockHeader block;
+            if (bytes.size() - offset < sizeof(block)) break;
+            std::memcpy(&block, bytes.data() + offset, sizeof(block));
+            const char* records = bytes.data() + offset + sizeof(block);
+            size_t recordBytes = static_cast<size_t>(block.eventCount) * sizeof(EventRecord);
+            if (block.eventCount == 0 || bytes.size() - offset - sizeof(block) < recordBytes || crc32(records, recordBytes) != block.checksum) break;
+
+            visit(records, block.eventCount);
+            offset += sizeof(block) + recordBytes;
+            stats.events += block.eventCount;
+            stats.blocks++;
+        }
+        stats.intactBytes = offset;
+        stats.damagedTail = offset < bytes.size();
+        return true;
+    }
+
+    bool inRange(int32_t id, size_t count) {
+        return id >= 0 && static_cast<size_t>(id) < count;
+    }
+
+    void addUnique(std::vector<int>& ids, int id) {
+        if (id >= 0 && std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+    }
+}
+
+//Constructor and Destructor
+BattleEventLog::BattleEventLog() : eventsWritten(0), blocksWritten(0) {
+    pending.reserve(BLOCK_EVENTS);
+    encoded.reserve(sizeof(BlockHeader) + BLOCK_EVENTS * sizeof(EventRecord));
+}
+
+BattleEventLog::~BattleEventLog() {
+    close();
+}
+
+bool BattleEventLog::open(const std::string& path) {
+    close();
+    std::vector<char> bytes;
+    bool existing = readWholeFile(path, bytes) && !bytes.empty();
+    if (existing) {
+        BattleEventLogStats stats;
+        if (!forEachBlock(bytes, stats, [](const char*, uint32_t) {})) {
+            std::cerr << "Not a battle event log: " << path << std::endl;
+            return false;
+        }
+        if (stats.damagedTail) {
+            // Left by a crash partway through a block, appending after it would hide every later block.
+            std::cerr << "Dropping " << bytes.size() - stats.intactBytes << " damaged bytes from the end of " << path << std::endl;
+            std::error_code error;
+            std::filesystem::resize_file(path, stats.intactBytes, error);
+            if (error) {
+                std::cerr << "Error truncating event log: " << error.message() << std::endl;
+                return false;
+            }
+        }
+    }
+
+    file.open(path, std::ios::binary | (existing ? std::ios::app : std::ios::trunc));
+    if (!file) {
+        std::cerr << "Error opening event log: " << path << std::endl;
+        return false;
+    }
+    if (!existing) {
+        FileHeader header = makeFileHeader();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.flush();
+    }
+    return static_cast<bool>(file);
+}
+
+void BattleEventLog::close() {
+    if (!file.is_open()) return;
+    flush();
+    file.close();
+}
+
+bool BattleEventLog::isOpen() const {
+    return file.is_open();
+}
+
+void BattleEventLog::append(const BattleEvent& event) {
+    pending.push_back(event);
+    if (pending.size() >= BLOCK_EVENTS) flush();
+}
+
+void BattleEventLog::flush() {
+    if (pending.empty() || !file.is_open()) return;
+
+    encoded.resize(sizeof(BlockHeader) + pending.size() * sizeof(EventRecord));
+    char* records = encoded.data() + sizeof(BlockHeader);
+    for (size_t i = 0; i < pending.size(); i++) {
+        const BattleEvent& event = pending[i];
+        EventRecord record{};
+        record.frame = event.frame;
+        record.milliseconds = static_cast<uint32_t>(std::llround(std::max(0.0, event.timestamp) * 1000.0));
+        record.value = event.value;
+        record.type = static_cast<uint8_t>(event.type);
+        std::memcpy(records + i * sizeof(record), &record, sizeof(record));
+    }
+    BlockHeader block;
+    block.eventCount = static_cast<uint32_t>(pending.size());
+    block.checksum = crc32(records, pending.size() * sizeof(EventRecord));
+    std::memcpy(encoded.data(), &block, sizeof(block));
+
+    file.write(encoded.data(), encoded.size());
+    file.flush();
+    if (!file) {
+        std::cerr << "Error writing event log, " << pending.size() << " events lost" << std::endl;
+    }
+    else {
+        eventsWritten += pending.size();
+        blocksWritten++;
+    }
+    pending.clear();
+}
+
+uint64_t BattleEventLog::getEventsWritten() const {
+    return eventsWritten;
+}
+
+uint64_t BattleEventLog::getBlocksWritten() const {
+    return blocksWritten;
+}
+
+bool BattleEventLog::read(const std::string& path, const std::function<void(const BattleEvent&)>& visit, BattleEventLogStats* stats) {
+    std::vector<char> bytes;
+    if (!readWholeFile(path, bytes)) {
+        std::cerr << "Error opening event log: " << path << std::endl;
+        return false;
+    }
+
+    BattleEventLogStats counts;
+    bool ok = forEachBlock(bytes, counts, [&visit](const char* records, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            EventRecord record;
+            std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+            BattleEvent event;
+            event.type = static_cast<BattleEventType>(record.type);
+            event.value = record.value;
+            event.frame = record.frame;
+            event.timestamp = record.milliseconds / 1000.0;
+            visit(event);
+        }
+    });
+    if (!ok) {
+        std::cerr << "Not a battle event log: " << path << std::endl;
+        return false;
+    }
+    if (stats) *stats = counts;
+    return true;
+}
+
+//Constructor
+BattleEventReplayer::BattleEventReplayer() : trainers(GameData::trainers.size()), currentTrainer(-1), activeSlot(-1), currentStreak(-1),
+    eventsApplied(0), eventsRejected(0), battles(0) {
+    team.fill(Pokemon());
+}
+
+// Adds the battle's team to its trainer's history, as the Trainer destructor queues it for the database.
+void BattleEventReplayer::endBattle() {
+    if (currentTrainer < 0) return;
+    TrainerHistory& history = trainers[currentTrainer];
+    for (const Pokemon& slot : team) {
+        if (slot.isEmpty()) continue;
+        auto known = std::find_if(history.pokemon.begin(), history.pokemon.end(),
+            [&slot](const PokemonHistory& pokemon) { return pokemon.species == slot.species; });
+        if (known == history.pokemon.end()) {
+            history.pokemon.emplace_back();
+            history.pokemon.back().species = slot.species;
+            known = history.pokemon.end() - 1;
+        }
+        for (size_t move = 0; move < slot.getMoveCount(); move++) addUnique(known->moves, slot.moves[move]);
+        addUnique(known->abilities, slot.ability);
+        addUnique(known->items, slot.item);
+    }
+    team.fill(Pokemon());
+    currentTrainer = -1;
+    activeSlot = -1;
+    battles++;
+}
+
+void BattleEventReplayer::apply(const BattleEvent& event) {
+    int32_t value = event.value;
+    Pokemon* active = currentTrainer >= 0 && activeSlot >= 0 ? &team[activeSlot] : nullptr;
+    bool applied = true;
+    switch (event.type) {
+    case BattleEventType::StreakDetected:
+        applied = value >= 0;
+        if (applied) currentStreak = value;
+        break;
+
+    case BattleEventType::TrainerFound:
+        applied = inRange(value, GameData::trainers.size());
+        if (applied) {
+            endBattle();
+            currentTrainer = value;
+        }
+        break;
+
+    case BattleEventType::PokemonSentOut: {
+        applied = currentTrainer >= 0 && inRange(value, GameData::pokemon.size());
+        if (!applied) break;
+        // Back out after a switch, or into the first empty slot. A fourth species has no slot and nothing is kept.
+        auto slot = std::find_if(team.begin(), team.end(), [value](const Pokemon& pokemon) { return pokemon.species == value; });
+        if (slot == team.end()) slot = std::find_if(team.begin(), team.end(), [](const Pokemon& pokemon) { return pokemon.isEmpty(); });
+        if (slot != team.end()) slot->species = static_cast<int16_t>(value);
+        activeSlot = slot != team.end() ? static_cast<int>(slot - team.begin()) : -1;
+        break;
+    }
+
+    case BattleEventType::MoveSeen:
+        applied = active && inRange(value, GameData::moves.size());
+        if (applied) active->addMove(value);
+        break;
+
+    case BattleEventType::AbilitySeen:
+        applied = active && inRange(value, GameData::abilities.size());
+        if (applied) active->ability = static_cast<int16_t>(value);
+        break;
+
+    case BattleEventType::ItemSeen:
+        applied = active && inRange(value, GameData::items.size());
+        if (applied) active->item = static_cast<int16_t>(value);
+        break;
+
+    case BattleEventType::FoeFainted:
+        activeSlot = -1;
+        break;
+
+    case BattleEventType::TrainerDefeated:
+        endBattle();
+        break;
+
+    case BattleEventType::StreakWon:
+    case BattleEventType::StreakLost:
+        endBattle();
+        currentStreak = event.type == BattleEventType::StreakLost ? 0 : value;
+        break;
+
+    default:
+        applied = false;
+        break;
+    }
+
+    if (applied) eventsApplied++;
+    else eventsRejected++;
+}
+
+bool BattleEventReplayer::replay(const std::string& path, BattleEventLogStats* stats) {
+    bool ok = BattleEventLog::read(path, [this](const BattleEvent& event) { apply(event); }, stats);
+    finish();
+    return ok;
+}
+
+void BattleEventReplayer::finish() {
+    endBattle();
+}
+
+const TrainerHistory& BattleEventReplayer::getHistory(int trainer) const {
+    static const TrainerHistory none;
+    return inRange(trainer, trainers.size()) ? trainers[trainer] : none;
+}
+
+void BattleEventReplayer::toSightings(std::vector<SightingRecord>& records) const {
+    for (size_t id = 0; id < trainers.size(); id++) {
+        if (trainers[id].pokemon.empty()) continue;
+        std::string trainer(GameData::trainers.nameOf(static_cast<int>(id)));
+        for (const PokemonHistory& pokemon : trainers[id].pokemon) {
+            std::string species(GameData::pokemon.nameOf(pokemon.species));
+            records.push_back({ trainer, species, SightingKind::Pokemon, "" });
+            for (int move : pokemon.moves) records.push_back({ trainer, species, SightingKind::Move, std::string(GameData::moves.nameOf(move)) });
+            for (int ability : pokemon.abilities) records.push_back({ trainer, species, SightingKind::Ability, std::string(GameData::abilities.nameOf(ability)) });
+            for (int item : pokemon.items) records.push_back({ trainer, species, SightingKind::Item, std::string(GameData::items.nameOf(item)) });
+        }
+    }
+}
+
+int BattleEventReplayer::getCurrentStreak() const {
+    return currentStreak;
+}
+
+uint64_t BattleEventReplayer::getEventsApplied() const {
+    return eventsApplied;
+}
+
+uint64_t BattleEventReplayer::getEventsRejected() const {
+    return eventsRejected;
+}
+
+uint64_t BattleEventReplayer::getBattles() const {
+    return battles;
+}
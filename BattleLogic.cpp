@@ -1,17 +1,30 @@
 #include "battlelogic.h"
 #include "gamedata.h"
-#include <cctype>
-#include <sstream>
+#include <algorithm>
 #include <iostream>
 
+namespace {
+	// Lowest fuzzy match confidence acted on. Keeps one letter misreads of four letter words ("SURE", "HAVE") from
+	// becoming moves, while "GEODUDF" still becomes GEODUDE.
+	const float MIN_FUZZY_CONFIDENCE = 0.8f;
+
+	void printSeen(const char* label, const std::vector<int>& ids, EntityType type) {
+		if (ids.empty()) return;
+		std::cout << " " << label << ":";
+		for (size_t i = 0; i < ids.size(); i++) {
+			std::cout << (i == 0 ? " " : ", ") << getGameDataName(type, ids[i]);
+		}
+	}
+}
+
 //Constructor and Destructor
-BattleLogic::BattleLogic() : state(0), currentTrainer(nullptr), currentStreak(-1) {}
+BattleLogic::BattleLogic(const std::vector<DialogueTrigger>& facilityTriggers) : state(0), currentStreak(-1),
+	streakReadings{ -1, -1 }, facilityLevel(0), dialogueStates(facilityTriggers), eventLog(nullptr), lineFrame(0), lineTimestamp(0.0) {
+	entities.reserve(DialogueTokenizer::MAX_TOKENS); // A line holds at most one name per token
+}
 
 void BattleLogic::clearCurrentTrainer() {
-	if (currentTrainer) {
-		delete currentTrainer;
-		currentTrainer = nullptr;
-	}
+	currentTrainer.reset();
 }
 
 BattleLogic::~BattleLogic() {
@@ -20,15 +33,14 @@ BattleLogic::~BattleLogic() {
 
 // Resets tracking state to beginning, as the streak has been exited either through a win or loss;
 void BattleLogic::resetState(bool win) {
-	state = 0;
 	if (win && currentStreak >= 0) currentStreak++; // User has won the set, so the streak is incremented.
 	else if (!win) currentStreak = 0; // User has lost the set, so the streak is reset to 0.
-	clearCurrentTrainer();
+	resetState(0);
 }
 
 void BattleLogic::resetState(int newState) {
 	state = newState;
-	if (newState == 1) { // Logic has detected that the trainer has been defeated, so the program clears the current trainer for the next one.
+	if (newState <= 1) { // The trainer has been defeated or the streak has ended, so the program clears the current trainer for the next one.
 		clearCurrentTrainer();
 	}
 }
@@ -40,6 +52,20 @@ int BattleLogic::getCurrentStreak() const {
 void BattleLogic::setCurrentStreak(int streak) {
 	currentStreak = streak / 7; //Streak numbers go by battles, which are 7 per set. This gives the program how many sets have been completed.
 	std::cout << "Streak Number Detected: " << currentStreak << std::endl;
+	recordEvent(BattleEventType::StreakDetected, currentStreak);
+}
+
+void BattleLogic::setEventLog(BattleEventLog* log) {
+	eventLog = log;
+}
+
+void BattleLogic::setFrame(uint64_t frame, double timestamp) {
+	lineFrame = static_cast<uint32_t>(frame);
+	lineTimestamp = timestamp;
+}
+
+void BattleLogic::recordEvent(BattleEventType type, int value) {
+	if (eventLog) eventLog->append({ type, value, lineFrame, lineTimestamp });
 }
 
 // Increments the state by one
@@ -51,22 +77,6 @@ int BattleLogic::getState() const {
 	return state;
 }
 
-std::vector<std::string> BattleLogic::tokenizeDialogue(const std::string& dialogue) {
-	std::vector<std::string> tokens;
-	std::istringstream iss(dialogue);
-	std::string word;
-
-	while (iss >> word) {
-		std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) {
-			return std::toupper(c);
-			});
-		tokens.push_back((word));
-	}
-
-	return tokens;
-}
-
-
 void BattleLogic::handleStreakNumber(int streak) {
 	if (state == 0) {
 		if (streak % 7 == 0) {
@@ -78,161 +88,209 @@ void BattleLogic::handleStreakNumber(int streak) {
 	}
 }
 
-void BattleLogic::handleDialogueLine(const std::string& dialogue) { //Main function to handle dialogue lines and update the state accordingly.
-	auto tokens = tokenizeDialogue(dialogue);
-	if (state == 0) { // Initial state, looking for dialogue that indicates the start of a streak or trainer battle.
-		if (tokens.size() >= 8 && tokens[0] == "I" && tokens[1] == "WILL" && tokens[2] == "NOW" && tokens[3] == "SHOW" && tokens[4] == 
-			"YOU" && tokens[5] == "TO" && tokens[6] == "THE" && tokens[7] == "SINGLE") {
-			std::cout << "Detected streak start dialogue, advancing state." << std::endl;
-			advanceState();
-			return;
-		}
-		else if (tokens.size() >= 5 && tokens[0] == "YOU" && tokens[1] == "WILL" && tokens[2] == "BE" && tokens[3] == "FACING" && tokens[4] ==
-			"OPPONENT") {
-			std::cout << "Detected streak start dialogue, advancing state." << std::endl;
-			advanceState();
-			return;
-		}
+void BattleLogic::handleStreakNumbers(int level50Streak, int openLevelStreak) {
+	if (state != 0) return;
+	if (facilityLevel == 50) {
+		if (level50Streak >= 0) handleStreakNumber(level50Streak);
+	}
+	else if (facilityLevel == 100) {
+		if (openLevelStreak >= 0) handleStreakNumber(openLevelStreak);
+	}
+	else {
+		if (level50Streak >= 0) streakReadings[0] = level50Streak;
+		if (openLevelStreak >= 0) streakReadings[1] = openLevelStreak;
 	}
+}
 
-	else if (state == 1) { // State that looks for a trainer name to indicate a battle has started.
-		for (size_t i = 0; i + 1 < tokens.size(); ++i) {
-			// Some trainers have two-word names.
-			std::string twoWord = tokens[i] + " " + tokens[i + 1];
-			if (GameData::setTrainers.find(twoWord) != GameData::setTrainers.end()) {
-				if (currentStreak >= 0) {
-					currentTrainer = new Trainer(twoWord, currentStreak);
-					std::cout << "Trainer found: " << twoWord << " with streak: " << currentStreak << std::endl;
-				}
-				else {
-					currentTrainer = new Trainer(twoWord);
-					std::cout << "Trainer found: " << twoWord << " with no streak." << std::endl;
-				}
-				advanceState();
-				return;
-			}
+int BattleLogic::getFacilityLevel() const {
+	return facilityLevel;
+}
+
+// "YOU WILL BE FACING OPPONENT NO. 7": the next battle is the 7th of the set, so the level being challenged is the one
+// whose streak has 6 battles of the set won. When both counters fit, or no number was read, level 50 is taken.
+void BattleLogic::chooseFacilityLevel(size_t firstToken) {
+	int opponent = 0;
+	for (size_t i = firstToken; i < tokens.size() && opponent == 0; i++) {
+		size_t digit = tokens[i].find_first_of("0123456789"); // "7." keeps its period, OCR can run it into "NO.7."
+		if (digit != std::string_view::npos) opponent = tokens[i][digit] - '0';
+	}
+	const bool level50Fits = streakReadings[0] >= 0 && streakReadings[0] % 7 + 1 == opponent;
+	const bool openLevelFits = streakReadings[1] >= 0 && streakReadings[1] % 7 + 1 == opponent;
+	if (level50Fits != openLevelFits) {
+		facilityLevel = level50Fits ? 50 : 100;
+		std::cout << "Facility level detected: " << (level50Fits ? "50" : "open") << std::endl;
+	}
+
+	int streak = facilityLevel == 100 || streakReadings[0] < 0 ? streakReadings[1] : streakReadings[0];
+	if (streak >= 0) handleStreakNumber(streak);
+	streakReadings[0] = streakReadings[1] = -1;
+}
+
+void BattleLogic::startTrainerBattle(std::string_view trainerName) {
+	const int trainer = GameData::trainers.find(trainerName);
+	trainerName = GameData::trainers.nameOf(trainer); // The line's copy is gone once the next line is tokenized
+	if (currentStreak >= 0) {
+		currentTrainer.emplace(trainerName, currentStreak);
+		std::cout << "Trainer found: " << trainerName << " with streak: " << currentStreak << std::endl;
+	}
+	else {
+		currentTrainer.emplace(trainerName);
+		std::cout << "Trainer found: " << trainerName << " with no streak." << std::endl;
+	}
+	recordEvent(BattleEventType::TrainerFound, trainer);
+
+	// Scouting report from earlier battles, straight from memory.
+	if (TrainerKnowledge::shared().getHistory(trainerName, scouting)) {
+		for (const PokemonHistory& pokemon : scouting.pokemon) {
+			std::cout << "Seen before: " << GameData::pokemon.nameOf(pokemon.species);
+			printSeen("moves", pokemon.moves, EntityType::Move);
+			printSeen("ability", pokemon.abilities, EntityType::Ability);
+			printSeen("item", pokemon.items, EntityType::Item);
+			std::cout << std::endl;
 		}
-		for (size_t i = 0; i + 2 < tokens.size(); i++) {
-			// Some trainers have three-word names.
-			std::string threeWord = tokens[i] + " " + tokens[i + 1] + " " + tokens[i + 2];
-			if (GameData::setTrainers.find(threeWord) != GameData::setTrainers.end()) {
-				if (currentStreak >= 0) {
-					currentTrainer = new Trainer(threeWord, currentStreak);
-					std::cout << "Trainer found: " << threeWord << " with streak: " << currentStreak << std::endl;
-				}
-				else {
-					currentTrainer = new Trainer(threeWord);
-					std::cout << "Trainer found: " << threeWord << " with no streak." << std::endl;
-				}
-				advanceState();
-				return;
+	}
+	advanceState();
+}
+
+bool BattleLogic::findMisreadName(size_t firstToken, size_t endToken, size_t minWords, size_t maxWords, unsigned typeMask, FuzzyMatch& best) const {
+	bool found = false;
+	endToken = std::min(endToken, tokens.size());
+	for (size_t words = minWords; words <= maxWords; words++) {
+		for (size_t i = firstToken; i + words <= endToken; i++) {
+			FuzzyMatch match;
+			if (!FuzzyEntityIndex::gameData().lookup(tokens.span(i, words), match, typeMask)) continue;
+			if (match.confidence >= MIN_FUZZY_CONFIDENCE && (!found || match.confidence > best.confidence)) {
+				best = match;
+				found = true;
 			}
 		}
 	}
+	return found;
+}
+
+void BattleLogic::revealDetail(EntityType type, int id) {
+	Pokemon* active = currentTrainer ? currentTrainer->getActivePokemon() : nullptr;
+	switch (type) {
+	case EntityType::Move:
+		recordEvent(BattleEventType::MoveSeen, id);
+		if (active) active->addMove(id);
+		break;
+	case EntityType::Ability:
+		recordEvent(BattleEventType::AbilitySeen, id);
+		if (active) active->ability = static_cast<int16_t>(id);
+		break;
+	case EntityType::Item:
+		recordEvent(BattleEventType::ItemSeen, id);
+		if (active) active->item = static_cast<int16_t>(id);
+		break;
+	default:
+		break;
+	}
+}
 
-	else if (state == 2) { // State that looks for a Pokemon being sent out or the end of a battle. 
-		if (tokens.size() >= 4) {
-			// Trainer Pokemon being sent out has a set dialogue, so we can check for that to not confuse user Pokemon with trainer Pokemon.
-			for (size_t i = 0; i + 2 < tokens.size(); ++i) {
-				if (tokens[i] == "SENT" && tokens[i + 1] == "OUT") {
-					std::string possiblePokemon = tokens[i + 2];
-
-					if (!possiblePokemon.empty() && possiblePokemon.back() == '!') {
-						possiblePokemon.pop_back(); // Remove the '!' at the end if it exists.
-					}
-
-					if (GameData::setPokemon.find(possiblePokemon) != GameData::setPokemon.end()) {
-						if (!currentTrainer->isPokemonInActive(possiblePokemon)) {
-							currentTrainer->updateActiveSlot(possiblePokemon);
-							std::cout << "Pokemon found: " << possiblePokemon << " for trainer: " << currentTrainer->getTrainerName() << std::endl;
-							advanceState();
-						}
-					}
-					return;
-				}
-			}
-			//Check to see if the user has won or lost the battle, including if the user has completed the streak of trainers.
-			if (tokens[0] == "CONGRATULATIONS!" && "YOU'VE" && "BEATEN" && "ALL") { // The user has defeated the streak of trainers, bringing them back to the entry point.
-				resetState(true);
-				std::cout << "Streak completed, resetting state to 0." << std::endl;
-				return;
-			}
-			else if (tokens[0] == "YOU" && tokens[1] == "HAVE" && tokens[2] == "BEEN" && tokens[3] == "DEFEATED!") { // Placeholder dialogue, find out real losing dialogue for this to function.
-				resetState(false);
-				std::cout << "Streak failed, resetting state to 0." << std::endl;
-				return;
-			}
+void BattleLogic::handleDialogueLine(std::string_view dialogue) { //Main function to handle dialogue lines and update the state accordingly.
+	tokens.tokenize(dialogue);
+	TriggerMatch trigger;
+	if (!dialogueStates.match(state, tokens, trigger)) return;
+	if (runAction(trigger) && trigger.trigger->nextState >= 0) resetState(trigger.trigger->nextState);
+}
 
-			else if (tokens[0] == "WE" && tokens[1] == "WILL" && tokens[2] == "RESTORE" && tokens[3] == "YOUR") { // The trainer has been defeated, and the streak continues.
-				resetState(1);
-				std::cout << "Trainer defeated, resetting state to 1." << std::endl;
-				return;
-			}
+bool BattleLogic::runAction(const TriggerMatch& trigger) {
+	switch (trigger.trigger->action) {
+	case DialogueAction::AnnounceStreak:
+		std::cout << "Detected streak start dialogue, advancing state." << std::endl;
+		if (currentStreak < 0) chooseFacilityLevel(trigger.endToken);
+		return true;
+
+	case DialogueAction::StartBattle: {
+		// Trainer names are two or three words, the matcher finds either in one pass over the line.
+		EntityMatcher::gameData().find(tokens, entities);
+		for (const EntitySpan& entity : entities) {
+			if (entity.type != EntityType::Trainer) continue;
+			startTrainerBattle(tokens.span(entity.firstToken, entity.tokenCount));
+			return true;
+		}
+
+		// No exact name, look for a misread one ("HEX MANIAC MOLLX").
+		FuzzyMatch misread;
+		if (findMisreadName(0, tokens.size(), 2, 3, entityTypeMask(EntityType::Trainer), misread)) {
+			startTrainerBattle(GameData::trainers.nameOf(misread.id));
+			return true;
 		}
+		return false;
 	}
 
-	else if (state == 3) {
-		if (tokens.size() > 1) {
-			if (tokens[0] == "FOE" || tokens[0] == "USING") {
-				// Check for two word moves, abilities, or items
-				for (size_t i = 1; i + 1 < tokens.size(); ++i) {
-					std::string twoWord = tokens[i] + " " + tokens[i + 1];
-					if (!twoWord.empty()) {
-						if (twoWord.back() == '!' || twoWord.back() == ','){
-							twoWord.pop_back(); // Remove the '!' or ',' at the end if it exists.
-						}
-					}
-
-					if (GameData::setMoves.find(twoWord) != GameData::setMoves.end()) {
-						std::cout << "Detected move: " << twoWord << std::endl;
-						// logic to add move to Trainer's active slot Pokemon
-						return;
-					}
-					if (GameData::setAbilities.find(twoWord) != GameData::setAbilities.end()) {
-						std::cout << "Detected ability: " << twoWord << std::endl;
-						// logic to add ability to Trainer's active slot Pokemon
-						return;
-					}
-					if (GameData::setItems.find(twoWord) != GameData::setItems.end()) {
-						std::cout << "Detected item: " << twoWord << std::endl;
-						// logic to add item to Trainer's active slot Pokemon
-						return;
-					}
-				}
-
-				// Check for single word moves, abilities, or items
-				for (size_t i = 1; i < tokens.size(); ++i) {
-					std::string oneWord = tokens[i];
-					if (!oneWord.empty()) {
-						if (oneWord.back() == '!' || oneWord.back() == ',') {
-							oneWord.pop_back(); // Remove the '!' at the end if it exists.
-						}
-					}
-
-					if (GameData::setMoves.find(oneWord) != GameData::setMoves.end()) {
-						std::cout << "Detected move: " << oneWord << std::endl;
-						// logic to add move to Trainer's active slot Pokemon
-						return;
-					}
-					if (GameData::setAbilities.find(oneWord) != GameData::setAbilities.end()) {
-						std::cout << "Detected ability: " << oneWord << std::endl;
-						// logic to add ability to Trainer's active slot Pokemon
-						return;
-					}
-					if (GameData::setItems.find(oneWord) != GameData::setItems.end()) {
-						std::cout << "Detected item: " << oneWord << std::endl;
-						// logic to add item to Trainer's active slot Pokemon
-						return;
-					}
-				}
-				if (tokens[2] == "FAINTED!") {
-					//logic to handle the fainted Pokemon
-					std::cout << "Foe Pokemon has fainted." << std::endl;
-					resetState(2); // Ready for next Pokemon
-					return;
-				}
-				//else if for when the trainer switches out a Pokemon.
-			}
+	case DialogueAction::SendOutPokemon: {
+		size_t pokemonToken = trigger.endToken - 1;
+		std::string_view possiblePokemon = tokens[pokemonToken]; // The tokenizer has already removed the '!' at the end.
+		FuzzyMatch misread;
+		// Only the word after "SENT OUT" is the Pokemon, a later word that happens to be close to a species is not.
+		if (!GameData::pokemon.contains(possiblePokemon) && findMisreadName(pokemonToken, pokemonToken + 1, 1, 1, entityTypeMask(EntityType::Pokemon), misread)) {
+			possiblePokemon = GameData::pokemon.nameOf(misread.id); // "GEODUDF" for GEODUDE
+		}
+		if (!currentTrainer || !GameData::pokemon.contains(possiblePokemon)) return false;
+
+		int species = GameData::pokemon.find(possiblePokemon);
+		bool switchedBack = currentTrainer->isPokemonInActive(species);
+		currentTrainer->updateActiveSlot(species); // Details revealed from here on are this Pokemon's
+		recordEvent(BattleEventType::PokemonSentOut, species);
+		if (switchedBack) return false;
+		std::cout << "Pokemon found: " << possiblePokemon << " for trainer: " << currentTrainer->getTrainerName() << std::endl;
+		return true;
+	}
+
+	case DialogueAction::RevealDetail: {
+		// Moves, abilities and items named after the first word. Longer names win, as "SLUDGE BOMB" over "SLUDGE".
+		EntityMatcher::gameData().find(tokens, entities, 1);
+		const EntitySpan* revealed = nullptr;
+		for (const EntitySpan& entity : entities) {
+			if (entity.type == EntityType::Trainer || entity.type == EntityType::Pokemon) continue;
+			if (!revealed || entity.tokenCount > revealed->tokenCount) revealed = &entity;
 		}
+		if (revealed) {
+			std::cout << "Detected " << getEntityTypeName(revealed->type) << ": " << tokens.span(revealed->firstToken, revealed->tokenCount) << std::endl;
+			revealDetail(revealed->type, revealed->id);
+			return true;
+		}
+		FuzzyMatch misread;
+		unsigned revealedTypes = entityTypeMask(EntityType::Move) | entityTypeMask(EntityType::Ability) | entityTypeMask(EntityType::Item);
+		if (findMisreadName(1, tokens.size(), 1, 2, revealedTypes, misread)) {
+			std::cout << "Detected " << getEntityTypeName(misread.type) << ": " << getGameDataName(misread.type, misread.id)
+				<< " (read with " << misread.distance << " wrong characters)" << std::endl;
+			revealDetail(misread.type, misread.id);
+			return true;
+		}
+		//else if for when the trainer switches out a Pokemon.
+		return false;
+	}
+
+	case DialogueAction::FoeFainted: {
+		std::cout << "Foe Pokemon has fainted." << std::endl;
+		Pokemon* fainted = currentTrainer ? currentTrainer->getActivePokemon() : nullptr;
+		recordEvent(BattleEventType::FoeFainted, fainted ? fainted->species : Pokemon::NONE);
+		if (currentTrainer) currentTrainer->clearActiveSlot(); // Nothing is revealed for it until the next is sent out
+		return true;
+	}
+
+	case DialogueAction::WinStreak: // The user has defeated the streak of trainers, bringing them back to the entry point.
+		if (currentStreak >= 0) currentStreak++;
+		std::cout << "Streak completed, resetting state to 0." << std::endl;
+		recordEvent(BattleEventType::StreakWon, currentStreak);
+		if (eventLog) eventLog->flush();
+		return true;
+
+	case DialogueAction::LoseStreak:
+		currentStreak = 0;
+		std::cout << "Streak failed, resetting state to 0." << std::endl;
+		recordEvent(BattleEventType::StreakLost, 0);
+		if (eventLog) eventLog->flush();
+		return true;
+
+	case DialogueAction::DefeatTrainer: // The trainer has been defeated, and the streak continues.
+		std::cout << "Trainer defeated, resetting state to 1." << std::endl;
+		recordEvent(BattleEventType::TrainerDefeated, currentTrainer ? GameData::trainers.find(currentTrainer->getTrainerName()) : -1);
+		if (eventLog) eventLog->flush();
+		return true;
 	}
+	return false;
 }
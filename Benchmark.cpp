@@ -0,0 +1,1414 @@
+/*
+Benchmarks for the screen reading pipeline. Each one loads the screenshot corpus up front so that only the
+stage being measured is timed.
+*/
+
+#include "benchmark.h"
+#include "battleeventlog.h"
+#include "battlelogic.h"
+#include "blankdialoguedetector.h"
+#include "capturescheduler.h"
+#include "databaseinterface.h"
+#include "databasemigrations.h"
+#include "databasewriter.h"
+#include "dialoguelinestabilizer.h"
+#include "framepipeline.h"
+#include "framesource.h"
+#include "fuzzyentityindex.h"
+#include "gamedata.h"
+#include "glyphrecognizer.h"
+#include "imageprocessing.h"
+#include "knowledgesnapshot.h"
+#include "layoutprofile.h"
+#include "ocrbackend.h"
+#include "ocrenginepool.h"
+#include "stagetimer.h"
+#include "trainerknowledge.h"
+#include "streakreader.h"
+#include <cctype>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Set by the CMake build to git describe of the checkout. Other builds are told apart by when they were compiled.
+#ifndef POKEMONREADER_BUILD_ID
+#define POKEMONREADER_BUILD_ID "built " __DATE__ " " __TIME__
+#endif
+
+namespace {
+
+    const char* const PIPELINE_CSV_HEADER = "build,run_at,source,ocr,frames,frames_per_second,stage,count,mean_us,p50_us,p95_us,p99_us,max_us";
+
+    // A wall clock time in UTC as ISO 8601, e.g. 2024-05-01T18:30:00Z.
+    std::string formatUtc(std::time_t time) {
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &time);
+#else
+        gmtime_r(&time, &utc);
+#endif
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        return text;
+    }
+
+    std::vector<cv::Mat> loadCorpus(const std::string& corpusDir) {
+        std::vector<cv::String> paths;
+        cv::glob(corpusDir + "/*.png", paths);
+
+        std::vector<cv::Mat> frames;
+        for (const auto& path : paths) {
+            cv::Mat img = cv::imread(path);
+            if (img.empty()) {
+                std::cerr << "Error loading: " << path << std::endl;
+                continue;
+            }
+            frames.push_back(img);
+        }
+        std::cout << "Loaded " << frames.size() << " frames from " << corpusDir << std::endl;
+        return frames;
+    }
+
+    // The per-call engine setup analyzeImage() used before the pool, kept as the baseline to measure against.
+    std::string analyzeImageFreshEngine(const cv::Mat& image, const char* whitelist) {
+        std::string result;
+        tesseract::TessBaseAPI tess;
+        if (tess.Init(NULL, "eng", tesseract::OEM_LSTM_ONLY)) {
+            std::cerr << "Error intiializing tesseract" << std::endl;
+            return "";
+        }
+
+        tess.SetPageSegMode(tesseract::PSM_SINGLE_BLOCK);
+        tess.SetVariable("tessedit_char_whitelist", whitelist);
+        tess.SetImage(image.data, image.cols, image.rows, image.channels(), static_cast<int>(image.step));
+
+        char* text = tess.GetUTF8Text();
+        if (text) {
+            result = text;
+            delete[] text;
+        }
+        tess.End();
+        return result;
+    }
+
+    // The three pass OpenCV chain preprocessImage() used before the fused kernel, kept as the baseline to measure against.
+    cv::Mat preprocessImageOpenCv(const cv::Mat& input) {
+        cv::Mat gray, thresh;
+        cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+        cv::threshold(gray, thresh, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+        cv::resize(thresh, thresh, cv::Size(), 2, 2, cv::INTER_LINEAR);
+        return thresh;
+    }
+
+    std::string jsonEscape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    bool containsText(const std::string& text) {
+        for (unsigned char c : text) {
+            if (std::isalnum(c)) return true;
+        }
+        return false;
+    }
+
+    // Uppercase letters and digits only, so spacing and punctuation differences between engines do not count.
+    std::string normalizeForScoring(const std::string& text) {
+        std::string normalized;
+        for (unsigned char c : text) {
+            if (std::isalnum(c)) normalized += static_cast<char>(std::toupper(c));
+        }
+        return normalized;
+    }
+
+    size_t editDistance(const std::string& a, const std::string& b) {
+        std::vector<size_t> previous(b.size() + 1), current(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) previous[j] = j;
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                current[j] = std::min({ previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1) });
+            }
+            std::swap(previous, current);
+        }
+        return previous[b.size()];
+    }
+
+    // Rough heap use of an unordered_set<string>: the bucket array, one node per name and the text of names too long
+    // for the small string buffer.
+    size_t approximateHeapBytes(const std::unordered_set<std::string>& set) {
+        size_t bytes = set.bucket_count() * sizeof(void*) + set.size() * (sizeof(std::string) + 2 * sizeof(void*));
+        for (const auto& name : set) {
+            if (name.capacity() > std::string().capacity()) bytes += name.capacity() + 1;
+        }
+        return bytes;
+    }
+
+    const char* const SCRATCH_DB_PATH = "benchmark_db.sqlite";
+    const char* const SCRATCH_SNAPSHOT_PATH = "benchmark_knowledge.snapshot";
+    const char* const SCRATCH_EVENT_LOG_PATH = "benchmark_events.log";
+
+    // Removes the scratch database with its WAL files. The tables are made by the migrations when it is opened.
+    void removeScratchDatabase() {
+        for (const char* suffix : { "", "-wal", "-shm" }) std::remove((std::string(SCRATCH_DB_PATH) + suffix).c_str());
+    }
+
+    // Prepares, runs and finalizes a statement the way every DatabaseInterface method did before the statement cache,
+    // kept as the baseline to measure against. Returns the first column of the first row, or -1.
+    int runUncached(sqlite3* db, const char* query, int id, const std::string& text) {
+        int result = -1;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, id);
+            sqlite3_bind_text(stmt, 2, text.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW) result = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return result;
+    }
+
+    // The same sessions bulkIngest and trainerKnowledge write: each a trainer's team of three seen with four moves, an
+    // ability and an item. Trainers come round again across sessions.
+    std::vector<SightingRecord> generateSessions(int sessions) {
+        std::mt19937 random(13);
+        auto pick = [&random](const std::string_view* names, size_t count) {
+            return std::string(names[std::uniform_int_distribution<size_t>(0, count - 1)(random)]);
+        };
+        std::vector<SightingRecord> records;
+        for (int session = 0; session < sessions; ++session) {
+            std::string trainer(GameData::trainerNames[session % GameData::trainers.size()]);
+            for (int slot = 0; slot < 3; ++slot) {
+                std::string pokemon = pick(GameData::pokemonNames, GameData::pokemon.size());
+                records.push_back({ trainer, pokemon, SightingKind::Pokemon, "" });
+                for (int move = 0; move < 4; ++move) records.push_back({ trainer, pokemon, SightingKind::Move, pick(GameData::moveNames, GameData::moves.size()) });
+                records.push_back({ trainer, pokemon, SightingKind::Ability, pick(GameData::abilityNames, GameData::abilities.size()) });
+                records.push_back({ trainer, pokemon, SightingKind::Item, pick(GameData::itemNames, GameData::items.size()) });
+            }
+        }
+        return records;
+    }
+
+    // Battle Tower sets as the battle logic logs them: each trainer sends out three Pokemon, each revealing two moves
+    // and sometimes an ability or item before it faints, and every seventh win ends the set. One event a second.
+    std::vector<BattleEvent> generateBattleEvents(int battles) {
+        std::mt19937 random(29);
+        auto pick = [&random](size_t count) {
+            return std::uniform_int_distribution<int>(0, static_cast<int>(count) - 1)(random);
+        };
+        std::vector<BattleEvent> events;
+        uint32_t frame = 0;
+        auto add = [&events, &frame](BattleEventType type, int value) {
+            frame += 4;
+            events.push_back({ type, value, frame, frame * 0.25 });
+        };
+
+        add(BattleEventType::StreakDetected, 0);
+        for (int battle = 0; battle < battles; ++battle) {
+            int trainer = pick(GameData::trainers.size());
+            add(BattleEventType::TrainerFound, trainer);
+            for (int slot = 0; slot < 3; ++slot) {
+                int species = pick(GameData::pokemon.size());
+                add(BattleEventType::PokemonSentOut, species);
+                add(BattleEventType::MoveSeen, pick(GameData::moves.size()));
+                add(BattleEventType::MoveSeen, pick(GameData::moves.size()));
+                if (random() % 3 == 0) add(BattleEventType::AbilitySeen, pick(GameData::abilities.size()));
+                if (random() % 4 == 0) add(BattleEventType::ItemSeen, pick(GameData::items.size()));
+                add(BattleEventType::FoeFainted, species);
+            }
+            add(BattleEventType::TrainerDefeated, trainer);
+            if (battle % 7 == 6) add(BattleEventType::StreakWon, battle / 7 + 1);
+        }
+        return events;
+    }
+
+    // Prints how SQLite runs a query, one line per step of the plan.
+    void printQueryPlan(sqlite3* db, const char* query) {
+        std::cout << "  " << query << std::endl;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, (std::string("EXPLAIN QUERY PLAN ") + query).c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) std::cout << "    " << sqlite3_column_text(stmt, 3) << std::endl;
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    int countRows(sqlite3* db, const char* table) {
+        sqlite3_stmt* stmt;
+        int rows = -1;
+        if (sqlite3_prepare_v2(db, (std::string("SELECT COUNT(*) FROM ") + table).c_str(), -1, &stmt, nullptr) == SQLITE_OK
+            && sqlite3_step(stmt) == SQLITE_ROW) {
+            rows = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return rows;
+    }
+
+    // BattleLogic states through a Battle Tower streak, in seconds spent in each: entering the streak, then per battle
+    // the walk in and trainer intro, and three Pokemon each sent out and fought until they faint.
+    std::vector<std::pair<int, double>> battleTowerTimeline(double seconds) {
+        std::vector<std::pair<int, double>> timeline;
+        double total = 0;
+        auto add = [&](int state, double duration) {
+            timeline.push_back({ state, duration });
+            total += duration;
+        };
+        while (total < seconds) {
+            add(0, 90);
+            for (int battle = 0; battle < 7; ++battle) {
+                add(1, 25);
+                for (int pokemon = 0; pokemon < 3; ++pokemon) {
+                    add(2, 4);
+                    add(3, 45);
+                }
+            }
+        }
+        return timeline;
+    }
+
+    struct CaptureSimulation {
+        uint64_t frames = 0;
+        uint64_t missed = 0;
+        double rate = 0;
+        double framesByState[4] = {};
+    };
+
+    // Plays a timeline on a simulated clock, taking frameSeconds to read each frame. Scheduled capture waits for each
+    // deadline, the old loop slept a fixed interval after reading each frame.
+    CaptureSimulation simulateCapture(const std::vector<std::pair<int, double>>& timeline, double seconds, double frameSeconds,
+        CaptureScheduler* scheduler, double sleepInterval) {
+        using Clock = CaptureScheduler::Clock;
+        const Clock::time_point start;
+        auto at = [&start](double offset) {
+            return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(offset));
+        };
+
+        CaptureSimulation simulation;
+        size_t segment = 0;
+        double segmentEnd = timeline.empty() ? seconds : timeline[0].second;
+        double now = 0;
+        while (now < seconds) {
+            while (segment + 1 < timeline.size() && now >= segmentEnd) segmentEnd += timeline[++segment].second;
+            int state = timeline.empty() ? 0 : timeline[segment].first;
+            if (scheduler) {
+                now = std::chrono::duration<double>(scheduler->nextDeadline(state, at(now)) - start).count();
+                if (now >= seconds) break;
+            }
+            simulation.frames++;
+            simulation.framesByState[state >= 0 && state < 4 ? state : 0]++;
+            now += frameSeconds + (scheduler ? 0.0 : sleepInterval);
+        }
+        if (scheduler) {
+            simulation.missed = scheduler->getDeadlinesMissed();
+            simulation.rate = scheduler->getEffectiveRate();
+        }
+        else {
+            simulation.rate = simulation.frames / seconds;
+        }
+        return simulation;
+    }
+
+    // Pokemon as it was before it held GameData IDs, kept as the baseline for teamLayout: names in strings and getters
+    // that return copies.
+    class NamedPokemon {
+    private:
+        std::vector<std::string> seenMoves;
+        std::string name;
+        std::string seenAbility;
+        std::string seenItem;
+
+    public:
+        explicit NamedPokemon(const std::string& pokemonName = "") : name(pokemonName) {}
+        std::string getName() const { return name; }
+        std::vector<std::string> getSeenMoves() const { return seenMoves; }
+        std::string getSeenAbility() const { return seenAbility; }
+        std::string getSeenItem() const { return seenItem; }
+        void addMove(const std::string& move) { seenMoves.push_back(move); }
+        void setAbility(const std::string& ability) { seenAbility = ability; }
+        void setItem(const std::string& item) { seenItem = item; }
+    };
+
+    struct GameDataTotals {
+        double setNanos = 0;
+        double tableNanos = 0;
+        size_t lookups = 0;
+        size_t setBytes = 0;
+        size_t tableBytes = 0;
+    };
+
+    // Looks every name of a list up, then every name with its last letter changed as a misread would, in both the
+    // perfect hash table and an unordered_set of the same names.
+    template <typename Table>
+    void compareGameDataLookups(const char* label, const Table& table, const std::string_view* names,
+        const std::unordered_set<std::string>& set, int repetitions, GameDataTotals& totals) {
+        std::vector<std::string> queries;
+        for (size_t i = 0; i < table.size(); ++i) queries.emplace_back(names[i]);
+        for (size_t i = 0; i < table.size(); ++i) {
+            std::string miss(names[i]);
+            miss.back() = miss.back() == 'Q' ? 'X' : 'Q';
+            queries.push_back(miss);
+        }
+
+        auto nanosPerLookup = [&queries, repetitions](auto lookup) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                for (const auto& query : queries) lookup(query);
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() / (static_cast<double>(repetitions) * queries.size());
+        };
+        size_t setHits = 0, tableHits = 0;
+        double setNanos = nanosPerLookup([&set, &setHits](const std::string& query) { setHits += set.find(query) != set.end(); });
+        double tableNanos = nanosPerLookup([&table, &tableHits](const std::string& query) { tableHits += table.contains(query); });
+
+        size_t tableBytes = sizeof(table) + table.size() * sizeof(std::string_view);
+        for (size_t i = 0; i < table.size(); ++i) tableBytes += names[i].size() + 1;
+        size_t setBytes = approximateHeapBytes(set);
+
+        std::cout << std::setw(10) << label << ": " << table.size() << " names, unordered_set " << setNanos << " ns/lookup, ~"
+            << setBytes << " heap bytes; perfect hash " << tableNanos << " ns/lookup, " << tableBytes << " static bytes"
+            << (setHits == tableHits ? "" : " (HIT COUNTS DIFFER)") << std::endl;
+        totals.setNanos += setNanos * queries.size();
+        totals.tableNanos += tableNanos * queries.size();
+        totals.lookups += queries.size();
+        totals.setBytes += setBytes;
+        totals.tableBytes += tableBytes;
+    }
+
+    // Puts edits into a name like the ones Tesseract makes on the battle font: a glyph read as a similar one, a
+    // dropped character or a doubled one.
+    std::string addOcrNoise(std::string_view name, int edits, std::mt19937& random) {
+        static const char* const CONFUSIONS[][2] = {
+            { "O", "0" }, { "0", "O" }, { "I", "1" }, { "I", "L" }, { "L", "I" }, { "S", "5" }, { "B", "8" }, { "E", "F" },
+            { "F", "E" }, { "G", "6" }, { "Z", "2" }, { "U", "V" }, { "M", "N" }, { "N", "M" }, { "C", "G" }, { "D", "O" },
+            { "Q", "O" }, { "H", "N" }, { "A", "4" }, { "T", "7" }, { "R", "P" }, { "P", "R" }, { "K", "X" }, { "Y", "V" }
+        };
+        std::string noisy(name);
+        for (int edit = 0; edit < edits; ++edit) {
+            size_t position = std::uniform_int_distribution<size_t>(0, noisy.size() - 1)(random);
+            int kind = std::uniform_int_distribution<int>(0, 3)(random);
+            if (kind == 0 && noisy.size() > 1) {
+                noisy.erase(position, 1);
+            }
+            else if (kind == 1) {
+                noisy.insert(position, 1, noisy[position]);
+            }
+            else {
+                bool replaced = false;
+                for (const auto& confusion : CONFUSIONS) {
+                    if (noisy[position] == confusion[0][0]) {
+                        noisy[position] = confusion[1][0];
+                        replaced = true;
+                        break;
+                    }
+                }
+                if (!replaced) noisy[position] = static_cast<char>('A' + std::uniform_int_distribution<int>(0, 25)(random));
+            }
+        }
+        return noisy;
+    }
+
+    template <typename Func>
+    double framesPerSecond(const std::vector<cv::Mat>& frames, int passes, Func processFrame) {
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const auto& frame : frames) {
+                processFrame(frame);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() > 0 ? (frames.size() * passes) / elapsed.count() : 0.0;
+    }
+
+}
+
+void Benchmark::pipeline(const std::string& sourceSpec, const std::string& resultsPath, const std::string& atlasPath) {
+    std::unique_ptr<FrameSource> source = openFrameSource(sourceSpec);
+    if (!source) return;
+
+    BattleLogic battleLogic;
+    OcrEnginePool ocrPool;
+    ocrPool.warmUp();
+    TesseractBackend tesseractOcr(ocrPool);
+    GlyphAtlas glyphAtlas;
+    GlyphRecognizer glyphOcr(glyphAtlas);
+    OcrBackend* dialogueOcr = &tesseractOcr;
+    if (!atlasPath.empty()) {
+        if (!glyphAtlas.load(atlasPath)) return;
+        dialogueOcr = &glyphOcr;
+    }
+
+    LatencyRecorder recorder;
+    LatencyRecorder::install(&recorder);
+    FramePipeline pipeline(battleLogic, *dialogueOcr, 1, 8, false); // Every frame is measured, none are dropped
+    const std::string runAt = formatUtc(std::time(nullptr));
+    auto start = std::chrono::steady_clock::now();
+    pipeline.run([&source](cv::Mat& frame) {
+        ScopedStageTimer timer(PipelineStage::Decode);
+        return source->next(frame);
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    LatencyRecorder::install(nullptr);
+
+    const uint64_t frames = pipeline.getFramesCaptured();
+    const double framesPerSecond = elapsed.count() > 0 ? frames / elapsed.count() : 0.0;
+    std::cout << "Replayed " << frames << " frames from " << sourceSpec << " with " << dialogueOcr->getName() << " in "
+        << elapsed.count() << " s: " << framesPerSecond << " frames/sec" << std::endl;
+    std::cout << "Dialogue OCR calls: " << pipeline.getDialogueOcrPerformed() << ", lines handled: " << pipeline.getLinesEmitted() << std::endl;
+    std::cout << std::left << std::setw(16) << "stage" << std::right << std::setw(8) << "count" << std::setw(12) << "mean us"
+        << std::setw(12) << "p50 us" << std::setw(12) << "p95 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::endl;
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+        StageLatency latency = recorder.summarize(static_cast<PipelineStage>(i));
+        std::cout << std::left << std::setw(16) << getStageName(static_cast<PipelineStage>(i)) << std::right << std::setw(8) << latency.count
+            << std::fixed << std::setprecision(1) << std::setw(12) << latency.mean << std::setw(12) << latency.p50 << std::setw(12) << latency.p95
+            << std::setw(12) << latency.p99 << std::setw(12) << latency.max << std::defaultfloat << std::endl;
+    }
+
+    if (resultsPath.empty()) return;
+    const bool json = resultsPath.size() >= 5 && resultsPath.compare(resultsPath.size() - 5, 5, ".json") == 0;
+    std::string existingHeader;
+    std::ifstream existing(resultsPath);
+    const bool newFile = !existing.good() || !std::getline(existing, existingHeader);
+    existing.close();
+    if (!json && !newFile && existingHeader != PIPELINE_CSV_HEADER) {
+        std::cerr << "Benchmark results not written, " << resultsPath << " has columns from an older version. Use a new file." << std::endl;
+        return;
+    }
+    std::ofstream results(resultsPath, json ? std::ios::trunc : std::ios::app);
+    if (!results) {
+        std::cerr << "Error writing benchmark results: " << resultsPath << std::endl;
+        return;
+    }
+
+    if (json) {
+        results << "{\n  \"benchmark\": \"pipeline\",\n  \"build\": \"" << jsonEscape(POKEMONREADER_BUILD_ID) << "\",\n  \"runAt\": \"" << runAt
+            << "\",\n  \"source\": \"" << jsonEscape(sourceSpec) << "\",\n  \"ocr\": \"" << dialogueOcr->getName()
+            << "\",\n  \"frames\": " << frames << ",\n  \"seconds\": " << elapsed.count() << ",\n  \"framesPerSecond\": " << framesPerSecond
+            << ",\n  \"stages\": [";
+        for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+            StageLatency latency = recorder.summarize(static_cast<PipelineStage>(i));
+            results << (i > 0 ? "," : "") << "\n    { \"stage\": \"" << getStageName(static_cast<PipelineStage>(i)) << "\", \"count\": " << latency.count
+                << ", \"meanUs\": " << latency.mean << ", \"p50Us\": " << latency.p50 << ", \"p95Us\": " << latency.p95
+                << ", \"p99Us\": " << latency.p99 << ", \"maxUs\": " << latency.max << " }";
+        }
+        results << "\n  ]\n}\n";
+    }
+    else {
+        if (newFile) results << PIPELINE_CSV_HEADER << '\n';
+        for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+            StageLatency latency = recorder.summarize(static_cast<PipelineStage>(i));
+            results << POKEMONREADER_BUILD_ID << ',' << runAt << ',' << sourceSpec << ',' << dialogueOcr->getName() << ',' << frames << ',' << framesPerSecond << ','
+                << getStageName(static_cast<PipelineStage>(i)) << ',' << latency.count << ',' << latency.mean << ',' << latency.p50 << ','
+                << latency.p95 << ',' << latency.p99 << ',' << latency.max << '\n';
+        }
+    }
+    std::cout << "Results written to " << resultsPath << std::endl;
+}
+
+void Benchmark::ocrEnginePool(const std::string& corpusDir, int passes) {
+    std::vector<cv::Mat> frames = loadCorpus(corpusDir);
+    if (frames.empty()) return;
+
+    // Both runs OCR the streak crop and the dialogue crop of every frame, same as the capture loop.
+    double before = framesPerSecond(frames, passes, [](const cv::Mat& frame) {
+        analyzeImageFreshEngine(preprocessImage(cropToStreakCount(frame)), "0123456789");
+        analyzeImageFreshEngine(preprocessImage(cropToDialogue(frame)), "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.!?'(),- ");
+    });
+
+    OcrEnginePool ocrPool;
+    ocrPool.warmUp();
+    double after = framesPerSecond(frames, passes, [&ocrPool](const cv::Mat& frame) {
+        analyzeImage(preprocessImage(cropToStreakCount(frame)), ocrPool, OcrProfile::Streak);
+        analyzeImage(preprocessImage(cropToDialogue(frame)), ocrPool, OcrProfile::Dialogue);
+    });
+
+    std::cout << "OCR engine per crop: " << before << " frames/sec" << std::endl;
+    std::cout << "OCR engine pool:     " << after << " frames/sec" << std::endl;
+    if (before > 0) {
+        std::cout << "Speedup: " << after / before << "x" << std::endl;
+    }
+}
+
+void Benchmark::blankDetector(const std::string& corpusDir, int repetitions) {
+    std::vector<cv::Mat> frames = loadCorpus(corpusDir);
+    if (frames.empty()) return;
+
+    BlankDialogueDetector detector;
+    OcrEnginePool ocrPool;
+    ocrPool.warmUp();
+
+    // Positive means "blank", the case where OCR gets skipped. A false positive is a missed line of text.
+    int truePositive = 0, falsePositive = 0, trueNegative = 0, falseNegative = 0;
+    double totalMicros = 0;
+    for (const auto& frame : frames) {
+        cv::Mat dialogueCrop = cropToDialogue(frame);
+
+        bool predictedBlank = false;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            predictedBlank = !detector.hasText(dialogueCrop);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        totalMicros += elapsed.count() / repetitions;
+
+        bool actuallyBlank = !containsText(analyzeImage(preprocessImage(dialogueCrop), ocrPool));
+        if (predictedBlank && actuallyBlank) truePositive++;
+        else if (predictedBlank) falsePositive++;
+        else if (actuallyBlank) falseNegative++;
+        else trueNegative++;
+    }
+
+    std::cout << "Blank detector cost: " << totalMicros / frames.size() << " us/frame" << std::endl;
+    std::cout << "Blank and skipped: " << truePositive << ", text but skipped: " << falsePositive
+        << ", text and read: " << trueNegative << ", blank but read: " << falseNegative << std::endl;
+    if (truePositive + falsePositive > 0) {
+        std::cout << "Precision (skipped frames that were really blank): "
+            << static_cast<double>(truePositive) / (truePositive + falsePositive) << std::endl;
+    }
+    if (truePositive + falseNegative > 0) {
+        std::cout << "Recall (blank frames that were skipped): "
+            << static_cast<double>(truePositive) / (truePositive + falseNegative) << std::endl;
+    }
+}
+
+void Benchmark::preprocessKernel(const std::string& corpusDir, int repetitions) {
+    std::vector<cv::Mat> frames = loadCorpus(corpusDir);
+    if (frames.empty()) return;
+
+    std::vector<cv::Mat> crops;
+    for (const auto& frame : frames) crops.push_back(cropToDialogue(frame));
+    std::cout << "Dialogue crop: " << crops[0].cols << "x" << crops[0].rows << std::endl;
+
+    auto microsPerCrop = [&crops, repetitions](auto preprocess) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            for (const auto& crop : crops) preprocess(crop);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(repetitions) * crops.size());
+    };
+
+    cv::Mat output;
+    TextColorKey key;
+    double chain = microsPerCrop([](const cv::Mat& crop) { preprocessImageOpenCv(crop); });
+    double fused = microsPerCrop([&output](const cv::Mat& crop) { preprocessImageInto(crop, output); });
+    double keyed = microsPerCrop([&output, &key](const cv::Mat& crop) { preprocessImageInto(crop, output, key); });
+
+    size_t mismatched = 0, total = 0;
+    int maxDifference = 0;
+    for (const auto& crop : crops) {
+        cv::Mat expected = preprocessImageOpenCv(crop);
+        preprocessImageInto(crop, output);
+        for (int y = 0; y < expected.rows; ++y) {
+            const uchar* expectedRow = expected.ptr<uchar>(y);
+            const uchar* outputRow = output.ptr<uchar>(y);
+            for (int x = 0; x < expected.cols; ++x) {
+                int difference = std::abs(expectedRow[x] - outputRow[x]);
+                mismatched += difference != 0;
+                maxDifference = std::max(maxDifference, difference);
+            }
+        }
+        total += expected.total();
+    }
+
+    std::cout << "OpenCV chain:        " << chain << " us/crop" << std::endl;
+    std::cout << "Fused kernel:        " << fused << " us/crop (" << chain / fused << "x)" << std::endl;
+    std::cout << "Fused, colour keyed: " << keyed << " us/crop (" << chain / keyed << "x)" << std::endl;
+    std::cout << "Pixels differing from the chain: " << mismatched << " of " << total << ", max difference " << maxDifference << std::endl;
+}
+
+void Benchmark::nativeScale(const std::string& corpusDir, int multiple, int repetitions) {
+    std::vector<cv::Mat> frames = loadCorpus(corpusDir);
+    if (frames.empty()) return;
+
+    const LayoutProfile& captureLayout = defaultLayoutProfile();
+    const LayoutProfile nativeLayout = captureLayout.scaledToNative(multiple);
+    BlankDialogueDetector detector;
+    StreakReader streakReader;
+
+    // Everything the preprocess stage does to a frame, minus the change detector which would skip repeats.
+    auto prepareFrame = [&detector, &streakReader](const cv::Mat& frame, const LayoutProfile& layout) {
+        cv::Mat dialogueCrop = cropToDialogue(frame, layout);
+        if (detector.hasText(dialogueCrop)) preprocessImage(dialogueCrop);
+        streakReader.read(frame, "50", layout);
+        return dialogueCrop.total();
+    };
+
+    size_t capturePixels = 0, nativePixels = 0;
+    cv::Mat nativeFrame;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        for (const auto& frame : frames) capturePixels += prepareFrame(frame, captureLayout);
+    }
+    std::chrono::duration<double, std::milli> captureElapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        for (const auto& frame : frames) {
+            downscaleToNative(frame, captureLayout, multiple, nativeFrame);
+            nativePixels += prepareFrame(nativeFrame, nativeLayout);
+        }
+    }
+    std::chrono::duration<double, std::milli> nativeElapsed = std::chrono::steady_clock::now() - start;
+
+    const double runs = static_cast<double>(repetitions) * frames.size();
+    std::cout << "Capture resolution: " << captureElapsed.count() / runs << " ms/frame, "
+        << capturePixels / runs << " dialogue pixels" << std::endl;
+    std::cout << multiple << "x native (" << LayoutProfile::NATIVE_WIDTH * multiple << "x" << LayoutProfile::NATIVE_HEIGHT * multiple
+        << "): " << nativeElapsed.count() / runs << " ms/frame including the downscale, " << nativePixels / runs << " dialogue pixels" << std::endl;
+    if (nativeElapsed.count() > 0) {
+        std::cout << "Speedup: " << captureElapsed.count() / nativeElapsed.count() << "x" << std::endl;
+    }
+}
+
+void Benchmark::glyphRecognizer(const std::string& corpusDir, const std::string& atlasPath, int repetitions) {
+    std::vector<DialogueLabel> labels = readDialogueLabels(corpusDir + "/labels.txt");
+    GlyphAtlas atlas;
+    if (labels.empty() || !atlas.load(atlasPath)) return;
+
+    OcrEnginePool ocrPool;
+    ocrPool.warmUp();
+    TesseractBackend tesseractOcr(ocrPool);
+    GlyphRecognizer glyphOcr(atlas);
+
+    for (OcrBackend* backend : { static_cast<OcrBackend*>(&tesseractOcr), static_cast<OcrBackend*>(&glyphOcr) }) {
+        double totalMillis = 0;
+        size_t totalErrors = 0, totalCharacters = 0;
+        size_t frames = 0;
+        for (const auto& label : labels) {
+            cv::Mat img = cv::imread(label.imagePath);
+            if (img.empty()) continue;
+            cv::Mat preprocessed = preprocessImage(cropToDialogue(img));
+
+            std::string text;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repetitions; ++i) {
+                text = backend->recognize(preprocessed);
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            totalMillis += elapsed.count() / repetitions;
+
+            std::string expected;
+            for (const auto& line : label.lines) expected += line;
+            expected = normalizeForScoring(expected);
+            totalErrors += editDistance(normalizeForScoring(text), expected);
+            totalCharacters += expected.size();
+            frames++;
+        }
+        if (frames == 0) return;
+
+        double accuracy = totalCharacters > 0 ? 1.0 - static_cast<double>(totalErrors) / totalCharacters : 0.0;
+        std::cout << backend->getName() << ": " << totalMillis / frames << " ms/box, character accuracy "
+            << std::max(0.0, accuracy) * 100 << "%" << std::endl;
+    }
+}
+
+void Benchmark::fuzzyIndex(int samples) {
+    auto start = std::chrono::steady_clock::now();
+    const FuzzyEntityIndex& index = FuzzyEntityIndex::gameData();
+    std::chrono::duration<double, std::milli> buildTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Index built in " << buildTime.count() << " ms, " << index.getPostingCount() << " deletion variants" << std::endl;
+
+    struct Name {
+        EntityType type;
+        int id;
+        std::string_view text;
+    };
+    std::vector<Name> names;
+    forEachGameDataName([&names](EntityType type, int id, std::string_view text) {
+        if (FuzzyEntityIndex::maxDistanceFor(text.size()) > 0) names.push_back({ type, id, text });
+    });
+
+    // As many edits as the name's length allows, so every sample is recoverable in principle.
+    std::mt19937 random(7);
+    std::vector<std::string> noisy;
+    std::vector<const Name*> expected;
+    for (int i = 0; i < samples; ++i) {
+        const Name& name = names[std::uniform_int_distribution<size_t>(0, names.size() - 1)(random)];
+        int edits = std::uniform_int_distribution<int>(1, FuzzyEntityIndex::maxDistanceFor(name.text.size()))(random);
+        noisy.push_back(addOcrNoise(name.text, edits, random));
+        expected.push_back(&name);
+    }
+
+    size_t exactHits = 0, correct = 0, wrong = 0, missed = 0, confident = 0;
+    FuzzyMatch match;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < noisy.size(); ++i) {
+        if (!index.lookup(noisy[i], match)) {
+            missed++;
+            continue;
+        }
+        if (match.type == expected[i]->type && match.id == expected[i]->id) {
+            correct++;
+            confident += match.confidence >= 0.8f;
+        }
+        else {
+            wrong++;
+        }
+    }
+    std::chrono::duration<double> lookupTime = std::chrono::steady_clock::now() - start;
+    for (size_t i = 0; i < noisy.size(); ++i) exactHits += getGameDataName(expected[i]->type, expected[i]->id) == noisy[i];
+
+    // Words from the battle dialogue that are not names and should stay unresolved.
+    const char* const dialogueWords[] = { "YOU", "WILL", "BE", "FACING", "OPPONENT", "ARE", "READY", "WOULD", "LIKE", "TO",
+        "BATTLE", "FOE", "USED", "SENT", "OUT", "FAINTED", "WE", "RESTORE", "YOUR", "POKEMON", "CONGRATULATIONS", "HAVE",
+        "BEEN", "DEFEATED", "THE", "IT'S", "SUPER", "EFFECTIVE", "NOT", "VERY", "MISSED", "GO", "WHAT", "WILL", "DO",
+        "CRITICAL", "HIT", "ATTACK", "FELL", "ROSE", "SHARPLY", "CHALLENGED", "BY", "THAT", "WAS", "TOO", "BAD" };
+    size_t wordCount = 0, resolvedWords = 0, confidentWords = 0;
+    for (const char* word : dialogueWords) {
+        wordCount++;
+        if (index.lookup(word, match) && match.distance > 0) {
+            resolvedWords++;
+            confidentWords += match.confidence >= 0.8f;
+        }
+    }
+
+    std::cout << "Lookups: " << noisy.size() / lookupTime.count() << "/s (" << lookupTime.count() * 1e6 / noisy.size() << " us each)" << std::endl;
+    std::cout << "Noisy names: " << noisy.size() << ", exact lookup finds " << exactHits << ", fuzzy finds " << correct
+        << " (" << 100.0 * correct / noisy.size() << "% recall, " << confident << " at confidence >= 0.8), wrong " << wrong
+        << ", missed " << missed << std::endl;
+    std::cout << "Dialogue words resolved to a name: " << resolvedWords << " of " << wordCount << ", " << confidentWords
+        << " at confidence >= 0.8" << std::endl;
+}
+
+void Benchmark::databaseInserts(int trainers) {
+    // A team of three per trainer, each with four moves, an ability and an item, as persistTrainerData writes them.
+    struct Sighting {
+        std::string pokemon;
+        std::string moves[4];
+        std::string ability;
+        std::string item;
+    };
+    std::mt19937 random(11);
+    auto pick = [&random](const std::string_view* names, size_t count) {
+        return std::string(names[std::uniform_int_distribution<size_t>(0, count - 1)(random)]);
+    };
+    std::vector<Sighting> team(3 * static_cast<size_t>(trainers));
+    for (Sighting& sighting : team) {
+        sighting.pokemon = pick(GameData::pokemonNames, GameData::pokemon.size());
+        for (std::string& move : sighting.moves) move = pick(GameData::moveNames, GameData::moves.size());
+        sighting.ability = pick(GameData::abilityNames, GameData::abilities.size());
+        sighting.item = pick(GameData::itemNames, GameData::items.size());
+    }
+    const size_t statementsPerSighting = 8;
+
+    // Each run gets a fresh scratch database without fsync, so the time is spent in SQLite rather than the disk.
+    auto insertsPerSecond = [&](auto insertSighting) {
+        removeScratchDatabase();
+        if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return 0.0;
+        sqlite3* db = DatabaseInterface::getDB();
+        sqlite3_exec(db, "PRAGMA synchronous = OFF;", nullptr, nullptr, nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int trainer = 0; trainer < trainers; ++trainer) {
+            sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+            for (size_t slot = 0; slot < 3; ++slot) insertSighting(db, trainer, team[3 * trainer + slot]);
+            sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        DatabaseInterface::closeDB();
+        removeScratchDatabase();
+        return team.size() * statementsPerSighting / elapsed.count();
+    };
+
+    double before = insertsPerSecond([](sqlite3* db, int trainer, const Sighting& sighting) {
+        runUncached(db, "INSERT OR IGNORE INTO Pokemon (trainer_id, name) VALUES (?, ?);", trainer, sighting.pokemon);
+        int pokemonID = runUncached(db, "SELECT pokemon_id FROM Pokemon WHERE trainer_id = ? AND name = ?;", trainer, sighting.pokemon);
+        for (const std::string& move : sighting.moves) runUncached(db, "INSERT OR IGNORE INTO SeenMoves (pokemon_id, move) VALUES (?, ?);", pokemonID, move);
+        runUncached(db, "INSERT OR IGNORE INTO SeenAbilities (pokemon_id, ability) VALUES (?, ?);", pokemonID, sighting.ability);
+        runUncached(db, "INSERT OR IGNORE INTO SeenItems (pokemon_id, item) VALUES (?, ?);", pokemonID, sighting.item);
+    });
+    double after = insertsPerSecond([](sqlite3*, int trainer, const Sighting& sighting) {
+        DatabaseInterface::insertOrIgnorePokemon(trainer, sighting.pokemon);
+        int pokemonID = DatabaseInterface::getPokemonID(trainer, sighting.pokemon);
+        for (const std::string& move : sighting.moves) DatabaseInterface::addSeenMove(pokemonID, move);
+        DatabaseInterface::addSeenAbility(pokemonID, sighting.ability);
+        DatabaseInterface::addSeenItem(pokemonID, sighting.item);
+    });
+
+    std::cout << "Trainers: " << trainers << ", statements: " << team.size() * statementsPerSighting << std::endl;
+    std::cout << "Prepared per call: " << before << " statements/s" << std::endl;
+    std::cout << "Statement cache:   " << after << " statements/s" << std::endl;
+    if (before > 0) {
+        std::cout << "Speedup: " << after / before << "x" << std::endl;
+    }
+}
+
+void Benchmark::bulkIngest(int sessions, int batches) {
+    // Later batches also hit rows that are already there, as trainers come round again.
+    std::vector<SightingRecord> records = generateSessions(sessions);
+
+    removeScratchDatabase();
+    if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return;
+
+    size_t perBatch = (records.size() + batches - 1) / batches;
+    std::vector<std::vector<SightingRecord>> batchRecords;
+    for (size_t first = 0; first < records.size(); first += perBatch) {
+        batchRecords.emplace_back(records.begin() + first, records.begin() + std::min(records.size(), first + perBatch));
+    }
+
+    IngestCounts added;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& batch : batchRecords) {
+        if (!DatabaseInterface::ingestSightings(batch, added)) break;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    DatabaseInterface::closeDB();
+    removeScratchDatabase();
+
+    std::cout << "Records: " << records.size() << " in " << batches << " batches, " << elapsed.count() << " s ("
+        << records.size() / elapsed.count() << " records/s)" << std::endl;
+    std::cout << "Added " << added.trainers << " trainers, " << added.pokemon << " Pokemon, " << added.sightings << " sightings" << std::endl;
+}
+
+void Benchmark::trainerKnowledge(int sessions) {
+    removeScratchDatabase();
+    if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return;
+    sqlite3* db = DatabaseInterface::getDB();
+    IngestCounts added;
+    DatabaseInterface::ingestSightings(generateSessions(sessions), added);
+
+    auto start = std::chrono::steady_clock::now();
+    DatabaseInterface::preloadKnowledge();
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+    const TrainerKnowledge& knowledge = TrainerKnowledge::shared();
+    std::cout << "Loaded " << knowledge.getTrainerCount() << " trainers and " << knowledge.getPokemonCount() << " Pokemon in "
+        << loadTime.count() << " ms" << std::endl;
+
+    // The report for every trainer, from memory and by a query for the team and one per Pokemon and Seen table.
+    std::vector<std::string> names;
+    for (size_t id = 0; id < GameData::trainers.size(); ++id) {
+        if (knowledge.findTrainerID(GameData::trainers.nameOf(static_cast<int>(id))) >= 0) names.emplace_back(GameData::trainers.nameOf(static_cast<int>(id)));
+    }
+    if (names.empty()) return;
+
+    TrainerHistory history;
+    size_t cachedDetails = 0;
+    start = std::chrono::steady_clock::now();
+    for (const std::string& name : names) {
+        knowledge.getHistory(name, history);
+        for (const PokemonHistory& pokemon : history.pokemon) cachedDetails += pokemon.moves.size() + pokemon.abilities.size() + pokemon.items.size();
+    }
+    std::chrono::duration<double, std::micro> cachedTime = std::chrono::steady_clock::now() - start;
+
+    sqlite3_stmt* team;
+    sqlite3_stmt* seen[3];
+    sqlite3_prepare_v2(db, "SELECT pokemon_id FROM Pokemon WHERE trainer_id = ?;", -1, &team, nullptr);
+    sqlite3_prepare_v2(db, "SELECT move FROM SeenMoves WHERE pokemon_id = ?;", -1, &seen[0], nullptr);
+    sqlite3_prepare_v2(db, "SELECT ability FROM SeenAbilities WHERE pokemon_id = ?;", -1, &seen[1], nullptr);
+    sqlite3_prepare_v2(db, "SELECT item FROM SeenItems WHERE pokemon_id = ?;", -1, &seen[2], nullptr);
+    size_t queriedDetails = 0;
+    start = std::chrono::steady_clock::now();
+    for (const std::string& name : names) {
+        sqlite3_bind_int(team, 1, knowledge.findTrainerID(name));
+        while (sqlite3_step(team) == SQLITE_ROW) {
+            for (sqlite3_stmt* details : seen) {
+                sqlite3_bind_int(details, 1, sqlite3_column_int(team, 0));
+                while (sqlite3_step(details) == SQLITE_ROW) queriedDetails++;
+                sqlite3_reset(details);
+            }
+        }
+        sqlite3_reset(team);
+    }
+    std::chrono::duration<double, std::micro> queriedTime = std::chrono::steady_clock::now() - start;
+    sqlite3_finalize(team);
+    for (sqlite3_stmt* details : seen) sqlite3_finalize(details);
+    DatabaseInterface::closeDB();
+    removeScratchDatabase();
+
+    std::cout << "Report per trainer from memory: " << cachedTime.count() / names.size() << " us (" << cachedDetails << " details)" << std::endl;
+    std::cout << "Report per trainer by query:    " << queriedTime.count() / names.size() << " us (" << queriedDetails << " details)" << std::endl;
+}
+
+void Benchmark::databaseSchema(int sessions) {
+    // A database as the first schema left it: every battle added its team again, placeholder slots included.
+    removeScratchDatabase();
+    sqlite3* db;
+    if (sqlite3_open(SCRATCH_DB_PATH, &db) != SQLITE_OK || !migrateDatabase(db, 1)) {
+        sqlite3_close(db);
+        return;
+    }
+    std::vector<SightingRecord> records = generateSessions(sessions);
+    sqlite3_stmt* addTrainer;
+    sqlite3_stmt* addPokemon;
+    sqlite3_stmt* addMove;
+    sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO Trainers(trainer_id, name) VALUES (?, ?);", -1, &addTrainer, nullptr);
+    sqlite3_prepare_v2(db, "INSERT INTO Pokemon(trainer_id, name) VALUES (?, ?);", -1, &addPokemon, nullptr);
+    sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO SeenMoves(pokemon_id, move) VALUES (?, ?);", -1, &addMove, nullptr);
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    std::vector<std::pair<int, std::string>> lookups;
+    for (const SightingRecord& record : records) {
+        int trainerID = GameData::trainers.find(record.trainer) + 1;
+        if (record.kind == SightingKind::Pokemon) {
+            sqlite3_bind_int(addTrainer, 1, trainerID);
+            sqlite3_bind_text(addTrainer, 2, record.trainer.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(addTrainer);
+            sqlite3_reset(addTrainer);
+            for (const std::string& name : { record.pokemon, std::string() }) {
+                sqlite3_bind_int(addPokemon, 1, trainerID);
+                sqlite3_bind_text(addPokemon, 2, name.c_str(), -1, SQLITE_STATIC);
+                sqlite3_step(addPokemon);
+                sqlite3_reset(addPokemon);
+            }
+            lookups.push_back({ trainerID, record.pokemon });
+        }
+        else if (record.kind == SightingKind::Move) {
+            sqlite3_bind_int64(addMove, 1, sqlite3_last_insert_rowid(db) - 1);
+            sqlite3_bind_text(addMove, 2, record.detail.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(addMove);
+            sqlite3_reset(addMove);
+        }
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_finalize(addTrainer);
+    sqlite3_finalize(addPokemon);
+    sqlite3_finalize(addMove);
+
+    // The lookups getOrCreateTrainer, getPokemonID and getSeenMoves make, at each schema version.
+    const char* const trainerQuery = "SELECT trainer_id FROM Trainers WHERE name = ?;";
+    const char* const pokemonQuery = "SELECT pokemon_id FROM Pokemon WHERE trainer_id = ? AND name = ?;";
+    const char* const movesQuery = "SELECT move FROM SeenMoves WHERE pokemon_id = ?;";
+    auto report = [&]() {
+        std::cout << "Schema version " << getSchemaVersion(db) << ": " << countRows(db, "Pokemon") << " Pokemon, "
+            << countRows(db, "SeenMoves") << " seen moves" << std::endl;
+        for (const char* query : { trainerQuery, pokemonQuery, movesQuery }) printQueryPlan(db, query);
+
+        sqlite3_stmt* stmt;
+        sqlite3_prepare_v2(db, pokemonQuery, -1, &stmt, nullptr);
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& lookup : lookups) {
+            sqlite3_bind_int(stmt, 1, lookup.first);
+            sqlite3_bind_text(stmt, 2, lookup.second.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        sqlite3_finalize(stmt);
+        std::cout << "  Pokemon ID lookup: " << elapsed.count() / lookups.size() << " us" << std::endl;
+    };
+
+    report();
+    auto start = std::chrono::steady_clock::now();
+    migrateDatabase(db);
+    std::chrono::duration<double, std::milli> migrationTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Migrated in " << migrationTime.count() << " ms" << std::endl;
+    report();
+    sqlite3_close(db);
+    removeScratchDatabase();
+}
+
+void Benchmark::databaseConcurrency(int seconds, int readerThreads) {
+    removeScratchDatabase();
+    if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return;
+    IngestCounts added;
+    DatabaseInterface::ingestSightings(generateSessions(2000), added);
+    int pokemonCount = countRows(DatabaseInterface::getDB(), "Pokemon");
+
+    // One thread saves a battle per transaction, as the database writer does, while the others make index lookups:
+    // first through the shared writer connection, which waits for its lock, then each on a connection from the read pool.
+    for (bool pooled : { false, true }) {
+        std::atomic<bool> stop(false);
+        std::atomic<uint64_t> reads(0), writes(0);
+        std::thread writer([&]() {
+            std::mt19937 random(17);
+            while (!stop) {
+                TrainerSnapshot snapshot;
+                snapshot.trainerName = GameData::trainerNames[std::uniform_int_distribution<size_t>(0, GameData::trainers.size() - 1)(random)];
+                snapshot.activeTeam[0].species = static_cast<int16_t>(std::uniform_int_distribution<int>(0, static_cast<int>(GameData::pokemon.size()) - 1)(random));
+                DatabaseInterface::persistTrainerSnapshots({ snapshot });
+                writes++;
+            }
+        });
+        std::vector<std::thread> readersRunning;
+        for (int i = 0; i < readerThreads; ++i) {
+            readersRunning.emplace_back([&, i]() {
+                std::mt19937 random(19 + i);
+                std::uniform_int_distribution<int> pokemonID(1, pokemonCount);
+                ReadConnection reader = pooled ? DatabaseInterface::openReader() : ReadConnection(nullptr, 0);
+                sqlite3_stmt* stmt = nullptr;
+                if (pooled) sqlite3_prepare_v2(reader.get(), "SELECT move FROM SeenMoves WHERE pokemon_id = ?;", -1, &stmt, nullptr);
+                while (!stop) {
+                    if (pooled) {
+                        sqlite3_bind_int(stmt, 1, pokemonID(random));
+                        while (sqlite3_step(stmt) == SQLITE_ROW) {}
+                        sqlite3_reset(stmt);
+                    }
+                    else {
+                        DatabaseInterface::getPokemonID(1 + pokemonID(random) % static_cast<int>(GameData::trainers.size()), "ABRA");
+                    }
+                    reads++;
+                }
+                sqlite3_finalize(stmt);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        writer.join();
+        for (auto& thread : readersRunning) thread.join();
+        std::cout << (pooled ? "Read pool:         " : "Shared connection: ") << reads / static_cast<double>(seconds) << " reads/s, "
+            << writes / static_cast<double>(seconds) << " battles saved/s" << std::endl;
+    }
+    DatabaseInterface::closeDB();
+    removeScratchDatabase();
+}
+
+void Benchmark::knowledgeSnapshot(int sessions, int repetitions) {
+    removeScratchDatabase();
+    std::remove(SCRATCH_SNAPSHOT_PATH);
+    if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return;
+    int laterSessions = sessions / 10 + 1;
+    std::vector<SightingRecord> records = generateSessions(sessions + laterSessions);
+    auto later = records.end() - records.size() / (sessions + laterSessions) * laterSessions; // Every session is the same size
+    IngestCounts added;
+    DatabaseInterface::ingestSightings(std::vector<SightingRecord>(records.begin(), later), added);
+
+    {
+        ReadConnection reader = DatabaseInterface::openReader();
+        auto start = std::chrono::steady_clock::now();
+        bool exported = KnowledgeSnapshot::exportFrom(reader.get(), SCRATCH_SNAPSHOT_PATH);
+        std::chrono::duration<double, std::milli> exportTime = std::chrono::steady_clock::now() - start;
+        std::ifstream file(SCRATCH_SNAPSHOT_PATH, std::ios::binary | std::ios::ate);
+        if (!exported || !file) return;
+        std::cout << "Exported " << file.tellg() << " bytes in " << exportTime.count() << " ms" << std::endl;
+
+        // Startup: mapping the snapshot against the queries TrainerKnowledge::load makes, and filling the cache from each.
+        KnowledgeSnapshot snapshot;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) snapshot.open(SCRATCH_SNAPSHOT_PATH);
+        std::chrono::duration<double, std::micro> openTime = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        TrainerKnowledge::shared().load(reader.get());
+        std::chrono::duration<double, std::milli> queryLoadTime = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        TrainerKnowledge::shared().load(snapshot);
+        std::chrono::duration<double, std::milli> snapshotLoadTime = std::chrono::steady_clock::now() - start;
+        std::cout << "Open and check: " << openTime.count() / repetitions << " us; " << snapshot.getTrainerCount() << " trainers and "
+            << snapshot.getPokemonCount() << " Pokemon ready for lookups" << std::endl;
+        std::cout << "Knowledge cache loaded by query: " << queryLoadTime.count() << " ms, from the snapshot: " << snapshotLoadTime.count()
+            << " ms (" << TrainerKnowledge::shared().getPokemonCount() << " Pokemon)" << std::endl;
+
+        // Every trainer's scouting report read straight from the mapping.
+        size_t details = 0;
+        int reports = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            for (size_t id = 0; id < GameData::trainers.size(); ++id) {
+                int trainer = snapshot.findTrainer(GameData::trainers.nameOf(static_cast<int>(id)));
+                if (trainer == KnowledgeSnapshot::NOT_FOUND) continue;
+                KnowledgeSnapshot::Team team = snapshot.getTeam(trainer);
+                for (int pokemon = team.first; pokemon < team.first + team.count; ++pokemon) {
+                    for (EntityType type : { EntityType::Move, EntityType::Ability, EntityType::Item }) {
+                        for (int seen = 0; seen < snapshot.getSeenCount(pokemon, type); ++seen) details += !snapshot.getSeen(pokemon, type, seen).empty();
+                    }
+                }
+                reports++;
+            }
+        }
+        std::chrono::duration<double, std::micro> reportTime = std::chrono::steady_clock::now() - start;
+        if (reports > 0) std::cout << "Report per trainer from the snapshot: " << reportTime.count() / reports << " us (" << details / repetitions << " details)" << std::endl;
+    }
+
+    // Regeneration: a check against the unchanged database, then after the later sessions are added.
+    bool rewritten = false;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) DatabaseInterface::refreshSnapshot(SCRATCH_SNAPSHOT_PATH, &rewritten);
+    std::chrono::duration<double, std::micro> checkTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Refresh of a current snapshot: " << checkTime.count() / repetitions << " us, rewritten: " << (rewritten ? "yes" : "no") << std::endl;
+    DatabaseInterface::ingestSightings(std::vector<SightingRecord>(later, records.end()), added);
+    start = std::chrono::steady_clock::now();
+    DatabaseInterface::refreshSnapshot(SCRATCH_SNAPSHOT_PATH, &rewritten);
+    std::chrono::duration<double, std::milli> regenerateTime = std::chrono::steady_clock::now() - start;
+    KnowledgeSnapshot snapshot;
+    snapshot.open(SCRATCH_SNAPSHOT_PATH);
+    std::cout << "Refresh after " << laterSessions << " more sessions: " << regenerateTime.count() << " ms, rewritten: " << (rewritten ? "yes" : "no")
+        << ", " << snapshot.getPokemonCount() << " Pokemon" << std::endl;
+
+    snapshot.close();
+    DatabaseInterface::closeDB();
+    removeScratchDatabase();
+    std::remove(SCRATCH_SNAPSHOT_PATH);
+}
+
+void Benchmark::teamLayout(int battles) {
+    // What OCR hands over in a battle: three Pokemon sent out, each revealing four moves, an ability and an item.
+    struct Reveal {
+        std::string pokemon;
+        std::string moves[Pokemon::MAX_MOVES];
+        std::string ability;
+        std::string item;
+    };
+    std::mt19937 random(23);
+    auto pick = [&random](const std::string_view* names, size_t count) {
+        return std::string(names[std::uniform_int_distribution<size_t>(0, count - 1)(random)]);
+    };
+    const size_t distinctBattles = 1000;
+    std::vector<Reveal> reveals(TEAM_SIZE * distinctBattles);
+    for (Reveal& reveal : reveals) {
+        reveal.pokemon = pick(GameData::pokemonNames, GameData::pokemon.size());
+        for (std::string& move : reveal.moves) move = pick(GameData::moveNames, GameData::moves.size());
+        reveal.ability = pick(GameData::abilityNames, GameData::abilities.size());
+        reveal.item = pick(GameData::itemNames, GameData::items.size());
+    }
+
+    // Per battle: the send out checks against the team, the reveals recorded, the team read the way writeTrainerData
+    // reads it and copied into a queued snapshot. Queued snapshots are dropped every distinctBattles.
+    size_t touched = 0;
+    auto battlesPerSecond = [&](auto playBattle) {
+        auto start = std::chrono::steady_clock::now();
+        for (int battle = 0; battle < battles; ++battle) touched += playBattle(&reveals[TEAM_SIZE * (battle % distinctBattles)], battle % distinctBattles == 0);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return battles / elapsed.count();
+    };
+
+    std::vector<std::vector<NamedPokemon>> namedQueue;
+    double before = battlesPerSecond([&namedQueue](const Reveal* battle, bool drain) {
+        if (drain) namedQueue.clear();
+        std::vector<NamedPokemon> team;
+        for (size_t slot = 0; slot < TEAM_SIZE; ++slot) {
+            const Reveal& reveal = battle[slot];
+            bool active = false;
+            for (const NamedPokemon& p : team) active = active || p.getName() == reveal.pokemon;
+            if (active) continue;
+            NamedPokemon& p = team.emplace_back(reveal.pokemon);
+            for (const std::string& move : reveal.moves) p.addMove(move);
+            p.setAbility(reveal.ability);
+            p.setItem(reveal.item);
+        }
+        size_t details = 0;
+        for (const NamedPokemon& p : team) details += p.getName().size() + p.getSeenMoves().size() + !p.getSeenAbility().empty() + !p.getSeenItem().empty();
+        namedQueue.push_back(team);
+        return details;
+    });
+
+    std::vector<TrainerSnapshot> queue;
+    double after = battlesPerSecond([&queue](const Reveal* battle, bool drain) {
+        if (drain) queue.clear();
+        Team team;
+        for (size_t slot = 0; slot < TEAM_SIZE; ++slot) {
+            const Reveal& reveal = battle[slot];
+            int species = GameData::pokemon.find(reveal.pokemon);
+            bool active = false;
+            for (const Pokemon& p : team) active = active || (!p.isEmpty() && p.species == species);
+            if (active) continue;
+            Pokemon& p = team[slot];
+            p.species = static_cast<int16_t>(species);
+            for (const std::string& move : reveal.moves) p.addMove(GameData::moves.find(move));
+            p.ability = static_cast<int16_t>(GameData::abilities.find(reveal.ability));
+            p.item = static_cast<int16_t>(GameData::items.find(reveal.item));
+        }
+        size_t details = 0;
+        for (const Pokemon& p : team) details += GameData::pokemon.nameOf(p.species).size() + p.getMoveCount() + (p.ability != Pokemon::NONE) + (p.item != Pokemon::NONE);
+        queue.push_back({ std::string_view(), team });
+        return details;
+    });
+
+    std::cout << "Strings:      " << before << " battles/s, " << sizeof(std::vector<NamedPokemon>) << " byte team plus "
+        << TEAM_SIZE * sizeof(NamedPokemon) << " bytes of Pokemon on the heap, and a move list each" << std::endl;
+    std::cout << "GameData IDs: " << after << " battles/s, " << sizeof(Team) << " byte team, nothing on the heap" << std::endl;
+    if (before > 0) std::cout << "Speedup: " << after / before << "x (" << touched << " details read)" << std::endl;
+}
+
+void Benchmark::lineStabilizer(int lines, int charactersPerFrame, int stableFrames) {
+    // Emerald dialogue: up to two rows of about 35 characters printed a few per frame, left up for a while, then the
+    // box is cleared. A character is about six glyph columns, and the second row prints under the first, so there the
+    // count stops growing and only the change detector sees the new characters.
+    const int rowLength = 35;
+    const int holdFrames = 8;
+    const int clearFrames = 2;
+    struct Observation {
+        bool changed;
+        int glyphColumns;
+        int line; // -1 while the box is empty
+    };
+    std::mt19937 random(29);
+    std::vector<Observation> frames;
+    for (int line = 0; line < lines; ++line) {
+        int length = std::uniform_int_distribution<int>(12, 2 * rowLength)(random);
+        for (int printed = charactersPerFrame; printed < length + charactersPerFrame; printed += charactersPerFrame) {
+            frames.push_back({ true, 6 * std::min(std::min(printed, length), rowLength), line });
+        }
+        for (int frame = 0; frame < holdFrames; ++frame) frames.push_back({ false, frames.back().glyphColumns, line });
+        for (int frame = 0; frame < clearFrames; ++frame) frames.push_back({ frame == 0, 0, -1 });
+    }
+
+    // Before: OCR on every changed box with text, and the latest text handled on every frame that had any.
+    size_t ocrBefore = 0, handledBefore = 0;
+    for (const Observation& frame : frames) {
+        ocrBefore += frame.changed && frame.glyphColumns > 0;
+        handledBefore += frame.glyphColumns > 0;
+    }
+
+    DialogueLineStabilizer stabilizer(stableFrames);
+    std::vector<int> readsPerLine(lines, 0);
+    size_t partialReads = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (stabilizer.observe(frames[i].changed, frames[i].glyphColumns) != LineStatus::Ready) continue;
+        readsPerLine[frames[i].line]++;
+        partialReads += i + 1 < frames.size() && frames[i + 1].changed && frames[i + 1].line == frames[i].line;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    size_t linesReadOnce = std::count(readsPerLine.begin(), readsPerLine.end(), 1);
+
+    std::cout << "Frames: " << frames.size() << ", lines: " << lines << ", " << charactersPerFrame << " characters per frame, stable after "
+        << stableFrames << " frames" << std::endl;
+    std::cout << "Every changed box:  " << static_cast<double>(ocrBefore) / lines << " OCR calls and " << static_cast<double>(handledBefore) / lines
+        << " BattleLogic calls per line" << std::endl;
+    std::cout << "Stabilized lines:   " << static_cast<double>(stabilizer.getLinesReady()) / lines << " OCR calls per line, "
+        << linesReadOnce << " of " << lines << " lines read exactly once, " << partialReads << " read before they finished printing" << std::endl;
+    std::cout << "Stabilizer: " << elapsed.count() / frames.size() << " ns/frame" << std::endl;
+}
+
+void Benchmark::captureScheduler(const std::string& corpusDir, double hours, double fixedInterval) {
+    // CPU for every captured frame, whether or not its line is read: crop and the change and blank detectors. OCR
+    // runs once per line either way, so it is left out.
+    std::vector<cv::Mat> corpus = loadCorpus(corpusDir);
+    if (corpus.empty()) return;
+    DialogueChangeDetector changeDetector;
+    BlankDialogueDetector blankDetector;
+    const int passes = 20;
+    int textFrames = 0;
+    std::clock_t cpuStart = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const cv::Mat& frame : corpus) {
+            cv::Mat dialogueCrop = cropToDialogue(frame);
+            if (changeDetector.hasChanged(dialogueCrop)) textFrames += blankDetector.hasText(dialogueCrop);
+        }
+    }
+    double cpuPerFrame = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC / (passes * corpus.size());
+    double secondsPerFrame = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / (passes * corpus.size());
+    std::cout << "Per captured frame: " << cpuPerFrame * 1000 << " ms CPU, " << secondsPerFrame * 1000 << " ms wall (" << textFrames
+        << " changed frames with text)" << std::endl;
+
+    const double seconds = hours * 3600;
+    std::vector<std::pair<int, double>> timeline = battleTowerTimeline(seconds);
+    CaptureScheduler fixed(CaptureRates::fixed(fixedInterval));
+    CaptureScheduler adaptive;
+    const std::pair<const char*, CaptureSimulation> runs[] = {
+        { "Sleep after frame", simulateCapture(timeline, seconds, secondsPerFrame, nullptr, fixedInterval) },
+        { "Fixed deadlines", simulateCapture(timeline, seconds, secondsPerFrame, &fixed, 0) },
+        { "By battle state", simulateCapture(timeline, seconds, secondsPerFrame, &adaptive, 0) }
+    };
+    for (const auto& run : runs) {
+        const CaptureSimulation& simulation = run.second;
+        std::cout << std::left << std::setw(18) << run.first << std::right << ": " << simulation.rate << " frames/s, "
+            << simulation.frames / hours << " frames/hour, " << simulation.frames * cpuPerFrame / hours << " CPU s/hour, missed deadlines "
+            << simulation.missed << "; frames by state";
+        for (double frames : simulation.framesByState) std::cout << ' ' << frames;
+        std::cout << std::endl;
+    }
+    std::cout << "Intervals by state: ";
+    for (int state = 0; state < 4; ++state) std::cout << (state > 0 ? ", " : "") << state << ": " << adaptive.intervalFor(state) << " s";
+    std::cout << " against " << fixedInterval << " s fixed" << std::endl;
+}
+
+void Benchmark::eventLog(int battles) {
+    std::vector<BattleEvent> events = generateBattleEvents(battles);
+    std::remove(SCRATCH_EVENT_LOG_PATH);
+
+    // Written as the battle logic writes it, flushed at the end of every battle.
+    auto start = std::chrono::steady_clock::now();
+    {
+        BattleEventLog log;
+        if (!log.open(SCRATCH_EVENT_LOG_PATH)) return;
+        for (const BattleEvent& event : events) {
+            log.append(event);
+            if (event.type == BattleEventType::TrainerDefeated) log.flush();
+        }
+    }
+    std::chrono::duration<double> writeTime = std::chrono::steady_clock::now() - start;
+    std::ifstream file(SCRATCH_EVENT_LOG_PATH, std::ios::binary | std::ios::ate);
+    double fileBytes = static_cast<double>(file.tellg());
+    file.close();
+    std::cout << "Events: " << events.size() << " from " << battles << " battles, written in " << writeTime.count() << " s ("
+        << events.size() / writeTime.count() << " events/s), " << fileBytes << " bytes (" << fileBytes / events.size() << " bytes/event)" << std::endl;
+
+    // Reading alone, then replaying into trainer histories.
+    BattleEventLogStats stats;
+    int64_t valueSum = 0;
+    start = std::chrono::steady_clock::now();
+    BattleEventLog::read(SCRATCH_EVENT_LOG_PATH, [&valueSum](const BattleEvent& event) { valueSum += event.value; }, &stats);
+    std::chrono::duration<double> readTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Read and checked: " << stats.events << " events in " << stats.blocks << " blocks, " << readTime.count() << " s ("
+        << stats.events / readTime.count() << " events/s)" << std::endl;
+
+    BattleEventReplayer replayer;
+    start = std::chrono::steady_clock::now();
+    replayer.replay(SCRATCH_EVENT_LOG_PATH, &stats);
+    std::chrono::duration<double> replayTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Replayed into memory: " << replayTime.count() << " s (" << stats.events / replayTime.count() << " events/s), "
+        << replayer.getBattles() << " battles, " << replayer.getEventsRejected() << " events ignored, streak " << replayer.getCurrentStreak() << std::endl;
+
+    // The database rebuilt from the histories in one bulk ingest.
+    removeScratchDatabase();
+    if (!DatabaseInterface::openDB(SCRATCH_DB_PATH)) return;
+    std::vector<SightingRecord> records;
+    IngestCounts added;
+    start = std::chrono::steady_clock::now();
+    replayer.toSightings(records);
+    DatabaseInterface::ingestSightings(records, added);
+    std::chrono::duration<double> rebuildTime = std::chrono::steady_clock::now() - start;
+    DatabaseInterface::closeDB();
+    removeScratchDatabase();
+    std::cout << "Database rebuilt: " << rebuildTime.count() << " s, " << added.trainers << " trainers, " << added.pokemon << " Pokemon, "
+        << added.sightings << " sightings" << std::endl;
+
+    // A crash partway through a block: the torn block is left out on reading and cut off when the log is reopened.
+    std::ofstream torn(SCRATCH_EVENT_LOG_PATH, std::ios::binary | std::ios::app);
+    torn.write("\x14\0\0\0\x7f\x3c\x11\x90\x01\x02\x03\x04\x05", 13);
+    torn.close();
+    BattleEventLog::read(SCRATCH_EVENT_LOG_PATH, [](const BattleEvent&) {}, &stats);
+    std::cout << "Torn tail: " << stats.events << " events read, damaged tail: " << (stats.damagedTail ? "yes" : "no") << std::endl;
+    {
+        BattleEventLog log;
+        if (!log.open(SCRATCH_EVENT_LOG_PATH)) return;
+        log.append(events.back());
+    }
+    BattleEventLog::read(SCRATCH_EVENT_LOG_PATH, [](const BattleEvent&) {}, &stats);
+    std::cout << "Reopened and appended: " << stats.events << " events read, damaged tail: " << (stats.damagedTail ? "yes" : "no") << std::endl;
+    std::remove(SCRATCH_EVENT_LOG_PATH);
+}
+
+void Benchmark::gameData(int repetitions) {
+    const std::pair<const std::string_view*, size_t> lists[] = {
+        { GameData::trainerNames, GameData::trainers.size() }, { GameData::itemNames, GameData::items.size() },
+        { GameData::moveNames, GameData::moves.size() }, { GameData::abilityNames, GameData::abilities.size() },
+        { GameData::pokemonNames, GameData::pokemon.size() }
+    };
+
+    // Startup: what the old header did during static initialization, once per translation unit that included it.
+    std::vector<std::unordered_set<std::string>> sets;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        sets.clear();
+        for (const auto& list : lists) {
+            std::unordered_set<std::string>& set = sets.emplace_back();
+            for (size_t n = 0; n < list.second; ++n) set.emplace(list.first[n]);
+        }
+    }
+    std::chrono::duration<double, std::micro> buildTime = std::chrono::steady_clock::now() - start;
+    std::cout << "Building the unordered_sets: " << buildTime.count() / repetitions << " us, perfect hash tables: built by the compiler" << std::endl;
+
+    GameDataTotals totals;
+    compareGameDataLookups("trainers", GameData::trainers, GameData::trainerNames, sets[0], repetitions, totals);
+    compareGameDataLookups("items", GameData::items, GameData::itemNames, sets[1], repetitions, totals);
+    compareGameDataLookups("moves", GameData::moves, GameData::moveNames, sets[2], repetitions, totals);
+    compareGameDataLookups("abilities", GameData::abilities, GameData::abilityNames, sets[3], repetitions, totals);
+    compareGameDataLookups("pokemon", GameData::pokemon, GameData::pokemonNames, sets[4], repetitions, totals);
+    std::cout << "Overall: unordered_set " << totals.setNanos / totals.lookups << " ns/lookup, perfect hash "
+        << totals.tableNanos / totals.lookups << " ns/lookup (" << totals.setNanos / totals.tableNanos << "x); memory "
+        << totals.setBytes << " -> " << totals.tableBytes << " bytes" << std::endl;
+}
@@ -0,0 +1,113 @@
+#include "blankdialoguedetector.h"
+#include <algorithm>
+#include <cstdlib>
+
+BlankDialogueDetector::BlankDialogueDetector(int sampleStep, int inkDelta, double minBackgroundShare, double minInkRatio, int minGlyphRows)
+    : sampleStep(sampleStep > 0 ? sampleStep : 1), inkDelta(inkDelta), minBackgroundShare(minBackgroundShare),
+    minInkRatio(minInkRatio), minGlyphRows(minGlyphRows), glyphColumns(0), framesWithText(0), framesBlank(0) {}
+
+DialogueContent BlankDialogueDetector::classify(const cv::Mat& dialogueCrop) {
+    glyphColumns = 0;
+    if (dialogueCrop.empty()) return DialogueContent::NoBox;
+
+    const int channels = dialogueCrop.channels();
+    const int sampledRows = (dialogueCrop.rows + sampleStep - 1) / sampleStep;
+    const int sampledCols = (dialogueCrop.cols + sampleStep - 1) / sampleStep;
+
+    // First pass: luminance of every sample and a coarse histogram to find the background color.
+    std::vector<uchar>& luma = lumaSamples;
+    luma.resize(static_cast<size_t>(sampledRows) * sampledCols);
+    int histogram[32] = { 0 };
+    size_t index = 0;
+    for (int y = 0; y < dialogueCrop.rows; y += sampleStep) {
+        const uchar* row = dialogueCrop.ptr<uchar>(y);
+        for (int x = 0; x < dialogueCrop.cols; x += sampleStep) {
+            const uchar* px = row + x * channels;
+            int value = channels >= 3 ? (px[0] * 29 + px[1] * 150 + px[2] * 77) >> 8 : px[0]; // BGR to luma, fixed point
+            luma[index++] = static_cast<uchar>(value);
+            histogram[value >> 3]++;
+        }
+    }
+
+    // The background is the densest window of three neighbouring bins, which tolerates capture noise at bin edges.
+    int peakBin = 0;
+    int peakCount = -1;
+    for (int bin = 0; bin < 32; ++bin) {
+        int count = histogram[bin] + (bin > 0 ? histogram[bin - 1] : 0) + (bin < 31 ? histogram[bin + 1] : 0);
+        if (count > peakCount) {
+            peakCount = count;
+            peakBin = bin;
+        }
+    }
+    double backgroundShare = static_cast<double>(peakCount) / luma.size();
+    if (backgroundShare < minBackgroundShare) {
+        framesBlank++;
+        return DialogueContent::NoBox;
+    }
+    int background = peakBin * 8 + 4;
+
+    // Second pass: mark ink and find columns that are ink on almost every row, those belong to the box frame.
+    std::vector<int>& columnInk = columnInkCounts;
+    columnInk.assign(sampledCols, 0);
+    for (size_t i = 0; i < luma.size(); ++i) {
+        bool ink = std::abs(luma[i] - background) > inkDelta;
+        luma[i] = ink; // Samples are only needed as ink flags from here on
+        columnInk[i % sampledCols] += ink;
+    }
+    for (int c = 0; c < sampledCols; ++c) {
+        if (columnInk[c] > sampledRows * 9 / 10) {
+            columnInk[c] = -1; // Frame column, ignored below
+        }
+    }
+
+    // Third pass: row projection of the remaining ink, skipping rows that are nearly all ink (horizontal frame).
+    textColumns.assign(sampledCols, 0);
+    size_t inkTotal = 0;
+    int run = 0;
+    int longestRun = 0;
+    for (int r = 0; r < sampledRows; ++r) {
+        const uchar* row = &luma[static_cast<size_t>(r) * sampledCols];
+        int inkInRow = 0;
+        for (int c = 0; c < sampledCols; ++c) {
+            inkInRow += row[c] && columnInk[c] >= 0;
+        }
+
+        if (inkInRow >= 2 && inkInRow < sampledCols * 9 / 10) {
+            for (int c = 0; c < sampledCols; ++c) {
+                textColumns[c] |= row[c] && columnInk[c] >= 0;
+            }
+            inkTotal += inkInRow;
+            longestRun = std::max(longestRun, ++run);
+        }
+        else {
+            run = 0;
+        }
+    }
+
+    double inkRatio = static_cast<double>(inkTotal) / luma.size();
+    if (inkRatio < minInkRatio || longestRun < minGlyphRows) {
+        framesBlank++;
+        return DialogueContent::EmptyBox;
+    }
+    for (uchar column : textColumns) {
+        glyphColumns += column;
+    }
+    framesWithText++;
+    return DialogueContent::Text;
+}
+
+bool BlankDialogueDetector::hasText(const cv::Mat& dialogueCrop) {
+    return classify(dialogueCrop) == DialogueContent::Text;
+}
+
+int BlankDialogueDetector::getGlyphColumns() const {
+    return glyphColumns;
+}
+
+uint64_t BlankDialogueDetector::getFramesWithText() const {
+    return framesWithText;
+}
+
+uint64_t BlankDialogueDetector::getFramesBlank() const {
+    return framesBlank;
+}
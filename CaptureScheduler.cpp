@@ -0,0 +1,70 @@
+/*
+Deadline based pacing of live capture, faster while BattleLogic expects a line and slower while it waits for a streak.
+*/
+
+#include "capturescheduler.h"
+#include <thread>
+
+namespace {
+    CaptureScheduler::Clock::duration toDuration(double seconds) {
+        return std::chrono::duration_cast<CaptureScheduler::Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+}
+
+CaptureRates CaptureRates::fixed(double interval) {
+    CaptureRates rates;
+    rates.idleInterval = interval;
+    rates.burstInterval = interval;
+    rates.activeInterval = interval;
+    return rates;
+}
+
+CaptureScheduler::CaptureScheduler(const CaptureRates& rates) : rates(rates), started(false), framesScheduled(0), deadlinesMissed(0) {}
+
+double CaptureScheduler::intervalFor(int state) const {
+    switch (state) {
+    case 1:
+    case 2:
+        return rates.burstInterval;
+    case 3:
+        return rates.activeInterval;
+    default:
+        return rates.idleInterval;
+    }
+}
+
+CaptureScheduler::Clock::time_point CaptureScheduler::nextDeadline(int state, Clock::time_point now) {
+    Clock::time_point deadline;
+    if (!started) {
+        started = true;
+        deadline = now;
+        firstDeadline = now;
+    }
+    else {
+        deadline = lastDeadline + toDuration(intervalFor(state));
+        if (deadline < now) {
+            deadlinesMissed++;
+            deadline = now;
+        }
+    }
+    lastDeadline = deadline;
+    framesScheduled++;
+    return deadline;
+}
+
+void CaptureScheduler::waitForNextFrame(int state) {
+    std::this_thread::sleep_until(nextDeadline(state, Clock::now()));
+}
+
+double CaptureScheduler::getEffectiveRate() const {
+    std::chrono::duration<double> elapsed = lastDeadline - firstDeadline;
+    return framesScheduled > 1 && elapsed.count() > 0 ? (framesScheduled - 1) / elapsed.count() : 0.0;
+}
+
+uint64_t CaptureScheduler::getFramesScheduled() const {
+    return framesScheduled;
+}
+
+uint64_t CaptureScheduler::getDeadlinesMissed() const {
+    return deadlinesMissed;
+}
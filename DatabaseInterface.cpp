@@ -4,137 +4,383 @@ Database logic for inserting and retrieving data from the SQLite database.
 
 
 #include "databaseinterface.h"
+#include "databasemigrations.h"
+#include "gamedata.h"
+#include "knowledgesnapshot.h"
+#include "stagetimer.h"
+#include "trainerknowledge.h"
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+	// Every query the interface runs. Those run on the writer connection are prepared once and reused from then on.
+	enum Query { SELECT_TRAINER, INSERT_TRAINER, SELECT_POKEMON, INSERT_POKEMON, INSERT_MOVE, INSERT_ABILITY, INSERT_ITEM, SELECT_MOVES, QUERY_COUNT };
+
+	const char* const QUERY_TEXT[QUERY_COUNT] = {
+		"SELECT trainer_id FROM Trainers WHERE name = ?;",
+		"INSERT INTO Trainers(name) VALUES (?);",
+		"Select pokemon_id FROM Pokemon WHERE trainer_id = ? AND name = ?;",
+		"INSERT OR IGNORE INTO Pokemon (trainer_id, name) VALUES (?, ?);",
+		"INSERT OR IGNORE INTO SeenMoves (pokemon_id, move) VALUES (?, ?);",
+		"INSERT OR IGNORE INTO SeenAbilities (pokemon_id, ability) VALUES (?, ?);",
+		"INSERT OR IGNORE INTO SeenItems (pokemon_id, item) VALUES (?, ?);",
+		"SELECT move FROM SeenMoves WHERE pokemon_id = ?;"
+	};
+
+	const char* const DEFAULT_DB_PATH = "pokemon_db.sqlite";
+
+	// WAL lets the read-only connections read while a write is in progress, and in WAL mode synchronous NORMAL only
+	// syncs at checkpoints without risking corruption. Memory mapping saves a copy per page read.
+	const char* const WRITER_PRAGMAS =
+		"PRAGMA journal_mode = WAL;"
+		"PRAGMA synchronous = NORMAL;"
+		"PRAGMA cache_size = -16384;" // 16 MiB
+		"PRAGMA mmap_size = 268435456;"
+		"PRAGMA temp_store = MEMORY;"
+		"PRAGMA busy_timeout = 5000;";
+	const char* const READER_PRAGMAS =
+		"PRAGMA cache_size = -4096;"
+		"PRAGMA mmap_size = 268435456;"
+		"PRAGMA busy_timeout = 5000;";
+
+	const size_t MAX_IDLE_READERS = 4;
+
+	// The writer connection and the statements prepared on it, which have to be finalized before it can be closed. The
+	// database writer thread and the reading threads share it, so it is locked for each statement and each transaction.
+	struct Connection {
+		std::recursive_mutex lock;
+		sqlite3* db = nullptr;
+		sqlite3_stmt* statements[QUERY_COUNT] = {};
+
+		~Connection() {
+			for (sqlite3_stmt* stmt : statements) sqlite3_finalize(stmt);
+			sqlite3_close(db);
+		}
+	};
+
+	// Read-only connections to the writer's database that are not in use. The generation changes when the writer is
+	// closed, so connections handed out before that are closed instead of coming back.
+	struct ReaderPool {
+		std::mutex lock;
+		std::string path;
+		unsigned generation = 0;
+		std::vector<sqlite3*> idle;
+
+		~ReaderPool() {
+			for (sqlite3* db : idle) sqlite3_close(db);
+		}
+	};
+
+	Connection connection;
+	ReaderPool readers;
+
+	// Bulk ingest stages each batch in temporary tables and moves it into the real ones with a few set based statements.
+	const char* const STAGING_SCHEMA =
+		"CREATE TEMP TABLE IF NOT EXISTS StagedSightings (trainer TEXT NOT NULL, pokemon TEXT NOT NULL, kind INTEGER NOT NULL, detail TEXT);"
+		"CREATE TEMP TABLE IF NOT EXISTS StagedPokemon (trainer_id INTEGER NOT NULL, name TEXT NOT NULL, pokemon_id INTEGER,"
+		" PRIMARY KEY (trainer_id, name)) WITHOUT ROWID;"
+		"DELETE FROM temp.StagedSightings;"
+		"DELETE FROM temp.StagedPokemon;";
+
+	const size_t STAGED_ROWS_PER_INSERT = 64; // Four parameters a row, under the 999 older SQLite builds allow
+
+	const char* const UPSERT_STAGED_TRAINERS =
+		"INSERT INTO Trainers(name) SELECT DISTINCT trainer FROM temp.StagedSightings WHERE true ON CONFLICT(name) DO NOTHING;";
+	const char* const STAGE_POKEMON =
+		"INSERT OR IGNORE INTO temp.StagedPokemon(trainer_id, name)"
+		" SELECT t.trainer_id, s.pokemon FROM temp.StagedSightings s JOIN Trainers t ON t.name = s.trainer;";
+	const char* const FIND_STAGED_POKEMON =
+		"UPDATE temp.StagedPokemon SET pokemon_id = p.pokemon_id FROM Pokemon p"
+		" WHERE p.trainer_id = StagedPokemon.trainer_id AND p.name = StagedPokemon.name;";
+	const char* const INSERT_STAGED_POKEMON =
+		"INSERT INTO Pokemon(trainer_id, name) SELECT trainer_id, name FROM temp.StagedPokemon WHERE pokemon_id IS NULL"
+		" RETURNING pokemon_id, trainer_id, name;";
+	const char* const SET_STAGED_POKEMON_ID = "UPDATE temp.StagedPokemon SET pokemon_id = ? WHERE trainer_id = ? AND name = ?;";
+
+	// One statement per Seen table, each taking the staged rows of its kind.
+	const char* const INSERT_STAGED_SIGHTINGS[] = {
+		"INSERT INTO SeenMoves(pokemon_id, move) SELECT p.pokemon_id, s.detail FROM temp.StagedSightings s"
+		" JOIN Trainers t ON t.name = s.trainer JOIN temp.StagedPokemon p ON p.trainer_id = t.trainer_id AND p.name = s.pokemon"
+		" WHERE s.kind = 1 ON CONFLICT DO NOTHING;",
+		"INSERT INTO SeenAbilities(pokemon_id, ability) SELECT p.pokemon_id, s.detail FROM temp.StagedSightings s"
+		" JOIN Trainers t ON t.name = s.trainer JOIN temp.StagedPokemon p ON p.trainer_id = t.trainer_id AND p.name = s.pokemon"
+		" WHERE s.kind = 2 ON CONFLICT DO NOTHING;",
+		"INSERT INTO SeenItems(pokemon_id, item) SELECT p.pokemon_id, s.detail FROM temp.StagedSightings s"
+		" JOIN Trainers t ON t.name = s.trainer JOIN temp.StagedPokemon p ON p.trainer_id = t.trainer_id AND p.name = s.pokemon"
+		" WHERE s.kind = 3 ON CONFLICT DO NOTHING;"
+	};
+
+	std::string stagingInsert(size_t rows) {
+		std::string query = "INSERT INTO temp.StagedSightings VALUES ";
+		for (size_t row = 0; row < rows; row++) {
+			query += row == 0 ? "(?, ?, ?, ?)" : ", (?, ?, ?, ?)";
+		}
+		return query + ";";
+	}
+
+	// Binds the next rows records to a multi-row staging insert and runs it.
+	bool stageRecords(sqlite3_stmt* stmt, const SightingRecord* records, size_t rows) {
+		for (size_t row = 0; row < rows; row++) {
+			const SightingRecord& record = records[row];
+			int column = static_cast<int>(row * 4);
+			sqlite3_bind_text(stmt, column + 1, record.trainer.c_str(), static_cast<int>(record.trainer.size()), SQLITE_STATIC);
+			sqlite3_bind_text(stmt, column + 2, record.pokemon.c_str(), static_cast<int>(record.pokemon.size()), SQLITE_STATIC);
+			sqlite3_bind_int(stmt, column + 3, static_cast<int>(record.kind));
+			sqlite3_bind_text(stmt, column + 4, record.detail.c_str(), static_cast<int>(record.detail.size()), SQLITE_STATIC);
+		}
+		bool done = sqlite3_step(stmt) == SQLITE_DONE;
+		sqlite3_reset(stmt);
+		return done;
+	}
+
+	// Inserts the staged Pokemon the database does not have yet and records the IDs they were given.
+	bool insertStagedPokemon(sqlite3* db, size_t& added) {
+		struct NewPokemon {
+			int pokemonID;
+			int trainerID;
+			std::string name;
+		};
+		std::vector<NewPokemon> inserted;
+
+		sqlite3_stmt* stmt;
+		if (sqlite3_prepare_v2(db, INSERT_STAGED_POKEMON, -1, &stmt, nullptr) != SQLITE_OK) return false;
+		int result;
+		while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+			inserted.push_back({ sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)) });
+		}
+		sqlite3_finalize(stmt);
+		if (result != SQLITE_DONE) return false;
+
+		if (sqlite3_prepare_v2(db, SET_STAGED_POKEMON_ID, -1, &stmt, nullptr) != SQLITE_OK) return false;
+		for (const NewPokemon& pokemon : inserted) {
+			sqlite3_bind_int(stmt, 1, pokemon.pokemonID);
+			sqlite3_bind_int(stmt, 2, pokemon.trainerID);
+			sqlite3_bind_text(stmt, 3, pokemon.name.c_str(), -1, SQLITE_STATIC);
+			// A row left without its ID would have its sightings skipped without a word.
+			bool done = sqlite3_step(stmt) == SQLITE_DONE;
+			sqlite3_reset(stmt);
+			if (!done) {
+				sqlite3_finalize(stmt);
+				return false;
+			}
+		}
+		sqlite3_finalize(stmt);
+		added += inserted.size();
+		return true;
+	}
+
+	// Rolls back the transaction the snapshot writers began. The write methods added its rows to TrainerKnowledge as they
+	// went, so the cache is reloaded from the database, or it would hand out IDs the database never stored.
+	void rollBackWrites(sqlite3* db) {
+		sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr); // Otherwise the next BEGIN fails as well
+		if (TrainerKnowledge::shared().isLoaded()) TrainerKnowledge::shared().load(db);
+	}
+
+	// One use of a cached statement. The statement is reset and its bindings cleared when the use ends, so it does not
+	// keep a read transaction open or point at strings that have gone away.
+	class CachedStatement {
+	private:
+		std::lock_guard<std::recursive_mutex> guard;
+		sqlite3_stmt* stmt;
+
+	public:
+		explicit CachedStatement(Query query) : guard(connection.lock), stmt(nullptr) {
+			sqlite3* db = DatabaseInterface::getDB();
+			if (!db) return;
+			sqlite3_stmt*& cached = connection.statements[query];
+			if (!cached && sqlite3_prepare_v3(db, QUERY_TEXT[query], -1, SQLITE_PREPARE_PERSISTENT, &cached, nullptr) != SQLITE_OK) {
+				std::cerr << "Error preparing statement: " << sqlite3_errmsg(db) << std::endl;
+				sqlite3_finalize(cached);
+				cached = nullptr;
+			}
+			stmt = cached;
+		}
+
+		~CachedStatement() {
+			if (stmt) {
+				sqlite3_reset(stmt);
+				sqlite3_clear_bindings(stmt);
+			}
+		}
+
+		CachedStatement(const CachedStatement&) = delete;
+		CachedStatement& operator=(const CachedStatement&) = delete;
+
+		explicit operator bool() const { return stmt != nullptr; }
+		sqlite3_stmt* get() const { return stmt; }
+	};
+}
 
 // Method for retrieving a database connection. If the database is already open, it returns the existing connection; otherwise, it opens a new one.
 sqlite3* DatabaseInterface::getDB() {
-	static sqlite3* db = nullptr;
-	if (!db) {
-		if (sqlite3_open("pokemon_db.sqlite", &db) != SQLITE_OK) {
-			std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
-			db = nullptr;
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
+	if (!connection.db) openDB(DEFAULT_DB_PATH);
+	return connection.db;
+}
+
+// Method to open the database at a given path, closing the current connection first. The schema is brought up to date before the connection is used.
+bool DatabaseInterface::openDB(const std::string& path) {
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
+	closeDB();
+	sqlite3* db = nullptr;
+	if (sqlite3_open(path.c_str(), &db) != SQLITE_OK || sqlite3_exec(db, WRITER_PRAGMAS, nullptr, nullptr, nullptr) != SQLITE_OK) {
+		std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+		if (sqlite3_errcode(db) == SQLITE_NOTADB) { // Such as the SQL script that used to be kept at the default path
+			std::cerr << path << " is not a SQLite database, move it aside and a new one is created." << std::endl;
 		}
+		sqlite3_close(db);
+		return false;
+	}
+	if (!migrateDatabase(db)) {
+		sqlite3_close(db);
+		return false;
+	}
+
+	connection.db = db;
+	std::lock_guard<std::mutex> readersGuard(readers.lock);
+	readers.path = path;
+	return true;
+}
+
+// Method to borrow a read-only connection, opening one when none are idle.
+ReadConnection DatabaseInterface::openReader() {
+	std::unique_lock<std::mutex> readersGuard(readers.lock);
+	if (!readers.idle.empty()) {
+		sqlite3* db = readers.idle.back();
+		readers.idle.pop_back();
+		return ReadConnection(db, readers.generation);
+	}
+	if (readers.path.empty()) { // Readers open the writer's database, so the writer comes first
+		readersGuard.unlock();
+		if (!getDB()) return ReadConnection(nullptr, 0);
+		readersGuard.lock();
+	}
+	std::string path = readers.path;
+	unsigned generation = readers.generation;
+	readersGuard.unlock();
+
+	sqlite3* db = nullptr;
+	if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK
+		|| sqlite3_exec(db, READER_PRAGMAS, nullptr, nullptr, nullptr) != SQLITE_OK) {
+		std::cerr << "Error opening read-only connection: " << sqlite3_errmsg(db) << std::endl;
+		sqlite3_close(db);
+		return ReadConnection(nullptr, 0);
+	}
+	return ReadConnection(db, generation);
+}
+
+ReadConnection::ReadConnection(sqlite3* db, unsigned generation) : db(db), generation(generation) {}
+
+ReadConnection::ReadConnection(ReadConnection&& other) noexcept : db(other.db), generation(other.generation) {
+	other.db = nullptr;
+}
+
+ReadConnection::~ReadConnection() {
+	if (!db) return;
+	std::lock_guard<std::mutex> readersGuard(readers.lock);
+	if (generation == readers.generation && readers.idle.size() < MAX_IDLE_READERS) {
+		readers.idle.push_back(db);
+	}
+	else {
+		sqlite3_close(db);
 	}
-	return db;
 }
 
 // Method to find a trainer by name in the database. If the trainer does not exist, it creates a new entry and returns the new trainer ID.
-int DatabaseInterface::getOrCreateTrainer(const std::string& trainerName) {
-	sqlite3* db = getDB();
-	if (!db) return -1;
+int DatabaseInterface::getOrCreateTrainer(std::string_view trainerName) {
+	ScopedStageTimer timer(PipelineStage::Database);
+	int knownID = TrainerKnowledge::shared().findTrainerID(trainerName); // Answered without waiting on the connection
+	if (knownID >= 0) return knownID;
 
-	sqlite3_stmt* stmt;
-	int trainerID = -1;
+	CachedStatement select(SELECT_TRAINER);
+	if (!select) return -1;
 
-	std::string query = "SELECT id FROM Trainers WHERE name = ?;";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_text(stmt, 1, trainerName.c_str(), -1, SQLITE_STATIC);
-		if (sqlite3_step(stmt) == SQLITE_ROW) {
-			trainerID = sqlite3_column_int(stmt, 0);
-		}
-		else {
-			sqlite3_finalize(stmt);
-			query = "INSERT INTO Trainers(name) VALUES (?);";
-			sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
-			sqlite3_bind_text(stmt, 1, trainerName.c_str(), -1, SQLITE_STATIC);
-			sqlite3_step(stmt);
-			trainerID = sqlite3_last_insert_rowid(db);
-		}
+	sqlite3_bind_text(select.get(), 1, trainerName.data(), static_cast<int>(trainerName.size()), SQLITE_STATIC);
+	if (sqlite3_step(select.get()) == SQLITE_ROW) {
+		return sqlite3_column_int(select.get(), 0);
 	}
-	sqlite3_finalize(stmt);
+
+	CachedStatement insert(INSERT_TRAINER);
+	if (!insert) return -1;
+	sqlite3_bind_text(insert.get(), 1, trainerName.data(), static_cast<int>(trainerName.size()), SQLITE_STATIC);
+	if (sqlite3_step(insert.get()) != SQLITE_DONE) return -1;
+	int trainerID = static_cast<int>(sqlite3_last_insert_rowid(connection.db));
+	TrainerKnowledge::shared().addTrainer(trainerID, trainerName);
 	return trainerID;
-	
 }
 
 // Method to get a Pokemon's ID based on the trainer's ID and the Pokmon's name. If the Pokmon does not exist, it returns -1.
 int DatabaseInterface::getPokemonID(int trainerID, const std::string& pokeName) {
-	sqlite3* db = getDB();
-	if (!db) return -1;
+	CachedStatement stmt(SELECT_POKEMON);
+	if (!stmt) return -1;
 
 	int pokemonID = -1;
-	sqlite3_stmt* stmt;
-
-	std::string query = "Select pokemon_id FROM Pokemon WHERE trainer_id = ? AND name = ?;";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_int(stmt, 1, trainerID);
-		sqlite3_bind_text(stmt, 2, pokeName.c_str(), -1, SQLITE_STATIC);
-		if (sqlite3_step(stmt) == SQLITE_ROW) {
-			pokemonID = sqlite3_column_int(stmt, 0);
-		}
+	sqlite3_bind_int(stmt.get(), 1, trainerID);
+	sqlite3_bind_text(stmt.get(), 2, pokeName.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+		pokemonID = sqlite3_column_int(stmt.get(), 0);
 	}
-	sqlite3_finalize(stmt);
 	return pokemonID;
 }
 
 // Method to insert a Pokmon into the database, or ignore the insertion if it already exists for the given trainer.
 void DatabaseInterface::insertOrIgnorePokemon(int trainerID, const std::string& pokeName) {
-	sqlite3* db = getDB();
-	if (!db) return;
-
-	sqlite3_stmt* stmt;
-	std::string query = "INSERT OR IGNORE INTO Pokemon (trainer_id, name) VALUES (?, ?);";
+	CachedStatement stmt(INSERT_POKEMON);
+	if (!stmt) return;
 
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_int(stmt, 1, trainerID);
-		sqlite3_bind_text(stmt, 2, pokeName.c_str(), -1, SQLITE_STATIC);
-		sqlite3_step(stmt);
+	sqlite3_bind_int(stmt.get(), 1, trainerID);
+	sqlite3_bind_text(stmt.get(), 2, pokeName.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt.get()) == SQLITE_DONE && sqlite3_changes(connection.db) > 0) {
+		TrainerKnowledge::shared().addPokemon(static_cast<int>(sqlite3_last_insert_rowid(connection.db)), trainerID, pokeName);
 	}
-	sqlite3_finalize(stmt);
 }
 
 // Method to add a move to a Pokemon's moves in the database. If the move already exists, it ignores the insertion.
 void DatabaseInterface::addSeenMove(int pokemonID, const std::string& moveName) {
-	sqlite3* db = getDB();
-	if (!db) return;
+	CachedStatement stmt(INSERT_MOVE);
+	if (!stmt) return;
 
-	sqlite3_stmt* stmt;
-	std::string query = "INSERT OR IGNORE INTO SeenMoves (pokemon_id, move) VALUES (?, ?);";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_int(stmt, 1, pokemonID);
-		sqlite3_bind_text(stmt, 2, moveName.c_str(), -1, SQLITE_STATIC);
-		sqlite3_step(stmt);
+	sqlite3_bind_int(stmt.get(), 1, pokemonID);
+	sqlite3_bind_text(stmt.get(), 2, moveName.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt.get()) == SQLITE_DONE && sqlite3_changes(connection.db) > 0) {
+		TrainerKnowledge::shared().addSeen(pokemonID, EntityType::Move, moveName);
 	}
-	sqlite3_finalize(stmt);
 }
 
 // Method to add an ability to a Pokemon's abilities in the database. If the ability already exists, it ignores the insertion.
 void DatabaseInterface::addSeenAbility(int pokemonID, const std::string& abilityName) {
-	sqlite3* db = getDB();
-	if (!db) return;
+	CachedStatement stmt(INSERT_ABILITY);
+	if (!stmt) return;
 
-	sqlite3_stmt* stmt;
-	std::string query = "INSERT OR IGNORE INTO SeenAbilities (pokemon_id, ability) VALUES (?, ?);";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_int(stmt, 1, pokemonID);
-		sqlite3_bind_text(stmt, 2, abilityName.c_str(), -1, SQLITE_STATIC);
-		sqlite3_step(stmt);
+	sqlite3_bind_int(stmt.get(), 1, pokemonID);
+	sqlite3_bind_text(stmt.get(), 2, abilityName.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt.get()) == SQLITE_DONE && sqlite3_changes(connection.db) > 0) {
+		TrainerKnowledge::shared().addSeen(pokemonID, EntityType::Ability, abilityName);
 	}
-	sqlite3_finalize(stmt);
 }
 
 // Method to add an item to a Pokemon's seen items in the database. If the item already exists, it ignores the insertion.
 void DatabaseInterface::addSeenItem(int pokemonID, const std::string& itemName) {
-	sqlite3* db = getDB();
-	if (!db) return;
+	CachedStatement stmt(INSERT_ITEM);
+	if (!stmt) return;
 
-	sqlite3_stmt* stmt;
-	std::string query = "INSERT OR IGNORE INTO SeenItems (pokemon_id, item) VALUES (?, ?);";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-		sqlite3_bind_int(stmt, 1, pokemonID);
-		sqlite3_bind_text(stmt, 2, itemName.c_str(), -1, SQLITE_STATIC);
-		sqlite3_step(stmt);
+	sqlite3_bind_int(stmt.get(), 1, pokemonID);
+	sqlite3_bind_text(stmt.get(), 2, itemName.c_str(), -1, SQLITE_STATIC);
+	if (sqlite3_step(stmt.get()) == SQLITE_DONE && sqlite3_changes(connection.db) > 0) {
+		TrainerKnowledge::shared().addSeen(pokemonID, EntityType::Item, itemName);
 	}
-	sqlite3_finalize(stmt);
 }
 
 // Method to retrieve all seen moves for a given Pokmon from the database.
 std::vector<std::string> DatabaseInterface::getSeenMoves(int pokemonID) {
-	sqlite3* db = getDB();
+	ScopedStageTimer timer(PipelineStage::Database);
 	std::vector<std::string> moves;
-	if (!db) return moves;
+	ReadConnection reader = openReader(); // Does not wait for the database writer thread
+	if (!reader) return moves;
 
 	sqlite3_stmt* stmt;
-	std::string query = "SELECT move FROM SeenMoves WHERE pokemon_id = ?;";
-	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+	if (sqlite3_prepare_v2(reader.get(), QUERY_TEXT[SELECT_MOVES], -1, &stmt, nullptr) == SQLITE_OK) {
 		sqlite3_bind_int(stmt, 1, pokemonID);
 		while (sqlite3_step(stmt) == SQLITE_ROW) {
 			const unsigned char* text = sqlite3_column_text(stmt, 0);
@@ -147,8 +393,33 @@ std::vector<std::string> DatabaseInterface::getSeenMoves(int pokemonID) {
 	return moves;
 }
 
+// Writes one trainer's team, inside a transaction the caller has begun.
+// The team is kept as GameData IDs, the tables by name, so names are looked up here. Empty slots are skipped.
+void DatabaseInterface::writeTrainerData(int trainerID, const Team& activeTeam) {
+	for (const auto& p : activeTeam) {
+		if (p.isEmpty()) continue;
+		std::string pokeName(GameData::pokemon.nameOf(p.species));
+		insertOrIgnorePokemon(trainerID, pokeName);
+		int pokemonID = getPokemonID(trainerID, pokeName);
+
+		for (size_t move = 0; move < p.getMoveCount(); move++) {
+			addSeenMove(pokemonID, std::string(GameData::moves.nameOf(p.moves[move])));
+		}
+
+		if (p.ability != Pokemon::NONE) {
+			addSeenAbility(pokemonID, std::string(GameData::abilities.nameOf(p.ability)));
+		}
+
+		if (p.item != Pokemon::NONE) {
+			addSeenItem(pokemonID, std::string(GameData::items.nameOf(p.item)));
+		}
+	}
+}
+
 // Method to persist trainer data to the database, ignoring duplicate entries.
-void DatabaseInterface::persistTrainerData(int trainerID, const std::vector<Pokemon>& activeTeam) {
+void DatabaseInterface::persistTrainerData(int trainerID, const Team& activeTeam) {
+	ScopedStageTimer timer(PipelineStage::Database);
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
 	sqlite3* db = getDB();
 	if (!db) return;
 
@@ -158,45 +429,172 @@ void DatabaseInterface::persistTrainerData(int trainerID, const std::vector<Poke
 		return;
 	}
 
-	for (const auto& p : activeTeam) {
-		sqlite3_stmt* stmt;
-		std::string insertQuery = "INSERT OR IGNORE INTO Pokemon (trainer_id, name) VALUES (?, ?);";
+	writeTrainerData(trainerID, activeTeam);
 
-		if (sqlite3_prepare_v2(db, insertQuery.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-			sqlite3_bind_int(stmt, 1, trainerID);
-			sqlite3_bind_text(stmt, 2, p.getName().c_str(), -1, SQLITE_STATIC);
-			sqlite3_step(stmt);
-		}
-		else {
-			std::cerr << "Error inserting Pokemon: " << sqlite3_errmsg(db) << std::endl;
+	transCheck = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	if (transCheck != SQLITE_OK) {
+		std::cerr << "Error committing transaction: " << sqlite3_errmsg(db) << std::endl;
+		rollBackWrites(db);
+	}
+}
+
+// Method to persist several battles at once, in a single transaction so they share one commit. Each trainer is found or added here, on the writer thread.
+void DatabaseInterface::persistTrainerSnapshots(const std::vector<TrainerSnapshot>& snapshots) {
+	ScopedStageTimer timer(PipelineStage::Database);
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
+	sqlite3* db = getDB();
+	if (!db) return;
+
+	int transCheck = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+	if (transCheck != SQLITE_OK) {
+		std::cerr << "Error starting transaction: " << sqlite3_errmsg(db) << std::endl;
+		return;
+	}
+
+	for (const TrainerSnapshot& snapshot : snapshots) {
+		int trainerID = getOrCreateTrainer(snapshot.trainerName);
+		if (trainerID >= 0) writeTrainerData(trainerID, snapshot.activeTeam);
+	}
+
+	transCheck = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+	if (transCheck != SQLITE_OK) {
+		std::cerr << "Error committing transaction: " << sqlite3_errmsg(db) << std::endl;
+		rollBackWrites(db);
+	}
+}
+
+// Method to write a batch of archived sightings in one transaction. The batch is staged in temporary tables and
+// merged with set based statements, so the cost is a few statements per batch rather than several per sighting.
+bool DatabaseInterface::ingestSightings(const std::vector<SightingRecord>& records, IngestCounts& added) {
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
+	sqlite3* db = getDB();
+	if (!db) return false;
+
+	auto run = [db](const char* query) {
+		return sqlite3_exec(db, query, nullptr, nullptr, nullptr) == SQLITE_OK;
+	};
+
+	if (!run("BEGIN TRANSACTION;")) {
+		std::cerr << "Error starting transaction: " << sqlite3_errmsg(db) << std::endl;
+		return false;
+	}
+
+	bool ok = run(STAGING_SCHEMA);
+	size_t fullInserts = records.size() / STAGED_ROWS_PER_INSERT;
+	size_t remainder = records.size() % STAGED_ROWS_PER_INSERT;
+	sqlite3_stmt* stmt;
+	if (ok && fullInserts > 0) {
+		ok = sqlite3_prepare_v2(db, stagingInsert(STAGED_ROWS_PER_INSERT).c_str(), -1, &stmt, nullptr) == SQLITE_OK;
+		for (size_t i = 0; ok && i < fullInserts; i++) {
+			ok = stageRecords(stmt, &records[i * STAGED_ROWS_PER_INSERT], STAGED_ROWS_PER_INSERT);
 		}
 		sqlite3_finalize(stmt);
+	}
+	if (ok && remainder > 0) {
+		ok = sqlite3_prepare_v2(db, stagingInsert(remainder).c_str(), -1, &stmt, nullptr) == SQLITE_OK
+			&& stageRecords(stmt, &records[fullInserts * STAGED_ROWS_PER_INSERT], remainder);
+		sqlite3_finalize(stmt);
+	}
 
-		int pokemonID = getPokemonID(trainerID, p.getName());
+	IngestCounts batch;
+	ok = ok && run(UPSERT_STAGED_TRAINERS);
+	if (ok) batch.trainers = sqlite3_changes(db);
+	ok = ok && run(STAGE_POKEMON) && run(FIND_STAGED_POKEMON) && insertStagedPokemon(db, batch.pokemon);
+	for (const char* query : INSERT_STAGED_SIGHTINGS) {
+		ok = ok && run(query);
+		if (ok) batch.sightings += sqlite3_changes(db);
+	}
 
-		for (const std::string& move : p.getSeenMoves()) {
-			addSeenMove(pokemonID, move);
-		}
+	if (!ok) {
+		std::cerr << "Error ingesting sightings: " << sqlite3_errmsg(db) << std::endl;
+		run("ROLLBACK;");
+		return false;
+	}
+	if (!run("COMMIT;")) {
+		std::cerr << "Error committing transaction: " << sqlite3_errmsg(db) << std::endl;
+		run("ROLLBACK;"); // Otherwise the next BEGIN fails as well
+		return false;
+	}
+	if (TrainerKnowledge::shared().isLoaded()) TrainerKnowledge::shared().load(db); // Set based writes are not followed row by row
+	added.trainers += batch.trainers;
+	added.pokemon += batch.pokemon;
+	added.sightings += batch.sightings;
+	return true;
+}
 
-		if (!p.getSeenAbility().empty()) {
-			addSeenAbility(pokemonID, p.getSeenAbility());
-		}
+// Reads an archived session, one sighting per line as trainer|pokemon or trainer|pokemon|move, ability or item|name.
+bool readSightingArchive(const std::string& archivePath, std::vector<SightingRecord>& records) {
+	std::ifstream file(archivePath);
+	if (!file) {
+		std::cerr << "Error opening archive: " << archivePath << std::endl;
+		return false;
+	}
+
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
 
-		if (!p.getSeenItem().empty()) {
-			addSeenItem(pokemonID, p.getSeenItem());
+		std::istringstream fields(line);
+		SightingRecord record;
+		std::string kind;
+		std::getline(fields, record.trainer, '|');
+		std::getline(fields, record.pokemon, '|');
+		bool valid = !record.trainer.empty() && !record.pokemon.empty();
+		if (std::getline(fields, kind, '|')) {
+			std::getline(fields, record.detail, '|');
+			if (kind == "move") record.kind = SightingKind::Move;
+			else if (kind == "ability") record.kind = SightingKind::Ability;
+			else if (kind == "item") record.kind = SightingKind::Item;
+			valid = valid && record.kind != SightingKind::Pokemon && !record.detail.empty();
+		}
+		if (!valid) {
+			std::cerr << archivePath << ":" << lineNumber << ": not a sighting, skipped" << std::endl;
+			continue;
 		}
+		records.push_back(std::move(record));
 	}
+	return true;
+}
 
-	transCheck = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
-	if (transCheck != SQLITE_OK) {
-		std::cerr << "Error committing transaction: " << sqlite3_errmsg(db) << std::endl;
+// Method to fill the trainer knowledge cache from the database, after which scouting a trainer takes no queries.
+bool DatabaseInterface::preloadKnowledge(const std::string& snapshotPath) {
+	ReadConnection reader = openReader(); // Battles can still be saved while it loads
+	if (!snapshotPath.empty()) {
+		KnowledgeSnapshot snapshot;
+		if (snapshot.open(snapshotPath) && snapshot.isCurrent(reader.get())) return TrainerKnowledge::shared().load(snapshot);
+	}
+	if (!TrainerKnowledge::shared().load(reader.get())) return false;
+	if (!snapshotPath.empty() && !KnowledgeSnapshot::exportFrom(reader.get(), snapshotPath)) {
+		// Not fatal, every reader checks the snapshot against the database and loads by query when it is stale.
+		std::cerr << "Warning: knowledge snapshot " << snapshotPath << " is out of date and could not be rewritten, so every"
+			<< " run will load by query until it is. Close other programs that have it open." << std::endl;
 	}
+	return true;
+}
+
+bool DatabaseInterface::refreshSnapshot(const std::string& snapshotPath, bool* exported) {
+	ReadConnection reader = openReader();
+	if (!reader) return false;
+	return KnowledgeSnapshot::refresh(reader.get(), snapshotPath, exported);
 }
 
-// Method to close a database connection. It checks if the database is open and closes it if it is.
+// Method to close a database connection. Its cached statements are finalized first, as SQLite will not close a connection that still has any.
 void DatabaseInterface::closeDB() {
-	sqlite3* db = getDB();
-	if (db) {
-		sqlite3_close(db);
+	std::lock_guard<std::recursive_mutex> guard(connection.lock);
+	if (!connection.db) return;
+	for (sqlite3_stmt*& stmt : connection.statements) {
+		sqlite3_finalize(stmt);
+		stmt = nullptr;
 	}
-}
\ No newline at end of file
+	sqlite3_close(connection.db);
+	connection.db = nullptr;
+
+	std::lock_guard<std::mutex> readersGuard(readers.lock);
+	for (sqlite3* db : readers.idle) sqlite3_close(db);
+	readers.idle.clear();
+	readers.path.clear();
+	readers.generation++;
+}
@@ -0,0 +1,99 @@
+/*
+Versioned schema migrations, applied when the database is opened.
+*/
+
+#include "databasemigrations.h"
+#include <iostream>
+#include <string>
+
+const std::vector<Migration>& databaseMigrations() {
+    static const std::vector<Migration> migrations = {
+        { 1, "Create the tables",
+            "CREATE TABLE IF NOT EXISTS Trainers ("
+            " trainer_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            " name TEXT UNIQUE NOT NULL,"
+            " streak INTEGER DEFAULT -1);"
+            "CREATE TABLE IF NOT EXISTS Pokemon ("
+            " pokemon_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            " trainer_id INTEGER NOT NULL,"
+            " name TEXT,"
+            " FOREIGN KEY (trainer_id) REFERENCES Trainers(trainer_id));"
+            "CREATE TABLE IF NOT EXISTS SeenMoves ("
+            " pokemon_id INTEGER,"
+            " move TEXT,"
+            " PRIMARY KEY (pokemon_id, move),"
+            " FOREIGN KEY (pokemon_id) REFERENCES Pokemon(pokemon_id) ON DELETE CASCADE);"
+            "CREATE TABLE IF NOT EXISTS SeenItems ("
+            " pokemon_id INTEGER,"
+            " item TEXT,"
+            " PRIMARY KEY (pokemon_id, item),"
+            " FOREIGN KEY (pokemon_id) REFERENCES Pokemon(pokemon_id) ON DELETE CASCADE);"
+            "CREATE TABLE IF NOT EXISTS SeenAbilities ("
+            " pokemon_id INTEGER,"
+            " ability TEXT,"
+            " PRIMARY KEY (pokemon_id, ability),"
+            " FOREIGN KEY (pokemon_id) REFERENCES Pokemon(pokemon_id) ON DELETE CASCADE);" },
+
+        // Without a unique (trainer_id, name) every battle added the team again. The copies are merged into the first
+        // row, their sightings moved over to it, and the empty placeholder slots of unfilled teams dropped.
+        { 2, "Merge duplicate Pokemon and make (trainer_id, name) unique",
+            "CREATE TEMP TABLE PokemonMerge AS"
+            " SELECT p.pokemon_id AS old_id, k.keep_id FROM Pokemon p"
+            " JOIN (SELECT trainer_id, name, MIN(pokemon_id) AS keep_id FROM Pokemon GROUP BY trainer_id, name) k"
+            " ON k.trainer_id = p.trainer_id AND k.name IS p.name"
+            " WHERE p.pokemon_id <> k.keep_id;"
+            "INSERT OR IGNORE INTO SeenMoves(pokemon_id, move)"
+            " SELECT m.keep_id, s.move FROM SeenMoves s JOIN temp.PokemonMerge m ON m.old_id = s.pokemon_id;"
+            "INSERT OR IGNORE INTO SeenAbilities(pokemon_id, ability)"
+            " SELECT m.keep_id, s.ability FROM SeenAbilities s JOIN temp.PokemonMerge m ON m.old_id = s.pokemon_id;"
+            "INSERT OR IGNORE INTO SeenItems(pokemon_id, item)"
+            " SELECT m.keep_id, s.item FROM SeenItems s JOIN temp.PokemonMerge m ON m.old_id = s.pokemon_id;"
+            "INSERT INTO temp.PokemonMerge(old_id) SELECT pokemon_id FROM Pokemon WHERE name IS NULL OR name = '';"
+            "DELETE FROM SeenMoves WHERE pokemon_id IN (SELECT old_id FROM temp.PokemonMerge);"
+            "DELETE FROM SeenAbilities WHERE pokemon_id IN (SELECT old_id FROM temp.PokemonMerge);"
+            "DELETE FROM SeenItems WHERE pokemon_id IN (SELECT old_id FROM temp.PokemonMerge);"
+            "DELETE FROM Pokemon WHERE pokemon_id IN (SELECT old_id FROM temp.PokemonMerge);"
+            "DROP TABLE temp.PokemonMerge;"
+            "CREATE UNIQUE INDEX PokemonByTrainer ON Pokemon(trainer_id, name);" }
+    };
+    return migrations;
+}
+
+int latestSchemaVersion() {
+    return databaseMigrations().back().version;
+}
+
+int getSchemaVersion(sqlite3* db) {
+    sqlite3_stmt* stmt;
+    int version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+bool migrateDatabase(sqlite3* db, int targetVersion) {
+    int version = getSchemaVersion(db);
+    if (version < 0) {
+        std::cerr << "Error reading schema version: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    for (const Migration& migration : databaseMigrations()) {
+        if (migration.version <= version || migration.version > targetVersion) continue;
+
+        std::string script = std::string("BEGIN;") + migration.sql + "PRAGMA user_version = " + std::to_string(migration.version) + ";COMMIT;";
+        char* error = nullptr;
+        if (sqlite3_exec(db, script.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::cerr << "Error migrating database to version " << migration.version << " (" << migration.description << "): "
+                << (error ? error : sqlite3_errmsg(db)) << std::endl;
+            sqlite3_free(error);
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+        std::cout << "Database migrated to version " << migration.version << ": " << migration.description << std::endl;
+        version = migration.version;
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+/*
+Write-behind persistence: battle snapshots are queued by the reading threads and committed in batches on a writer thread.
+*/
+
+#include "databasewriter.h"
+
+DatabaseWriter::DatabaseWriter(size_t capacity) : pending(capacity), stopped(false), stopRequested(false), writerRunning(true), flushWaiters(0),
+    snapshotsQueued(0), snapshotsTaken(0), snapshotsWritten(0), batchesWritten(0) {
+    writerThread = std::thread(&DatabaseWriter::writerLoop, this);
+}
+
+DatabaseWriter::~DatabaseWriter() {
+    stop();
+}
+
+// Holds stopLock until the queue is drained, so an enqueue either finishes queueing before the stop or waits for it and
+// then writes its snapshot itself.
+void DatabaseWriter::stop() {
+    std::lock_guard<std::mutex> guard(stopLock);
+    if (stopped) return;
+    stopped = true;
+    stopRequested = true;
+    notify(wakeWriter);
+    writerThread.join();
+
+    // The writer exits once it finds the queue empty, anything still there is written here.
+    std::vector<TrainerSnapshot> late;
+    TrainerSnapshot snapshot;
+    while (pending.tryPop(snapshot)) late.push_back(std::move(snapshot));
+    if (!late.empty()) {
+        DatabaseInterface::persistTrainerSnapshots(late);
+        snapshotsWritten += late.size();
+    }
+    writerRunning = false;
+    notify(batchWritten);
+}
+
+// The state a waiter checks is changed before this takes the lock, so the waiter has either seen the change or is
+// already waiting when the notification comes.
+void DatabaseWriter::notify(std::condition_variable& condition) {
+    {
+        std::lock_guard<std::mutex> guard(wakeLock);
+    }
+    condition.notify_all();
+}
+
+void DatabaseWriter::enqueue(TrainerSnapshot&& snapshot) {
+    std::lock_guard<std::mutex> guard(stopLock);
+    if (stopped) { // No thread left to write it
+        DatabaseInterface::persistTrainerSnapshots({ snapshot });
+        snapshotsQueued++;
+        snapshotsWritten++;
+        return;
+    }
+    pending.push(std::move(snapshot));
+    snapshotsQueued++;
+    notify(wakeWriter);
+}
+
+void DatabaseWriter::setSnapshotPath(const std::string& path) {
+    std::lock_guard<std::mutex> guard(snapshotLock);
+    snapshotPath = path;
+}
+
+void DatabaseWriter::flush() {
+    uint64_t target = snapshotsQueued;
+    std::unique_lock<std::mutex> lock(wakeLock);
+    if (snapshotsWritten >= target || !writerRunning) return;
+    flushWaiters++;
+    wakeWriter.notify_all();
+    batchWritten.wait(lock, [this, target] { return snapshotsWritten >= target || !writerRunning; });
+    flushWaiters--;
+}
+
+// Drains the queue into a batch and writes the batch when it is full, old enough, or when the queue is empty and
+// someone is waiting for it: a flush or the destructor. The snapshot is refreshed before the batch counts as written,
+// so a flush also waits for it.
+void DatabaseWriter::writerLoop() {
+    std::vector<TrainerSnapshot> batch;
+    auto batchStarted = std::chrono::steady_clock::now();
+    for (;;) {
+        TrainerSnapshot snapshot;
+        bool popped = pending.tryPop(snapshot);
+        if (popped) {
+            snapshotsTaken++;
+            if (batch.empty()) batchStarted = std::chrono::steady_clock::now();
+            batch.push_back(std::move(snapshot));
+        }
+
+        bool stopping = stopRequested;
+        bool due = batch.size() >= MAX_BATCH || std::chrono::steady_clock::now() - batchStarted >= FLUSH_INTERVAL
+            || (!popped && (stopping || flushWaiters > 0));
+        if (!batch.empty() && due) {
+            DatabaseInterface::persistTrainerSnapshots(batch);
+            std::string snapshot;
+            {
+                std::lock_guard<std::mutex> guard(snapshotLock);
+                snapshot = snapshotPath;
+            }
+            if (!snapshot.empty()) DatabaseInterface::refreshSnapshot(snapshot);
+            snapshotsWritten += batch.size();
+            batchesWritten++;
+            batch.clear();
+            notify(batchWritten);
+        }
+
+        if (!popped) {
+            if (stopping) break;
+            std::unique_lock<std::mutex> lock(wakeLock);
+            auto wake = [this, &batch] { return stopRequested || snapshotsQueued > snapshotsTaken || (flushWaiters > 0 && !batch.empty()); };
+            if (batch.empty()) wakeWriter.wait(lock, wake);
+            else wakeWriter.wait_until(lock, batchStarted + FLUSH_INTERVAL, wake);
+        }
+    }
+}
+
+uint64_t DatabaseWriter::getSnapshotsWritten() const {
+    return snapshotsWritten;
+}
+
+uint64_t DatabaseWriter::getBatchesWritten() const {
+    return batchesWritten;
+}
+
+DatabaseWriter& DatabaseWriter::shared() {
+    static DatabaseWriter writer;
+    return writer;
+}
@@ -0,0 +1,58 @@
+#include "dialoguechangedetector.h"
+#include <algorithm>
+#include <cstdlib>
+
+DialogueChangeDetector::DialogueChangeDetector(int cellSize, int cellTolerance)
+    : cellSize(cellSize > 0 ? cellSize : 1), cellTolerance(cellTolerance), framesSkipped(0), framesProcessed(0) {}
+
+bool DialogueChangeDetector::hasChanged(const cv::Mat& dialogueCrop) {
+    if (dialogueCrop.empty()) { // Box outside the frame, nothing to compare against next time either
+        previousFingerprint.release();
+        framesProcessed++;
+        return true;
+    }
+
+    cv::Mat gray, fingerprint;
+    if (dialogueCrop.channels() == 3) {
+        cv::cvtColor(dialogueCrop, gray, cv::COLOR_BGR2GRAY);
+    }
+    else {
+        gray = dialogueCrop;
+    }
+    cv::Size gridSize(std::max(1, gray.cols / cellSize), std::max(1, gray.rows / cellSize));
+    cv::resize(gray, fingerprint, gridSize, 0, 0, cv::INTER_AREA); // Area interpolation averages each cell
+
+    bool changed = previousFingerprint.empty() || previousFingerprint.size() != fingerprint.size();
+    for (int y = 0; y < fingerprint.rows && !changed; ++y) {
+        const uchar* current = fingerprint.ptr<uchar>(y);
+        const uchar* previous = previousFingerprint.ptr<uchar>(y);
+        for (int x = 0; x < fingerprint.cols; ++x) {
+            if (std::abs(current[x] - previous[x]) > cellTolerance) {
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    previousFingerprint = fingerprint;
+    if (changed) framesProcessed++;
+    else framesSkipped++;
+    return changed;
+}
+
+void DialogueChangeDetector::reset() {
+    previousFingerprint.release();
+}
+
+uint64_t DialogueChangeDetector::getFramesSkipped() const {
+    return framesSkipped;
+}
+
+uint64_t DialogueChangeDetector::getFramesProcessed() const {
+    return framesProcessed;
+}
+
+double DialogueChangeDetector::getSkipRate() const {
+    uint64_t total = framesSkipped + framesProcessed;
+    return total > 0 ? static_cast<double>(framesSkipped) / total : 0.0;
+}
@@ -0,0 +1,60 @@
+/*
+Line stabilization between the dialogue detectors and OCR: a line is read once, when it has finished printing.
+*/
+
+#include "dialoguelinestabilizer.h"
+
+DialogueLineStabilizer::DialogueLineStabilizer(int stableFrames)
+    : stableFrames(stableFrames > 0 ? stableFrames : 1), glyphColumns(0), unchangedFrames(0), read(false),
+    linesReady(0), framesPrinting(0), framesRead(0) {}
+
+LineStatus DialogueLineStabilizer::observe(bool boxChanged, int glyphColumns) {
+    if (glyphColumns <= 0) {
+        reset();
+        return LineStatus::Blank;
+    }
+
+    // Any change starts the count again, growing text as well as a scroll or a new line with as many columns.
+    if (boxChanged || glyphColumns != this->glyphColumns) {
+        this->glyphColumns = glyphColumns;
+        unchangedFrames = 1;
+        read = false;
+    }
+    else {
+        unchangedFrames++;
+    }
+
+    if (read) {
+        framesRead++;
+        return LineStatus::Read;
+    }
+    if (unchangedFrames >= stableFrames) {
+        read = true;
+        linesReady++;
+        return LineStatus::Ready;
+    }
+    framesPrinting++;
+    return LineStatus::Printing;
+}
+
+void DialogueLineStabilizer::rearm() {
+    read = false;
+}
+
+void DialogueLineStabilizer::reset() {
+    glyphColumns = 0;
+    unchangedFrames = 0;
+    read = false;
+}
+
+uint64_t DialogueLineStabilizer::getLinesReady() const {
+    return linesReady;
+}
+
+uint64_t DialogueLineStabilizer::getFramesPrinting() const {
+    return framesPrinting;
+}
+
+uint64_t DialogueLineStabilizer::getFramesRead() const {
+    return framesRead;
+}
@@ -0,0 +1,129 @@
+/*
+Dialogue triggers as data: a facility's table of (state, pattern, action, next state) compiled into a token trie.
+*/
+
+#include "dialoguestatemachine.h"
+#include <algorithm>
+
+namespace {
+    const std::string_view WILDCARD = "*";
+    const std::string_view ANY_START = "...";
+
+    uint64_t transitionKey(int node, int word) {
+        return static_cast<uint64_t>(node) << 32 | static_cast<uint32_t>(word);
+    }
+
+    struct ActiveMatch {
+        int node;
+        size_t firstToken;
+    };
+}
+
+DialogueStateMachine::DialogueStateMachine(const std::vector<DialogueTrigger>& facilityTriggers) : triggers(facilityTriggers) {
+    for (size_t index = 0; index < triggers.size(); index++) {
+        const DialogueTrigger& trigger = triggers[index];
+        if (trigger.state < 0) continue;
+        if (static_cast<size_t>(trigger.state) >= roots.size()) roots.resize(trigger.state + 1);
+
+        std::string_view pattern = trigger.pattern;
+        bool floating = pattern.substr(0, ANY_START.size()) == ANY_START;
+        if (floating) pattern.remove_prefix(ANY_START.size());
+
+        int& root = floating ? roots[trigger.state].floating : roots[trigger.state].anchored;
+        if (root < 0) root = addNode();
+
+        int node = root;
+        size_t position = 0;
+        while (position < pattern.size()) {
+            size_t space = pattern.find(' ', position);
+            if (space == std::string_view::npos) space = pattern.size();
+            std::string_view word = pattern.substr(position, space - position);
+            position = space + 1;
+            if (word.empty()) continue;
+
+            if (word == WILDCARD) {
+                if (nodes[node].wildcard < 0) {
+                    int next = addNode();
+                    nodes[node].wildcard = next;
+                }
+                node = nodes[node].wildcard;
+                continue;
+            }
+            int wordId = wordIds.emplace(word, static_cast<int>(wordIds.size())).first->second;
+            int next = child(node, wordId);
+            if (next < 0) {
+                next = addNode();
+                transitions.emplace(transitionKey(node, wordId), next);
+            }
+            node = next;
+        }
+        if (nodes[node].trigger < 0) nodes[node].trigger = static_cast<int>(index);
+    }
+}
+
+int DialogueStateMachine::addNode() {
+    nodes.emplace_back();
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+int DialogueStateMachine::child(int node, int word) const {
+    auto found = transitions.find(transitionKey(node, word));
+    return found != transitions.end() ? found->second : -1;
+}
+
+bool DialogueStateMachine::match(int state, const DialogueTokenizer& tokens, TriggerMatch& found) const {
+    if (state < 0 || static_cast<size_t>(state) >= roots.size()) return false;
+    const Roots& stateRoots = roots[state];
+
+    int best = -1;
+    auto consider = [&](int node, size_t firstToken, size_t endToken) {
+        int trigger = nodes[node].trigger;
+        if (trigger < 0 || (best >= 0 && trigger >= best)) return;
+        best = trigger;
+        found.trigger = &triggers[trigger];
+        found.firstToken = firstToken;
+        found.endToken = endToken;
+    };
+
+    ActiveMatch active[MAX_ACTIVE], advanced[MAX_ACTIVE];
+    size_t activeCount = 0;
+    if (stateRoots.anchored >= 0) {
+        active[activeCount++] = { stateRoots.anchored, 0 };
+        consider(stateRoots.anchored, 0, 0);
+    }
+
+    for (size_t token = 0; token < tokens.size() && (activeCount > 0 || stateRoots.floating >= 0); token++) {
+        if (stateRoots.floating >= 0 && activeCount < MAX_ACTIVE) active[activeCount++] = { stateRoots.floating, token };
+
+        auto word = wordIds.find(tokens[token]);
+        size_t advancedCount = 0;
+        for (size_t i = 0; i < activeCount; i++) {
+            int next[2] = { word != wordIds.end() ? child(active[i].node, word->second) : -1, nodes[active[i].node].wildcard };
+            for (int node : next) {
+                if (node < 0 || advancedCount == MAX_ACTIVE) continue;
+                advanced[advancedCount++] = { node, active[i].firstToken };
+                consider(node, active[i].firstToken, token + 1);
+            }
+        }
+        std::copy(advanced, advanced + advancedCount, active);
+        activeCount = advancedCount;
+    }
+    return best >= 0;
+}
+
+const std::vector<DialogueTrigger>& battleTowerSingles() {
+    static const std::vector<DialogueTrigger> triggers = {
+        { 0, "I WILL NOW SHOW YOU TO THE SINGLE", DialogueAction::AnnounceStreak, 1 },
+        { 0, "YOU WILL BE FACING OPPONENT", DialogueAction::AnnounceStreak, 1 },
+        { 1, "", DialogueAction::StartBattle, 2 },
+        // Trainer Pokemon being sent out has a set dialogue, so user Pokemon are not mistaken for the trainer's.
+        { 2, "... SENT OUT *", DialogueAction::SendOutPokemon, 3 },
+        { 2, "CONGRATULATIONS YOU'VE BEATEN ALL", DialogueAction::WinStreak, 0 },
+        { 2, "YOU HAVE BEEN DEFEATED", DialogueAction::LoseStreak, 0 }, // Placeholder, the real losing dialogue is not known yet
+        { 2, "WE WILL RESTORE YOUR", DialogueAction::DefeatTrainer, 1 },
+        { 3, "FOE * FAINTED", DialogueAction::FoeFainted, 2 },
+        { 3, "FOE", DialogueAction::RevealDetail, -1 },
+        { 3, "USING", DialogueAction::RevealDetail, -1 },
+    };
+    return triggers;
+}
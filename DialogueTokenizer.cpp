@@ -0,0 +1,78 @@
+/*
+Tokenizer for OCR dialogue lines that hands out views into one reused buffer.
+*/
+
+#include "dialoguetokenizer.h"
+#include <cctype>
+
+namespace {
+    bool isSpace(char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
+    }
+
+    bool isTrailingPunctuation(char c) {
+        return c == '!' || c == ',';
+    }
+}
+
+DialogueTokenizer::DialogueTokenizer() : count(0) {
+    buffer.reserve(MAX_LINE_LENGTH);
+}
+
+void DialogueTokenizer::tokenize(std::string_view dialogue) {
+    // Sized up front, within the reserved capacity, so the buffer never moves while views into it are taken. The
+    // joined words are never longer than the line they came from.
+    dialogue = dialogue.substr(0, MAX_LINE_LENGTH);
+    buffer.resize(dialogue.size());
+    count = 0;
+
+    size_t length = 0;
+    size_t position = 0;
+    while (position < dialogue.size() && count < MAX_TOKENS) {
+        while (position < dialogue.size() && isSpace(dialogue[position])) position++;
+        size_t wordStart = position;
+        while (position < dialogue.size() && !isSpace(dialogue[position])) position++;
+        size_t wordEnd = position;
+        while (wordEnd > wordStart && isTrailingPunctuation(dialogue[wordEnd - 1])) wordEnd--;
+        if (wordEnd == wordStart) continue;
+
+        if (length > 0) buffer[length++] = ' ';
+        size_t tokenStart = length;
+        for (size_t i = wordStart; i < wordEnd; i++) {
+            buffer[length++] = static_cast<char>(std::toupper(static_cast<unsigned char>(dialogue[i])));
+        }
+        tokens[count++] = std::string_view(buffer.data() + tokenStart, length - tokenStart);
+    }
+    buffer.resize(length); // Shrinking keeps the storage, the views stay valid
+}
+
+size_t DialogueTokenizer::size() const {
+    return count;
+}
+
+bool DialogueTokenizer::empty() const {
+    return count == 0;
+}
+
+std::string_view DialogueTokenizer::operator[](size_t index) const {
+    return tokens[index];
+}
+
+std::string_view DialogueTokenizer::span(size_t first, size_t length) const {
+    if (length == 0 || first + length > count) return std::string_view();
+    const char* start = tokens[first].data();
+    const std::string_view& last = tokens[first + length - 1];
+    return std::string_view(start, static_cast<size_t>(last.data() + last.size() - start));
+}
+
+std::string_view DialogueTokenizer::text() const {
+    return buffer;
+}
+
+const std::string_view* DialogueTokenizer::begin() const {
+    return tokens.data();
+}
+
+const std::string_view* DialogueTokenizer::end() const {
+    return tokens.data() + count;
+}
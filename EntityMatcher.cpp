@@ -0,0 +1,163 @@
+/*
+Token level Aho-Corasick matcher that finds GameData names in a tokenized dialogue line.
+*/
+
+#include "entitymatcher.h"
+#include "gamedata.h"
+#include <utility>
+
+namespace {
+    const char* const ENTITY_TYPE_NAMES[] = { "trainer", "pokemon", "move", "ability", "item" };
+
+    uint64_t transitionKey(int node, int word) {
+        return static_cast<uint64_t>(node) << 32 | static_cast<uint32_t>(word);
+    }
+
+    template <size_t N>
+    void addList(const std::function<void(EntityType, int, std::string_view)>& add, EntityType type,
+        const GameData::detail::PerfectHashTable<N>& table) {
+        for (size_t id = 0; id < table.size(); id++) add(type, static_cast<int>(id), table.nameOf(static_cast<int>(id)));
+    }
+}
+
+const char* getEntityTypeName(EntityType type) {
+    return ENTITY_TYPE_NAMES[static_cast<size_t>(type)];
+}
+
+void forEachGameDataName(const std::function<void(EntityType, int, std::string_view)>& add) {
+    addList(add, EntityType::Trainer, GameData::trainers);
+    addList(add, EntityType::Pokemon, GameData::pokemon);
+    addList(add, EntityType::Move, GameData::moves);
+    addList(add, EntityType::Ability, GameData::abilities);
+    addList(add, EntityType::Item, GameData::items);
+}
+
+std::string_view getGameDataName(EntityType type, int id) {
+    switch (type) {
+    case EntityType::Trainer: return GameData::trainers.nameOf(id);
+    case EntityType::Pokemon: return GameData::pokemon.nameOf(id);
+    case EntityType::Move: return GameData::moves.nameOf(id);
+    case EntityType::Ability: return GameData::abilities.nameOf(id);
+    case EntityType::Item: return GameData::items.nameOf(id);
+    }
+    return std::string_view();
+}
+
+EntityMatcher::EntityMatcher() : nodes(1), pendingEntities(1), built(false) {}
+
+void EntityMatcher::add(EntityType type, int id, std::string_view name) {
+    int node = 0;
+    size_t position = 0;
+    while (position < name.size()) {
+        size_t space = name.find(' ', position);
+        if (space == std::string_view::npos) space = name.size();
+        std::string_view word = name.substr(position, space - position);
+        position = space + 1;
+        if (word.empty()) continue;
+
+        int wordId = wordIds.emplace(word, static_cast<int>(wordIds.size())).first->second;
+        int next = child(node, wordId);
+        if (next < 0) {
+            next = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+            nodes[next].depth = nodes[node].depth + 1;
+            pendingEntities.emplace_back();
+            transitions.emplace(transitionKey(node, wordId), next);
+        }
+        node = next;
+    }
+    if (node != 0) pendingEntities[node].push_back({ type, id });
+    built = false;
+}
+
+void EntityMatcher::build() {
+    std::vector<std::vector<std::pair<int, int>>> children(nodes.size()); // (word, child)
+    for (const auto& transition : transitions) {
+        children[transition.first >> 32].push_back({ static_cast<int>(transition.first & 0xFFFFFFFFu), transition.second });
+    }
+
+    entities.clear();
+    for (size_t node = 0; node < nodes.size(); node++) {
+        nodes[node].entityBegin = static_cast<int>(entities.size());
+        nodes[node].entityCount = static_cast<int>(pendingEntities[node].size());
+        entities.insert(entities.end(), pendingEntities[node].begin(), pendingEntities[node].end());
+    }
+
+    // Breadth first, so the fail target of every node is finished before the node itself.
+    std::vector<int> queue(1, 0);
+    nodes[0].fail = 0;
+    nodes[0].match = -1;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int node = queue[head];
+        for (const auto& edge : children[node]) {
+            int word = edge.first;
+            int next = edge.second;
+            int fail = 0;
+            if (node != 0) {
+                fail = nodes[node].fail;
+                while (fail != 0 && child(fail, word) < 0) fail = nodes[fail].fail;
+                int target = child(fail, word);
+                fail = target >= 0 ? target : 0;
+            }
+            nodes[next].fail = fail;
+            nodes[next].match = nodes[next].entityCount > 0 ? next : nodes[fail].match;
+            queue.push_back(next);
+        }
+    }
+    built = true;
+}
+
+int EntityMatcher::child(int node, int word) const {
+    auto found = transitions.find(transitionKey(node, word));
+    return found != transitions.end() ? found->second : -1;
+}
+
+int EntityMatcher::step(int node, int word) const {
+    while (true) {
+        int next = child(node, word);
+        if (next >= 0) return next;
+        if (node == 0) return 0;
+        node = nodes[node].fail;
+    }
+}
+
+void EntityMatcher::find(const DialogueTokenizer& tokens, std::vector<EntitySpan>& matches, size_t firstToken) const {
+    matches.clear();
+    if (!built) return;
+
+    int node = 0;
+    for (size_t token = firstToken; token < tokens.size(); token++) {
+        auto word = wordIds.find(tokens[token]);
+        if (word == wordIds.end()) {
+            node = 0; // No name contains this word
+            continue;
+        }
+        node = step(node, word->second);
+
+        // Longest name ending at this token first, shorter ones only if it partly overlaps an earlier match.
+        for (int hit = nodes[node].match; hit >= 0; hit = nodes[nodes[hit].fail].match) {
+            size_t start = token + 1 - nodes[hit].depth;
+
+            size_t kept = matches.size();
+            while (kept > 0 && matches[kept - 1].firstToken >= start) kept--; // Matches inside this one give way
+            if (kept > 0 && matches[kept - 1].firstToken + matches[kept - 1].tokenCount > start) continue;
+
+            matches.erase(matches.begin() + kept, matches.end());
+            for (int e = 0; e < nodes[hit].entityCount; e++) {
+                const Entity& entity = entities[nodes[hit].entityBegin + e];
+                matches.push_back({ entity.type, entity.id, start, static_cast<size_t>(nodes[hit].depth) });
+            }
+            break;
+        }
+    }
+}
+
+const EntityMatcher& EntityMatcher::gameData() {
+    static const EntityMatcher matcher = [] {
+        EntityMatcher names;
+        forEachGameDataName([&names](EntityType type, int id, std::string_view name) { names.add(type, id, name); });
+        names.build();
+        return names;
+    }();
+    return matcher;
+}
@@ -0,0 +1,293 @@
+/*
+Multi-threaded frame processing pipeline: capture -> crop + preprocess -> OCR -> battle state machine.
+*/
+
+#include "framepipeline.h"
+#include "imageprocessing.h"
+#include "stagetimer.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Stages sleep briefly instead of spinning when their input queue is empty, frames only arrive a few times a second.
+    void waitForInput() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Streak readings below this are more likely a screen without the counter than a misread digit.
+    const float MIN_STREAK_CONFIDENCE = 0.5f;
+
+    int confidentStreak(const StreakReading& reading) {
+        return reading.value >= 0 && reading.confidence >= MIN_STREAK_CONFIDENCE ? reading.value : -1;
+    }
+}
+
+FramePipeline::FramePipeline(BattleLogic& battleLogic, OcrBackend& dialogueOcr, size_t ocrWorkers, size_t queueCapacity,
+    bool dropWhenBehind)
+    : battleLogic(battleLogic), dialogueOcr(dialogueOcr), ocrWorkers(ocrWorkers > 0 ? ocrWorkers : 1), dropWhenBehind(dropWhenBehind),
+    capturedFrames(queueCapacity), preparedFrames(queueCapacity), ocrResults(queueCapacity), freeFrames(queueCapacity + 2),
+    captureDone(false), preprocessDone(false), ocrWorkersRunning(0), streakWanted(true), battleState(0), facilityLevel(0), dialogueGlyphColumns(0),
+    captureLayout(defaultLayoutProfile()), frameLayout(defaultLayoutProfile()), nativeMultiple(0),
+    framesCaptured(0), framesDropped(0), framesProcessed(0), linesEmitted(0) {}
+
+void FramePipeline::setLayout(const LayoutProfile& layout, int nativeMultiple) {
+    captureLayout = layout;
+    this->nativeMultiple = nativeMultiple > 0 ? nativeMultiple : 0;
+    frameLayout = this->nativeMultiple > 0 ? layout.scaledToNative(this->nativeMultiple) : layout;
+}
+
+void FramePipeline::setStreakReader(const StreakReader& reader) {
+    streakReader = reader;
+}
+
+void FramePipeline::setLineObserver(const LineObserver& observer) {
+    lineObserver = observer;
+}
+
+void FramePipeline::run(const FrameProvider& nextFrame) {
+    captureDone = false;
+    preprocessDone = false;
+    ocrWorkersRunning = ocrWorkers;
+    streakWanted = battleLogic.getCurrentStreak() < 0 && battleLogic.getState() == 0;
+    battleState = battleLogic.getState();
+    facilityLevel = battleLogic.getFacilityLevel();
+    changeDetector.reset();
+    lineStabilizer.reset();
+    dialogueGlyphColumns = 0;
+    lastLineText.clear();
+
+    std::thread stateMachineThread(&FramePipeline::stateMachineStage, this);
+    std::vector<std::thread> ocrThreads;
+    for (size_t i = 0; i < ocrWorkers; ++i) {
+        ocrThreads.emplace_back(&FramePipeline::ocrStage, this);
+    }
+    std::thread preprocessThread(&FramePipeline::preprocessStage, this);
+    std::thread captureThread(&FramePipeline::captureStage, this, std::cref(nextFrame));
+
+    captureThread.join();
+    preprocessThread.join();
+    for (auto& thread : ocrThreads) {
+        thread.join();
+    }
+    stateMachineThread.join();
+}
+
+// Stage 1: pulls frames from the provider and tags them with a sequence number. Waits for room when the
+// preprocess stage is behind, frames are only ever dropped in front of OCR.
+void FramePipeline::captureStage(const FrameProvider& nextFrame) {
+    uint64_t sequence = 0;
+    const auto start = std::chrono::steady_clock::now();
+    cv::Mat frame;
+    for (;;) {
+        if (!freeFrames.tryPop(frame)) {
+            frame = cv::Mat(); // Nothing to recycle yet, the provider allocates
+        }
+        if (!nextFrame(frame)) break;
+
+        CapturedFrame captured;
+        captured.sequence = sequence++;
+        captured.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        captured.image = std::move(frame); // This buffer now belongs to the queue until preprocess returns it
+        capturedFrames.push(std::move(captured));
+        framesCaptured++;
+    }
+    captureDone = true;
+}
+
+// Stage 2: crops and thresholds the dialogue box for OCR and reads the streak counter directly, it needs no OCR. If OCR is behind, the oldest waiting frame is dropped
+// and a placeholder is sent straight to the state machine so its reordering does not wait on it. Only a frame whose line
+// has just finished printing goes through preprocessing and OCR.
+void FramePipeline::preprocessStage() {
+    CapturedFrame captured;
+    for (;;) {
+        if (!capturedFrames.tryPop(captured)) {
+            if (!captureDone) {
+                waitForInput();
+                continue;
+            }
+            if (!capturedFrames.tryPop(captured)) break;
+        }
+
+        PreparedFrame prepared;
+        prepared.sequence = captured.sequence;
+        prepared.timestamp = captured.timestamp;
+        const cv::Mat* frame = &captured.image;
+        cv::Mat dialogueCrop;
+        {
+            ScopedStageTimer timer(PipelineStage::Crop);
+            if (nativeMultiple > 0) {
+                downscaleToNative(captured.image, captureLayout, nativeMultiple, nativeFrame);
+                frame = &nativeFrame;
+            }
+            dialogueCrop = cropToDialogue(*frame, frameLayout);
+        }
+
+        {
+            ScopedStageTimer timer(PipelineStage::Detect);
+            bool changed = changeDetector.hasChanged(dialogueCrop);
+            if (changed) {
+                dialogueGlyphColumns = blankDetector.hasText(dialogueCrop) ? blankDetector.getGlyphColumns() : 0;
+            }
+            prepared.line = lineStabilizer.observe(changed, dialogueGlyphColumns);
+        }
+        if (prepared.line == LineStatus::Ready) {
+            ScopedStageTimer timer(PipelineStage::Preprocess);
+            prepared.dialogue = preprocessImage(dialogueCrop);
+        }
+        if (streakWanted) {
+            // Both counters until BattleLogic has told which level is being challenged, then only that one.
+            ScopedStageTimer timer(PipelineStage::Streak);
+            const int level = facilityLevel;
+            prepared.hasStreak = true;
+            if (level != 100) prepared.streak = streakReader.read(*frame, "50", frameLayout);
+            if (level != 50) prepared.openStreak = streakReader.read(*frame, "100", frameLayout);
+        }
+        // Give the buffer back to capture. The crops above still point into it but are not read again.
+        freeFrames.tryPush(std::move(captured.image));
+        captured.image = cv::Mat();
+
+        if (!dropWhenBehind) {
+            preparedFrames.push(std::move(prepared));
+            continue;
+        }
+
+        // Every evicted frame gets its placeholder, or the state machine would wait for its sequence number forever.
+        preparedFrames.pushDropOldest(std::move(prepared), [this](PreparedFrame&& evicted) {
+            OcrResult placeholder;
+            placeholder.sequence = evicted.sequence;
+            placeholder.timestamp = evicted.timestamp;
+            placeholder.dropped = true;
+            placeholder.line = evicted.line;
+            ocrResults.push(std::move(placeholder));
+            framesDropped++;
+            // The line was to be read from the dropped frame. It is still on screen, so read it from the next one.
+            if (evicted.line == LineStatus::Ready) lineStabilizer.rearm();
+        });
+    }
+    preprocessDone = true;
+}
+
+// Stage 3: dialogue OCR, the slowest stage. Several workers can run at once.
+// The dialogue backend must be safe to call from every worker.
+void FramePipeline::ocrStage() {
+    PreparedFrame prepared;
+    for (;;) {
+        if (!preparedFrames.tryPop(prepared)) {
+            if (!preprocessDone) {
+                waitForInput();
+                continue;
+            }
+            if (!preparedFrames.tryPop(prepared)) break;
+        }
+
+        OcrResult result;
+        result.sequence = prepared.sequence;
+        result.timestamp = prepared.timestamp;
+        result.line = prepared.line;
+        result.hasStreak = prepared.hasStreak;
+        result.streak = prepared.streak;
+        result.openStreak = prepared.openStreak;
+        if (prepared.line == LineStatus::Ready) {
+            ScopedStageTimer timer(PipelineStage::Ocr);
+            result.dialogueText = dialogueOcr.recognize(prepared.dialogue);
+        }
+        ocrResults.push(std::move(result));
+    }
+    ocrWorkersRunning--;
+}
+
+// Stage 4: feeds BattleLogic in capture order. Results from parallel OCR workers are held until every earlier
+// sequence number has arrived, either as a result or as a dropped placeholder.
+void FramePipeline::stateMachineStage() {
+    std::map<uint64_t, OcrResult> pending;
+    uint64_t nextSequence = 0;
+    OcrResult result;
+
+    for (;;) {
+        if (ocrResults.tryPop(result)) {
+            pending.emplace(result.sequence, std::move(result));
+        }
+        else if (ocrWorkersRunning == 0) {
+            if (!ocrResults.tryPop(result)) break;
+            pending.emplace(result.sequence, std::move(result));
+        }
+        else {
+            waitForInput();
+            continue;
+        }
+
+        while (!pending.empty() && pending.begin()->first == nextSequence) {
+            applyResult(pending.begin()->second);
+            pending.erase(pending.begin());
+            nextSequence++;
+        }
+    }
+
+    // Everything has arrived by now, anything left is applied in order.
+    for (auto& entry : pending) {
+        applyResult(entry.second);
+    }
+}
+
+// Hands on each line once: a line read again after the box changed without changing its text is left out, until the
+// box empties and the same text can be a new line.
+void FramePipeline::applyResult(const OcrResult& result) {
+    if (result.line == LineStatus::Blank) {
+        lastLineText.clear();
+    }
+    if (result.dropped) {
+        return;
+    }
+    battleLogic.setFrame(result.sequence, result.timestamp);
+
+    if (result.hasStreak && battleLogic.getCurrentStreak() < 0 && battleLogic.getState() == 0) {
+        battleLogic.handleStreakNumbers(confidentStreak(result.streak), confidentStreak(result.openStreak));
+    }
+
+    if (result.line == LineStatus::Ready && !result.dialogueText.empty() && result.dialogueText != lastLineText) {
+        lastLineText = result.dialogueText;
+        linesEmitted++;
+        if (lineObserver) lineObserver({ lastLineText, result.sequence, result.timestamp });
+        ScopedStageTimer timer(PipelineStage::DialogueLogic);
+        battleLogic.handleDialogueLine(lastLineText);
+    }
+    framesProcessed++;
+    streakWanted = battleLogic.getCurrentStreak() < 0 && battleLogic.getState() == 0;
+    battleState = battleLogic.getState();
+    facilityLevel = battleLogic.getFacilityLevel();
+}
+
+int FramePipeline::getBattleState() const {
+    return battleState;
+}
+
+uint64_t FramePipeline::getFramesCaptured() const {
+    return framesCaptured;
+}
+
+uint64_t FramePipeline::getFramesDropped() const {
+    return framesDropped;
+}
+
+uint64_t FramePipeline::getFramesProcessed() const {
+    return framesProcessed;
+}
+
+uint64_t FramePipeline::getDialogueOcrSkipped() const {
+    return lineStabilizer.getFramesPrinting() + lineStabilizer.getFramesRead();
+}
+
+uint64_t FramePipeline::getDialogueOcrPerformed() const {
+    return lineStabilizer.getLinesReady();
+}
+
+uint64_t FramePipeline::getDialogueBlankSkipped() const {
+    return blankDetector.getFramesBlank();
+}
+
+uint64_t FramePipeline::getLinesEmitted() const {
+    return linesEmitted;
+}
@@ -0,0 +1,353 @@
+/*
+Frame sources: directory and video replay everywhere, window capture on Windows and MIT-SHM screen capture on Linux.
+*/
+
+#include "framesource.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifdef __linux__
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+namespace {
+    // Orders runs of digits by value, so numbered captures replay in the order they were taken.
+    bool naturalLess(const std::string& a, const std::string& b) {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j]))) {
+                size_t endA = i, endB = j;
+                while (endA < a.size() && std::isdigit(static_cast<unsigned char>(a[endA]))) endA++;
+                while (endB < b.size() && std::isdigit(static_cast<unsigned char>(b[endB]))) endB++;
+                unsigned long long numberA = std::strtoull(a.substr(i, endA - i).c_str(), nullptr, 10);
+                unsigned long long numberB = std::strtoull(b.substr(j, endB - j).c_str(), nullptr, 10);
+                if (numberA != numberB) return numberA < numberB;
+                i = endA;
+                j = endB;
+            }
+            else {
+                if (a[i] != b[j]) return a[i] < b[j];
+                i++;
+                j++;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+}
+
+DirectoryFrameSource::DirectoryFrameSource(const std::string& directory, const std::string& pattern) : nextIndex(0) {
+    std::vector<cv::String> found;
+    cv::glob(directory + "/" + pattern, found, false);
+    for (const auto& path : found) paths.push_back(path);
+    std::sort(paths.begin(), paths.end(), naturalLess);
+}
+
+bool DirectoryFrameSource::next(cv::Mat& frame) {
+    while (nextIndex < paths.size()) {
+        const std::string& path = paths[nextIndex++];
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : -1;
+        if (size > 0) {
+            fileBytes.resize(static_cast<size_t>(size));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(fileBytes.data()), size);
+        }
+        if (size <= 0 || !file) {
+            std::cerr << "Error loading: " << path << std::endl;
+            continue;
+        }
+
+        cv::imdecode(fileBytes, cv::IMREAD_COLOR, &frame); // Decodes into frame's buffer when the size matches
+        if (frame.empty()) {
+            std::cerr << "Error decoding: " << path << std::endl;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool DirectoryFrameSource::isLive() const {
+    return false;
+}
+
+const char* DirectoryFrameSource::getName() const {
+    return "directory";
+}
+
+size_t DirectoryFrameSource::getFrameCount() const {
+    return paths.size();
+}
+
+VideoFrameSource::VideoFrameSource(const std::string& path) : capture(path), live(false) {}
+
+VideoFrameSource::VideoFrameSource(int deviceIndex) : capture(deviceIndex), live(true) {}
+
+bool VideoFrameSource::isOpened() const {
+    return capture.isOpened();
+}
+
+bool VideoFrameSource::next(cv::Mat& frame) {
+    return capture.read(frame) && !frame.empty(); // read() decodes into frame's buffer when the size matches
+}
+
+bool VideoFrameSource::isLive() const {
+    return live;
+}
+
+const char* VideoFrameSource::getName() const {
+    return live ? "device" : "video";
+}
+
+#ifdef _WIN32
+struct WindowFrameSource::GdiState {
+    HWND hwnd = NULL;
+    HDC windowDC = NULL;
+    HDC memoryDC = NULL;
+    HBITMAP bitmap = NULL;
+    int width = 0;
+    int height = 0;
+};
+
+WindowFrameSource::WindowFrameSource(const std::wstring& windowTitle) : gdi(std::make_unique<GdiState>()) {
+    gdi->hwnd = FindWindowW(NULL, windowTitle.c_str());
+    if (gdi->hwnd == NULL) {
+        std::cerr << "Error: window not found." << std::endl;
+        return;
+    }
+    gdi->windowDC = GetDC(gdi->hwnd);
+    gdi->memoryDC = CreateCompatibleDC(gdi->windowDC);
+}
+
+WindowFrameSource::~WindowFrameSource() {
+    if (gdi->bitmap) DeleteObject(gdi->bitmap);
+    if (gdi->memoryDC) DeleteDC(gdi->memoryDC);
+    if (gdi->windowDC) ReleaseDC(gdi->hwnd, gdi->windowDC);
+}
+
+bool WindowFrameSource::isOpened() const {
+    return gdi->memoryDC != NULL;
+}
+
+bool WindowFrameSource::next(cv::Mat& frame) {
+    if (!isOpened()) return false;
+
+    RECT rc;
+    if (!GetClientRect(gdi->hwnd, &rc)) return false;
+    int width = rc.right - rc.left;
+    int height = rc.bottom - rc.top;
+    if (width <= 0 || height <= 0) return false; // Minimized
+
+    if (width != gdi->width || height != gdi->height) {
+        if (gdi->bitmap) DeleteObject(gdi->bitmap);
+        gdi->bitmap = CreateCompatibleBitmap(gdi->windowDC, width, height);
+        SelectObject(gdi->memoryDC, gdi->bitmap);
+        gdi->width = width;
+        gdi->height = height;
+    }
+    BitBlt(gdi->memoryDC, 0, 0, width, height, gdi->windowDC, 0, 0, SRCCOPY);
+
+    BITMAPINFO bmi = { 0 };
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // Negative to indicate top-down bitmap
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    bgra.create(height, width, CV_8UC4);
+    if (!GetDIBits(gdi->memoryDC, gdi->bitmap, 0, height, bgra.data, &bmi, DIB_RGB_COLORS)) {
+        std::cerr << "Error: Screenshot capture failed." << std::endl;
+        return false;
+    }
+    cv::cvtColor(bgra, frame, cv::COLOR_BGRA2BGR);
+    return true;
+}
+
+bool WindowFrameSource::isLive() const {
+    return true;
+}
+
+const char* WindowFrameSource::getName() const {
+    return "window";
+}
+#endif
+
+#ifdef __linux__
+namespace {
+    // XShmAttach reports failure, as on a remote display, through the X error handler, whose default exits.
+    bool shmAttachFailed = false;
+
+    int noteShmAttachError(Display*, XErrorEvent*) {
+        shmAttachFailed = true;
+        return 0;
+    }
+}
+
+struct X11ShmFrameSource::ShmState {
+    Display* display = nullptr;
+    ::Window root = 0;
+    XImage* image = nullptr;
+    XShmSegmentInfo segment = {};
+    bool ready = false;    // Display open and region on screen, frames can be read with or without shared memory
+    bool attached = false; // Shared memory image attached, otherwise every frame is copied with XGetImage
+    cv::Rect region;
+};
+
+X11ShmFrameSource::X11ShmFrameSource(const std::string& displayName, const cv::Rect& region) : shm(std::make_unique<ShmState>()) {
+    shm->display = XOpenDisplay(displayName.empty() ? nullptr : displayName.c_str());
+    if (!shm->display) {
+        std::cerr << "Error opening X display: " << (displayName.empty() ? "$DISPLAY" : displayName) << std::endl;
+        return;
+    }
+    int screen = DefaultScreen(shm->display);
+    shm->root = RootWindow(shm->display, screen);
+    XWindowAttributes attributes;
+    XGetWindowAttributes(shm->display, shm->root, &attributes);
+    cv::Rect whole(0, 0, attributes.width, attributes.height);
+    shm->region = region.empty() ? whole : (region & whole);
+    if (shm->region.empty()) {
+        std::cerr << "Error: capture region is outside the X screen." << std::endl;
+        return;
+    }
+    shm->ready = true;
+
+    if (!XShmQueryExtension(shm->display)) {
+        std::cerr << "X server does not support MIT-SHM, capturing with XGetImage." << std::endl;
+        return;
+    }
+    shm->image = XShmCreateImage(shm->display, DefaultVisual(shm->display, screen), DefaultDepth(shm->display, screen), ZPixmap,
+        nullptr, &shm->segment, shm->region.width, shm->region.height);
+    if (!shm->image || shm->image->bits_per_pixel != 32) {
+        std::cerr << "Error: only 32 bit X visuals are supported." << std::endl;
+        shm->ready = false;
+        return;
+    }
+
+    shm->segment.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(shm->image->bytes_per_line) * shm->image->height, IPC_CREAT | 0600);
+    if (shm->segment.shmid < 0) {
+        std::cerr << "Error allocating shared memory for X capture, capturing with XGetImage." << std::endl;
+        return;
+    }
+    void* address = shmat(shm->segment.shmid, nullptr, 0);
+    if (address == reinterpret_cast<void*>(-1)) {
+        std::cerr << "Error attaching shared memory for X capture, capturing with XGetImage." << std::endl;
+        shmctl(shm->segment.shmid, IPC_RMID, nullptr);
+        return;
+    }
+    shm->segment.shmaddr = shm->image->data = static_cast<char*>(address);
+    shm->segment.readOnly = False;
+    shmAttachFailed = false;
+    XErrorHandler previousHandler = XSetErrorHandler(noteShmAttachError);
+    shm->attached = XShmAttach(shm->display, &shm->segment) != 0;
+    XSync(shm->display, False);
+    XSetErrorHandler(previousHandler);
+    shm->attached = shm->attached && !shmAttachFailed;
+    shmctl(shm->segment.shmid, IPC_RMID, nullptr); // Freed by the kernel once both sides have detached
+    if (!shm->attached) {
+        std::cerr << "X server could not attach the shared memory, capturing with XGetImage." << std::endl;
+    }
+}
+
+X11ShmFrameSource::~X11ShmFrameSource() {
+    if (shm->attached) XShmDetach(shm->display, &shm->segment);
+    if (shm->image) {
+        shm->image->data = nullptr; // Shared memory is not XDestroyImage's to free
+        XDestroyImage(shm->image);
+    }
+    if (shm->segment.shmaddr) shmdt(shm->segment.shmaddr);
+    if (shm->display) XCloseDisplay(shm->display);
+}
+
+bool X11ShmFrameSource::isOpened() const {
+    return shm->ready;
+}
+
+bool X11ShmFrameSource::next(cv::Mat& frame) {
+    if (!isOpened()) return false;
+    XImage* image = shm->image;
+    if (shm->attached) {
+        if (!XShmGetImage(shm->display, shm->root, image, shm->region.x, shm->region.y, AllPlanes)) {
+            std::cerr << "Error: Screenshot capture failed." << std::endl;
+            return false;
+        }
+    }
+    else {
+        // A new image from the X server every frame, for displays without shared memory.
+        image = XGetImage(shm->display, shm->root, shm->region.x, shm->region.y, shm->region.width, shm->region.height, AllPlanes, ZPixmap);
+        if (!image || image->bits_per_pixel != 32) {
+            std::cerr << (image ? "Error: only 32 bit X visuals are supported." : "Error: Screenshot capture failed.") << std::endl;
+            if (image) XDestroyImage(image);
+            return false;
+        }
+    }
+    cv::Mat bgra(image->height, image->width, CV_8UC4, image->data, static_cast<size_t>(image->bytes_per_line));
+    cv::cvtColor(bgra, frame, cv::COLOR_BGRA2BGR);
+    if (image != shm->image) XDestroyImage(image);
+    return true;
+}
+
+bool X11ShmFrameSource::isLive() const {
+    return true;
+}
+
+const char* X11ShmFrameSource::getName() const {
+    return shm->attached ? "x11-shm" : "x11";
+}
+#endif
+
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string kind = colon == std::string::npos ? spec : spec.substr(0, colon);
+    std::string argument = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "video") {
+        auto source = std::make_unique<VideoFrameSource>(argument);
+        if (!source->isOpened()) {
+            std::cerr << "Error opening video: " << argument << std::endl;
+            return nullptr;
+        }
+        return source;
+    }
+    if (kind == "device") {
+        auto source = std::make_unique<VideoFrameSource>(std::atoi(argument.c_str()));
+        if (!source->isOpened()) {
+            std::cerr << "Error opening capture device: " << argument << std::endl;
+            return nullptr;
+        }
+        return source;
+    }
+#ifdef _WIN32
+    if (kind == "window") {
+        auto source = std::make_unique<WindowFrameSource>(std::wstring(argument.begin(), argument.end()));
+        if (!source->isOpened()) return nullptr;
+        return source;
+    }
+#endif
+#ifdef __linux__
+    if (kind == "x11") {
+        auto source = std::make_unique<X11ShmFrameSource>(argument);
+        if (!source->isOpened()) return nullptr;
+        return source;
+    }
+#endif
+
+    std::string directory = kind == "dir" ? argument : spec;
+    auto source = std::make_unique<DirectoryFrameSource>(directory);
+    if (source->getFrameCount() == 0) {
+        std::cerr << "No frames found in: " << directory << std::endl;
+        return nullptr;
+    }
+    return source;
+}
@@ -0,0 +1,130 @@
+/*
+Symmetric delete index for finding GameData names in OCR text with a few wrong, missing or extra characters.
+*/
+
+#include "fuzzyentityindex.h"
+#include "gamedata.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    const size_t MAX_TEXT_LENGTH = FuzzyEntityIndex::MAX_NAME_LENGTH + FuzzyEntityIndex::MAX_DISTANCE;
+
+    // Calls visit with text and every string made from it by deleting up to depth characters at positions from start
+    // on. Repeated letters give some variants more than once.
+    template <typename Visit>
+    void forEachDeletion(std::string_view text, size_t start, int depth, const Visit& visit) {
+        visit(text);
+        if (depth == 0 || text.size() <= 1) return;
+
+        char shorter[MAX_TEXT_LENGTH];
+        for (size_t i = start; i < text.size(); i++) {
+            std::copy(text.begin(), text.begin() + i, shorter);
+            std::copy(text.begin() + i + 1, text.end(), shorter + i);
+            forEachDeletion(std::string_view(shorter, text.size() - 1), i, depth - 1, visit);
+        }
+    }
+
+    // Levenshtein distance, or limit + 1 as soon as it is known to be more than limit.
+    int boundedEditDistance(std::string_view a, std::string_view b, int limit) {
+        if (std::abs(static_cast<int>(a.size()) - static_cast<int>(b.size())) > limit) return limit + 1;
+
+        int previous[MAX_TEXT_LENGTH + 1], current[MAX_TEXT_LENGTH + 1];
+        for (size_t j = 0; j <= b.size(); j++) previous[j] = static_cast<int>(j);
+        for (size_t i = 1; i <= a.size(); i++) {
+            current[0] = static_cast<int>(i);
+            int rowMinimum = current[0];
+            for (size_t j = 1; j <= b.size(); j++) {
+                int substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                current[j] = std::min({ previous[j] + 1, current[j - 1] + 1, substitution });
+                rowMinimum = std::min(rowMinimum, current[j]);
+            }
+            if (rowMinimum > limit) return limit + 1;
+            std::copy(current, current + b.size() + 1, previous);
+        }
+        return previous[b.size()];
+    }
+}
+
+int FuzzyEntityIndex::maxDistanceFor(size_t length) {
+    if (length <= 3) return 0;
+    if (length <= 7) return 1;
+    return MAX_DISTANCE;
+}
+
+void FuzzyEntityIndex::add(EntityType type, int id, std::string_view name) {
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) return;
+
+    int entry = static_cast<int>(entries.size());
+    entries.push_back({ type, id, name });
+    forEachDeletion(name, 0, maxDistanceFor(name.size()), [this, entry](std::string_view variant) {
+        postings.push_back({ GameData::detail::hashName(variant), entry });
+    });
+}
+
+void FuzzyEntityIndex::build() {
+    auto order = [](const Posting& a, const Posting& b) { return a.hash != b.hash ? a.hash < b.hash : a.entry < b.entry; };
+    auto same = [](const Posting& a, const Posting& b) { return a.hash == b.hash && a.entry == b.entry; };
+    std::sort(postings.begin(), postings.end(), order);
+    postings.erase(std::unique(postings.begin(), postings.end(), same), postings.end());
+    postings.shrink_to_fit();
+
+    directory.assign((size_t(1) << DIRECTORY_BITS) + 1, 0);
+    for (const Posting& posting : postings) directory[(posting.hash >> (64 - DIRECTORY_BITS)) + 1]++;
+    for (size_t i = 1; i < directory.size(); i++) directory[i] += directory[i - 1];
+}
+
+bool FuzzyEntityIndex::lookup(std::string_view text, FuzzyMatch& match, unsigned typeMask) const {
+    if (text.empty() || text.size() > MAX_TEXT_LENGTH || directory.empty()) return false;
+
+    int bestEntry = -1;
+    int bestDistance = MAX_DISTANCE + 1;
+    bool tied = false;
+    forEachDeletion(text, 0, MAX_DISTANCE, [&](std::string_view variant) {
+        uint64_t hash = GameData::detail::hashName(variant);
+        size_t run = static_cast<size_t>(hash >> (64 - DIRECTORY_BITS));
+        auto end = postings.begin() + directory[run + 1];
+        for (auto posting = postings.begin() + directory[run]; posting != end; ++posting) {
+            if (posting->hash != hash) continue;
+            const Entry& entry = entries[posting->entry];
+            if (posting->entry == bestEntry || !(typeMask & entityTypeMask(entry.type))) continue;
+
+            int allowed = std::min(maxDistanceFor(entry.name.size()), bestDistance);
+            int distance = boundedEditDistance(text, entry.name, allowed);
+            if (distance > allowed) continue;
+
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestEntry = posting->entry;
+                tied = false;
+            }
+            else {
+                tied = true;
+                bestEntry = std::min(bestEntry, posting->entry);
+            }
+        }
+    });
+    if (bestEntry < 0) return false;
+
+    const Entry& best = entries[bestEntry];
+    match.type = best.type;
+    match.id = best.id;
+    match.distance = bestDistance;
+    match.confidence = 1.0f - static_cast<float>(bestDistance) / best.name.size();
+    if (tied) match.confidence *= 0.5f;
+    return true;
+}
+
+size_t FuzzyEntityIndex::getPostingCount() const {
+    return postings.size();
+}
+
+const FuzzyEntityIndex& FuzzyEntityIndex::gameData() {
+    static const FuzzyEntityIndex index = [] {
+        FuzzyEntityIndex names;
+        forEachGameDataName([&names](EntityType type, int id, std::string_view name) { names.add(type, id, name); });
+        names.build();
+        return names;
+    }();
+    return index;
+}
@@ -0,0 +1,365 @@
+/*
+Recognizer for the fixed bitmap font used in the dialogue box, an alternative to running Tesseract on it.
+*/
+
+#include "glyphrecognizer.h"
+#include "imageprocessing.h"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace {
+    const int GRID = 16;                // Bitmap side length in cells
+    const float SPACE_GAP = 0.2f;       // Column gap, relative to the cell height, that separates two words
+    const int MIN_LINE_HEIGHT = 4;      // Shorter row runs are noise
+    const int ASPECT_WEIGHT = 64;       // Cost of a full cell height of width difference
+    const int DUPLICATE_DISTANCE = 8;   // Templates closer than this to an existing one add nothing
+
+    inline int popcount64(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(value));
+#elif defined(__GNUC__)
+        return __builtin_popcountll(value);
+#else
+        return static_cast<int>(std::bitset<64>(value).count());
+#endif
+    }
+
+    inline int hammingDistance(const GlyphBitmap& a, const GlyphBitmap& b) {
+        return popcount64(a.bits[0] ^ b.bits[0]) + popcount64(a.bits[1] ^ b.bits[1])
+            + popcount64(a.bits[2] ^ b.bits[2]) + popcount64(a.bits[3] ^ b.bits[3]);
+    }
+
+    // Text pixels of a preprocessed box with the box frame removed, and the row runs that hold lines of text.
+    struct TextLayout {
+        int width = 0;
+        int height = 0;
+        std::vector<uchar> ink;
+        std::vector<std::pair<int, int>> lines; // [top, bottom)
+    };
+
+    void findText(const cv::Mat& preprocessed, TextLayout& layout) {
+        layout.width = preprocessed.cols;
+        layout.height = preprocessed.rows;
+        layout.ink.assign(static_cast<size_t>(layout.width) * layout.height, 0);
+        layout.lines.clear();
+        if (preprocessed.empty()) return;
+
+        // Otsu leaves text either black on white or white on black depending on the box, text is the minority.
+        size_t bright = 0;
+        for (int y = 0; y < layout.height; ++y) {
+            const uchar* row = preprocessed.ptr<uchar>(y);
+            for (int x = 0; x < layout.width; ++x) {
+                bright += row[x] >= 128;
+            }
+        }
+        const bool textIsBright = bright < layout.ink.size() / 2;
+
+        std::vector<int> columnInk(layout.width, 0);
+        for (int y = 0; y < layout.height; ++y) {
+            const uchar* row = preprocessed.ptr<uchar>(y);
+            uchar* inkRow = &layout.ink[static_cast<size_t>(y) * layout.width];
+            for (int x = 0; x < layout.width; ++x) {
+                inkRow[x] = (row[x] >= 128) == textIsBright;
+                columnInk[x] += inkRow[x];
+            }
+        }
+
+        // Columns and rows that are ink almost all the way across are the box frame.
+        for (int x = 0; x < layout.width; ++x) {
+            if (columnInk[x] > layout.height * 9 / 10) {
+                for (int y = 0; y < layout.height; ++y) layout.ink[static_cast<size_t>(y) * layout.width + x] = 0;
+            }
+        }
+
+        int runStart = -1;
+        for (int y = 0; y <= layout.height; ++y) {
+            int rowInk = 0;
+            if (y < layout.height) {
+                uchar* inkRow = &layout.ink[static_cast<size_t>(y) * layout.width];
+                for (int x = 0; x < layout.width; ++x) rowInk += inkRow[x];
+                if (rowInk > layout.width * 9 / 10) {
+                    std::fill(inkRow, inkRow + layout.width, 0);
+                    rowInk = 0;
+                }
+            }
+
+            if (rowInk > 0 && runStart < 0) {
+                runStart = y;
+            }
+            else if (rowInk == 0 && runStart >= 0) {
+                if (y - runStart >= MIN_LINE_HEIGHT) layout.lines.push_back({ runStart, y });
+                runStart = -1;
+            }
+        }
+    }
+
+    // Samples the glyph's columns over a full font cell below the line top onto the 16x16 grid.
+    GlyphBitmap sampleGlyph(const TextLayout& layout, int left, int right, int top, int cellHeight) {
+        GlyphBitmap bitmap;
+        const int glyphWidth = right - left;
+        for (int gy = 0; gy < GRID; ++gy) {
+            int y = top + ((2 * gy + 1) * cellHeight) / (2 * GRID);
+            if (y >= layout.height) break;
+            const uchar* inkRow = &layout.ink[static_cast<size_t>(y) * layout.width];
+            for (int gx = 0; gx < GRID; ++gx) {
+                int x = left + ((2 * gx + 1) * glyphWidth) / (2 * GRID);
+                if (inkRow[x]) {
+                    int bit = gy * GRID + gx;
+                    bitmap.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+                }
+            }
+        }
+        return bitmap;
+    }
+
+    std::string trim(const std::string& text) {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(start, end - start + 1);
+    }
+}
+
+void segmentGlyphs(const cv::Mat& preprocessed, int cellHeight, std::vector<GlyphCell>& cells) {
+    cells.clear();
+    TextLayout layout;
+    findText(preprocessed, layout);
+    if (cellHeight <= 0) return;
+
+    const int spaceGap = static_cast<int>(cellHeight * SPACE_GAP);
+    for (size_t line = 0; line < layout.lines.size(); ++line) {
+        const int top = layout.lines[line].first;
+        const int bottom = layout.lines[line].second;
+
+        int glyphStart = -1;
+        int previousEnd = -1;
+        for (int x = 0; x <= layout.width; ++x) {
+            bool columnHasInk = false;
+            if (x < layout.width) {
+                for (int y = top; y < bottom && !columnHasInk; ++y) {
+                    columnHasInk = layout.ink[static_cast<size_t>(y) * layout.width + x] != 0;
+                }
+            }
+
+            if (columnHasInk && glyphStart < 0) {
+                glyphStart = x;
+            }
+            else if (!columnHasInk && glyphStart >= 0) {
+                if (x - glyphStart >= 2) {
+                    GlyphCell cell;
+                    cell.line = static_cast<int>(line);
+                    cell.spaceBefore = previousEnd >= 0 && glyphStart - previousEnd > spaceGap;
+                    cell.aspect = static_cast<float>(x - glyphStart) / cellHeight;
+                    cell.bitmap = sampleGlyph(layout, glyphStart, x, top, cellHeight);
+                    cells.push_back(cell);
+                    previousEnd = x;
+                }
+                glyphStart = -1;
+            }
+        }
+    }
+}
+
+std::vector<DialogueLabel> readDialogueLabels(const std::string& labelsPath) {
+    std::vector<DialogueLabel> labels;
+    std::ifstream file(labelsPath);
+    if (!file) {
+        std::cerr << "Error opening labels file: " << labelsPath << std::endl;
+        return labels;
+    }
+
+    size_t slash = labelsPath.find_last_of("/\\");
+    std::string baseDir = slash == std::string::npos ? "" : labelsPath.substr(0, slash + 1);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string field;
+        DialogueLabel label;
+        std::getline(fields, field, '|');
+        label.imagePath = baseDir + trim(field);
+        while (std::getline(fields, field, '|')) {
+            label.lines.push_back(trim(field));
+        }
+        labels.push_back(label);
+    }
+    return labels;
+}
+
+GlyphAtlas::GlyphAtlas() : cellHeight(0) {}
+
+bool GlyphAtlas::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening glyph atlas: " << path << std::endl;
+        return false;
+    }
+
+    templates.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "cellHeight") {
+            fields >> cellHeight;
+            continue;
+        }
+
+        GlyphTemplate glyph;
+        glyph.symbol = static_cast<char>(std::stoi(key));
+        fields >> glyph.aspect >> std::hex >> glyph.bitmap.bits[0] >> glyph.bitmap.bits[1] >> glyph.bitmap.bits[2] >> glyph.bitmap.bits[3];
+        if (fields) templates.push_back(glyph);
+    }
+    return cellHeight > 0 && !templates.empty();
+}
+
+bool GlyphAtlas::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error writing glyph atlas: " << path << std::endl;
+        return false;
+    }
+
+    file << "# Glyph atlas: character code, width / cell height, 16x16 bitmap as four hex words" << '\n';
+    file << "cellHeight " << cellHeight << '\n';
+    for (const auto& glyph : templates) {
+        file << static_cast<int>(static_cast<unsigned char>(glyph.symbol)) << ' ' << glyph.aspect << std::hex;
+        for (uint64_t word : glyph.bitmap.bits) file << ' ' << word;
+        file << std::dec << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+size_t GlyphAtlas::buildFromLabels(const std::vector<DialogueLabel>& labels, const LayoutProfile& captureLayout, int nativeMultiple) {
+    struct Sample {
+        cv::Mat preprocessed;
+        std::vector<std::string> symbols;  // Label characters of each line, spaces removed
+        std::vector<bool> lineMatches;     // Segmentation found as many glyphs as the label has characters
+    };
+    std::vector<Sample> samples;
+
+    // First pass: glyph counts do not depend on the cell height, so lines that segment cleanly are found first and
+    // only those decide the font cell height (the tallest of them, covering ascenders and descenders).
+    TextLayout layout;
+    std::vector<GlyphCell> cells;
+    cv::Mat frame;
+    const LayoutProfile frameLayout = nativeMultiple > 0 ? captureLayout.scaledToNative(nativeMultiple) : captureLayout;
+    cellHeight = 0;
+    for (const auto& label : labels) {
+        cv::Mat img = cv::imread(label.imagePath);
+        if (img.empty()) {
+            std::cerr << "Error loading: " << label.imagePath << std::endl;
+            continue;
+        }
+
+        Sample sample;
+        downscaleToNative(img, captureLayout, nativeMultiple, frame);
+        sample.preprocessed = preprocessImage(cropToDialogue(frame, frameLayout));
+        findText(sample.preprocessed, layout);
+        segmentGlyphs(sample.preprocessed, 1, cells);
+
+        for (size_t line = 0; line < label.lines.size(); ++line) {
+            std::string symbols;
+            for (char c : label.lines[line]) {
+                if (c != ' ') symbols += c;
+            }
+            size_t found = std::count_if(cells.begin(), cells.end(), [line](const GlyphCell& cell) { return cell.line == static_cast<int>(line); });
+            bool matches = line < layout.lines.size() && found == symbols.size();
+            if (matches) {
+                cellHeight = std::max(cellHeight, layout.lines[line].second - layout.lines[line].first);
+            }
+            else {
+                std::cerr << "Skipping line " << line + 1 << " of " << label.imagePath << ": found " << found
+                    << " glyphs for " << symbols.size() << " characters." << std::endl;
+            }
+            sample.symbols.push_back(symbols);
+            sample.lineMatches.push_back(matches);
+        }
+        samples.push_back(sample);
+    }
+
+    // Second pass: cut the matching lines at the real cell height and keep every sufficiently distinct glyph.
+    templates.clear();
+    size_t learned = 0;
+    for (const auto& sample : samples) {
+        segmentGlyphs(sample.preprocessed, cellHeight, cells);
+        for (size_t line = 0; line < sample.symbols.size(); ++line) {
+            if (!sample.lineMatches[line]) continue;
+
+            size_t g = 0;
+            for (const auto& cell : cells) {
+                if (cell.line != static_cast<int>(line)) continue;
+                GlyphTemplate glyph;
+                glyph.symbol = sample.symbols[line][g++];
+                glyph.aspect = cell.aspect;
+                glyph.bitmap = cell.bitmap;
+                learned++;
+
+                bool duplicate = std::any_of(templates.begin(), templates.end(), [&glyph](const GlyphTemplate& existing) {
+                    return existing.symbol == glyph.symbol && hammingDistance(existing.bitmap, glyph.bitmap) < DUPLICATE_DISTANCE
+                        && std::fabs(existing.aspect - glyph.aspect) < 0.05f;
+                });
+                if (!duplicate) templates.push_back(glyph);
+            }
+        }
+    }
+    return learned;
+}
+
+int GlyphAtlas::getCellHeight() const {
+    return cellHeight;
+}
+
+const std::vector<GlyphTemplate>& GlyphAtlas::getTemplates() const {
+    return templates;
+}
+
+GlyphRecognizer::GlyphRecognizer(const GlyphAtlas& atlas, int maxCost) : atlas(atlas), maxCost(maxCost) {}
+
+std::string GlyphRecognizer::recognize(const cv::Mat& preprocessed) {
+    std::vector<GlyphCell> cells;
+    segmentGlyphs(preprocessed, atlas.getCellHeight(), cells);
+
+    std::string text;
+    int currentLine = -1;
+    for (const auto& cell : cells) {
+        const GlyphTemplate* best = nullptr;
+        int bestCost = maxCost + 1;
+        for (const auto& glyph : atlas.getTemplates()) {
+            int cost = hammingDistance(cell.bitmap, glyph.bitmap) + static_cast<int>(ASPECT_WEIGHT * std::fabs(cell.aspect - glyph.aspect));
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = &glyph;
+            }
+        }
+        if (!best) continue;
+
+        if (cell.line != currentLine) {
+            if (currentLine >= 0) text += '\n';
+            currentLine = cell.line;
+        }
+        else if (cell.spaceBefore) {
+            text += ' ';
+        }
+        text += static_cast<char>(std::toupper(static_cast<unsigned char>(best->symbol)));
+    }
+    if (!text.empty()) text += '\n';
+    return text;
+}
+
+const char* GlyphRecognizer::getName() const {
+    return "glyph";
+}
@@ -0,0 +1,224 @@
+/*
+Cropping, preprocessing and OCR of the regions of a capture that the battle logic reads.
+*/
+
+#include "imageprocessing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PREPROCESS_SSE2
+#endif
+using namespace std;
+
+namespace {
+    // cv::cvtColor's fixed point BGR to gray weights for 8 bit images, keeps the fused kernel in step with the OpenCV chain.
+    const int GRAY_B = 1868, GRAY_G = 9617, GRAY_R = 4899, GRAY_SHIFT = 14;
+
+    // Scratch rows reused between calls, one set per thread.
+    thread_local vector<uchar> grayScratch;  // Luma of the whole crop
+    thread_local vector<uchar> inkScratch;   // Three rolling source rows of 0/1 ink
+    thread_local vector<uchar> blendScratch; // One blended row with a column of padding on each side
+
+    inline int grayOf(const uchar* px, int channels) {
+        if (channels < 3) return px[0];
+        return (px[0] * GRAY_B + px[1] * GRAY_G + px[2] * GRAY_R + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT;
+    }
+
+    // Same search as cv::threshold with THRESH_OTSU, including its tie breaking, so both paths pick the same level.
+    int otsuThreshold(const int histogram[256], int total) {
+        const double scale = 1.0 / total;
+        double mu = 0;
+        for (int i = 0; i < 256; ++i) mu += i * static_cast<double>(histogram[i]);
+        mu *= scale;
+
+        double mu1 = 0, q1 = 0, maxSigma = 0;
+        int threshold = 0;
+        for (int i = 0; i < 256; ++i) {
+            double p = histogram[i] * scale;
+            mu1 *= q1;
+            q1 += p;
+            double q2 = 1.0 - q1;
+            if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1.0 - FLT_EPSILON) continue;
+
+            mu1 = (mu1 + i * p) / q1;
+            double mu2 = (mu - q1 * mu1) / q2;
+            double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+            if (sigma > maxSigma) {
+                maxSigma = sigma;
+                threshold = i;
+            }
+        }
+        return threshold;
+    }
+
+    // A 2x INTER_LINEAR upscale weights the 2x2 source neighbours of an output pixel 9, 3, 3 and 1 sixteenths. On a
+    // 0/1 source that leaves 0 to 16 sixteenths of ink per output pixel, scaled here to 0..255 with rounding.
+    inline uchar coverageToGray(int sixteenths) {
+        return static_cast<uchar>((255 * sixteenths + 8) >> 4);
+    }
+
+#ifdef PREPROCESS_SSE2
+    inline __m128i coverageToGray(__m128i sixteenths) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(8);
+        __m128i lo = _mm_unpacklo_epi8(sixteenths, zero);
+        __m128i hi = _mm_unpackhi_epi8(sixteenths, zero);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_slli_epi16(lo, 8), lo), rounding), 4);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_slli_epi16(hi, 8), hi), rounding), 4);
+        return _mm_packus_epi16(lo, hi);
+    }
+#endif
+
+    // Writes one output row. blend[x] is 3 * ink of the nearest source row + ink of the other source row (0..4),
+    // blend[-1] and blend[width] repeat the edge columns like the replicated border of cv::resize.
+    void writeUpscaledRow(const uchar* blend, int width, uchar* out) {
+        int x = 0;
+#ifdef PREPROCESS_SSE2
+        for (; x + 16 <= width; x += 16) {
+            __m128i centre = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blend + x));
+            __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blend + x - 1));
+            __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blend + x + 1));
+            __m128i centre3 = _mm_add_epi8(_mm_add_epi8(centre, centre), centre);
+            __m128i even = coverageToGray(_mm_add_epi8(centre3, left));
+            __m128i odd = coverageToGray(_mm_add_epi8(centre3, right));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * x), _mm_unpacklo_epi8(even, odd));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * x + 16), _mm_unpackhi_epi8(even, odd));
+        }
+#endif
+        for (; x < width; ++x) {
+            int centre3 = 3 * blend[x];
+            out[2 * x] = coverageToGray(centre3 + blend[x - 1]);
+            out[2 * x + 1] = coverageToGray(centre3 + blend[x + 1]);
+        }
+    }
+
+    // Second pass shared by both modes: builds each 0/1 ink row once, keeping three rows in flight, and writes the
+    // two output rows every source row produces.
+    template <typename InkRow>
+    void upscaleInk(int width, int height, InkRow inkRow, cv::Mat& output) {
+        output.create(height * 2, width * 2, CV_8UC1);
+        inkScratch.resize(static_cast<size_t>(width) * 3);
+        blendScratch.resize(static_cast<size_t>(width) + 2);
+        auto row = [width](int y) { return &inkScratch[static_cast<size_t>(y % 3) * width]; };
+        uchar* blend = &blendScratch[1];
+
+        auto writeRow = [&](const uchar* nearest, const uchar* other, uchar* out) {
+            for (int x = 0; x < width; ++x) blend[x] = static_cast<uchar>(3 * nearest[x] + other[x]);
+            blend[-1] = blend[0];
+            blend[width] = blend[width - 1];
+            writeUpscaledRow(blend, width, out);
+        };
+
+        inkRow(0, row(0));
+        for (int y = 0; y < height; ++y) {
+            if (y + 1 < height) inkRow(y + 1, row(y + 1));
+            const uchar* current = row(y);
+            writeRow(current, row(std::max(y - 1, 0)), output.ptr<uchar>(2 * y));
+            writeRow(current, row(std::min(y + 1, height - 1)), output.ptr<uchar>(2 * y + 1));
+        }
+    }
+}
+
+namespace {
+    cv::Mat cropToNativeRegion(const cv::Mat& screenshot, const LayoutProfile& layout, const cv::Rect2d& native) {
+        cv::Rect region = layout.toCapture(native) & cv::Rect(0, 0, screenshot.cols, screenshot.rows);
+        if (region.empty()) {
+            return cv::Mat();
+        }
+        return screenshot(region);
+    }
+}
+
+cv::Mat cropToDialogue(const cv::Mat& screenshot, const LayoutProfile& layout) {
+    return cropToNativeRegion(screenshot, layout, layout.dialogue);
+}
+
+cv::Mat cropToStreakCount(const cv::Mat& screenshot, const std::string& level, const LayoutProfile& layout) { //The pipeline reads both levels until BattleLogic has told which one is being challenged.
+    if (level == "50") {
+        return cropToNativeRegion(screenshot, layout, layout.streakLevel50);
+    } else if (level == "100") {
+        return cropToNativeRegion(screenshot, layout, layout.streakLevel100);
+    }
+    cerr << "Invalid level selected for scropToStreakCount()." << endl;
+    return cv::Mat();
+}
+
+cv::Mat preprocessImage(const cv::Mat& input) {
+    cv::Mat thresh;
+    preprocessImageInto(input, thresh);
+    return thresh;
+}
+
+void preprocessImageInto(const cv::Mat& input, cv::Mat& output) {
+    if (input.empty()) {
+        output.release();
+        return;
+    }
+    const int width = input.cols;
+    const int height = input.rows;
+    const int channels = input.channels();
+
+    // Pass 1: luma and its histogram for Otsu.
+    grayScratch.resize(static_cast<size_t>(width) * height);
+    int histogram[256] = { 0 };
+    for (int y = 0; y < height; ++y) {
+        const uchar* src = input.ptr<uchar>(y);
+        uchar* gray = &grayScratch[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x) {
+            int value = grayOf(src + x * channels, channels);
+            gray[x] = static_cast<uchar>(value);
+            histogram[value]++;
+        }
+    }
+    const int threshold = otsuThreshold(histogram, width * height);
+
+    // Pass 2: threshold and upscale.
+    upscaleInk(width, height, [width, threshold](int y, uchar* ink) {
+        const uchar* gray = &grayScratch[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x) ink[x] = gray[x] > threshold;
+    }, output);
+}
+
+void preprocessImageInto(const cv::Mat& input, cv::Mat& output, const TextColorKey& key) {
+    if (input.empty()) {
+        output.release();
+        return;
+    }
+    const int channels = input.channels();
+    const uchar keyBgr[3] = { key.b, key.g, key.r };
+    const int keyGray = grayOf(keyBgr, 3);
+
+    upscaleInk(input.cols, input.rows, [&input, &key, channels, keyGray](int y, uchar* ink) {
+        const uchar* src = input.ptr<uchar>(y);
+        for (int x = 0; x < input.cols; ++x, src += channels) {
+            if (channels < 3) {
+                ink[x] = std::abs(src[0] - keyGray) <= key.tolerance;
+            }
+            else {
+                ink[x] = std::abs(src[0] - key.b) <= key.tolerance && std::abs(src[1] - key.g) <= key.tolerance
+                    && std::abs(src[2] - key.r) <= key.tolerance;
+            }
+        }
+    }, output);
+}
+
+string analyzeImage(const cv::Mat& image, OcrEnginePool& ocrPool, OcrProfile profile) {
+    OcrEnginePool::Lease tess = ocrPool.acquire(profile);
+    if (!tess) {
+        return "";
+    }
+
+    tess->SetImage(image.data, image.cols, image.rows, image.channels(), static_cast<int>(image.step));
+
+    string result;
+    char* text = tess->GetUTF8Text();
+    if (text) {
+        result = text;
+        delete[] text;
+    }
+    return result;
+}
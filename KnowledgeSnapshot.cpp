@@ -0,0 +1,485 @@
+/*
+Memory-mapped binary snapshot of the trainer knowledge tables: exporter, change check and lookups over the mapping.
+*/
+
+#include "knowledgesnapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Layout, in native byte order: Header, then the sections it gives offsets to, each 4 byte aligned.
+//   trainers         TrainerRecord[trainerCount], by database ID
+//   trainersByName   uint32_t[trainerCount], trainer indices by name
+//   pokemon          PokemonRecord[pokemonCount], grouped by trainer, by database ID within a trainer
+//   pokemonByID      uint32_t[pokemonCount], pokemon indices by database ID
+//   seen             uint32_t[seenCount], name offsets, each Pokemon's moves then abilities then items
+//   strings          one byte length then the characters, each name once
+struct KnowledgeSnapshot::Header {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t schemaVersion;       // user_version of the database
+    int64_t tableStamps[5];       // Highest row ID of each table in STAMP_QUERIES
+    uint32_t trainerCount;
+    uint32_t pokemonCount;
+    uint32_t seenCount;
+    uint32_t stringBytes;
+    uint32_t trainersOffset;
+    uint32_t trainersByNameOffset;
+    uint32_t pokemonOffset;
+    uint32_t pokemonByIDOffset;
+    uint32_t seenOffset;
+    uint32_t stringsOffset;
+};
+
+struct KnowledgeSnapshot::TrainerRecord {
+    uint32_t trainerID;
+    uint32_t name;
+    uint32_t firstPokemon;
+    uint32_t pokemonCount;
+};
+
+struct KnowledgeSnapshot::PokemonRecord {
+    uint32_t pokemonID;
+    uint32_t name;
+    uint32_t firstSeen;
+    uint16_t seenCounts[3]; // Moves, abilities, items
+    uint16_t padding;
+};
+
+namespace {
+    const char MAGIC[8] = { 'P', 'K', 'M', 'N', 'S', 'N', 'A', 'P' };
+    const size_t MAX_STRING_LENGTH = 255;
+    const size_t MAX_SEEN_PER_KIND = 0xFFFF;
+
+    const char* const STAMP_QUERIES[] = {
+        "SELECT MAX(rowid) FROM Trainers;",
+        "SELECT MAX(rowid) FROM Pokemon;",
+        "SELECT MAX(rowid) FROM SeenMoves;",
+        "SELECT MAX(rowid) FROM SeenAbilities;",
+        "SELECT MAX(rowid) FROM SeenItems;"
+    };
+    const size_t STAMP_COUNT = sizeof(STAMP_QUERIES) / sizeof(STAMP_QUERIES[0]);
+
+    // Order of the seen kinds in a PokemonRecord.
+    int seenKind(EntityType type) {
+        switch (type) {
+        case EntityType::Move: return 0;
+        case EntityType::Ability: return 1;
+        case EntityType::Item: return 2;
+        default: return -1;
+        }
+    }
+
+    const char* columnText(sqlite3_stmt* stmt, int column) {
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        return text ? reinterpret_cast<const char*>(text) : "";
+    }
+
+    // Runs a query and hands every row to visit. Returns false if the query could not be run.
+    template <typename Visit>
+    bool forEachRow(sqlite3* db, const char* query, const Visit& visit) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error exporting knowledge snapshot: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        int result;
+        while ((result = sqlite3_step(stmt)) == SQLITE_ROW) visit(stmt);
+        sqlite3_finalize(stmt);
+        return result == SQLITE_DONE;
+    }
+
+    // Schema version and table stamps of the database, which an unchanged database reproduces exactly. Rows are only
+    // ever added outside of migrations, and a migration changes the schema version.
+    bool readStamps(sqlite3* db, uint32_t& schemaVersion, int64_t (&stamps)[STAMP_COUNT]) {
+        bool ok = forEachRow(db, "PRAGMA user_version;", [&schemaVersion](sqlite3_stmt* stmt) {
+            schemaVersion = static_cast<uint32_t>(sqlite3_column_int(stmt, 0));
+        });
+        for (size_t i = 0; i < STAMP_COUNT; i++) {
+            ok = ok && forEachRow(db, STAMP_QUERIES[i], [&stamps, i](sqlite3_stmt* stmt) {
+                stamps[i] = sqlite3_column_int64(stmt, 0);
+            });
+        }
+        return ok;
+    }
+
+    // Pool of length prefixed strings, each stored once.
+    class StringPool {
+    private:
+        std::vector<char> bytes;
+        std::unordered_map<std::string, uint32_t> offsets;
+
+    public:
+        uint32_t intern(std::string_view text) {
+            text = text.substr(0, MAX_STRING_LENGTH);
+            auto found = offsets.emplace(std::string(text), static_cast<uint32_t>(bytes.size()));
+            if (found.second) {
+                bytes.push_back(static_cast<char>(text.size()));
+                bytes.insert(bytes.end(), text.begin(), text.end());
+            }
+            return found.first->second;
+        }
+
+        const std::vector<char>& getBytes() const {
+            return bytes;
+        }
+    };
+
+    struct ExportPokemon {
+        uint32_t pokemonID;
+        uint32_t trainerID;
+        uint32_t name;
+        std::vector<uint32_t> seen[3];
+    };
+
+    template <typename T>
+    void appendSection(std::vector<char>& file, uint32_t& offset, const std::vector<T>& items) {
+        file.resize((file.size() + 3) & ~size_t(3));
+        offset = static_cast<uint32_t>(file.size());
+        const char* begin = reinterpret_cast<const char*>(items.data());
+        file.insert(file.end(), begin, begin + items.size() * sizeof(T));
+    }
+
+    // Windows will not replace a file another process has mapped, so a snapshot open elsewhere fails here.
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        if (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING)) return true;
+        std::cerr << "Error " << GetLastError() << " moving " << from << " over " << to << std::endl;
+        return false;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+}
+
+KnowledgeSnapshot::KnowledgeSnapshot() : data(nullptr), size(0),
+#ifdef _WIN32
+    file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#else
+    file(-1)
+#endif
+{}
+
+KnowledgeSnapshot::~KnowledgeSnapshot() {
+    close();
+}
+
+bool KnowledgeSnapshot::exportFrom(sqlite3* db, const std::string& path) {
+    if (!db) return false;
+
+    // One read transaction, so the stamps describe exactly the rows exported.
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Error exporting knowledge snapshot: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.formatVersion = FORMAT_VERSION;
+
+    StringPool strings;
+    std::vector<TrainerRecord> trainers;
+    std::vector<ExportPokemon> pokemon;
+    std::unordered_map<uint32_t, uint32_t> trainerIndices; // By database ID
+    std::unordered_map<uint32_t, uint32_t> pokemonIndices; // By database ID
+
+    bool ok = readStamps(db, header.schemaVersion, header.tableStamps);
+    ok = ok && forEachRow(db, "SELECT trainer_id, name FROM Trainers ORDER BY trainer_id;", [&](sqlite3_stmt* stmt) {
+        uint32_t trainerID = static_cast<uint32_t>(sqlite3_column_int(stmt, 0));
+        trainerIndices.emplace(trainerID, static_cast<uint32_t>(trainers.size()));
+        trainers.push_back({ trainerID, strings.intern(columnText(stmt, 1)), 0, 0 });
+    });
+    ok = ok && forEachRow(db, "SELECT pokemon_id, trainer_id, name FROM Pokemon ORDER BY trainer_id, pokemon_id;", [&](sqlite3_stmt* stmt) {
+        uint32_t trainerID = static_cast<uint32_t>(sqlite3_column_int(stmt, 1));
+        if (trainerIndices.find(trainerID) == trainerIndices.end()) return;
+        uint32_t pokemonID = static_cast<uint32_t>(sqlite3_column_int(stmt, 0));
+        pokemonIndices.emplace(pokemonID, static_cast<uint32_t>(pokemon.size()));
+        pokemon.push_back({ pokemonID, trainerID, strings.intern(columnText(stmt, 2)), {} });
+    });
+    const std::pair<const char*, EntityType> seenTables[] = {
+        { "SELECT pokemon_id, move FROM SeenMoves ORDER BY rowid;", EntityType::Move },
+        { "SELECT pokemon_id, ability FROM SeenAbilities ORDER BY rowid;", EntityType::Ability },
+        { "SELECT pokemon_id, item FROM SeenItems ORDER BY rowid;", EntityType::Item }
+    };
+    for (const auto& table : seenTables) {
+        int kind = seenKind(table.second);
+        ok = ok && forEachRow(db, table.first, [&](sqlite3_stmt* stmt) {
+            auto found = pokemonIndices.find(static_cast<uint32_t>(sqlite3_column_int(stmt, 0)));
+            if (found == pokemonIndices.end()) return;
+            std::vector<uint32_t>& seen = pokemon[found->second].seen[kind];
+            if (seen.size() < MAX_SEEN_PER_KIND) seen.push_back(strings.intern(columnText(stmt, 1)));
+        });
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    if (!ok) return false;
+
+    std::vector<PokemonRecord> pokemonRecords;
+    std::vector<uint32_t> seen;
+    pokemonRecords.reserve(pokemon.size());
+    for (const ExportPokemon& entry : pokemon) {
+        TrainerRecord& trainer = trainers[trainerIndices[entry.trainerID]];
+        if (trainer.pokemonCount == 0) trainer.firstPokemon = static_cast<uint32_t>(pokemonRecords.size());
+        trainer.pokemonCount++;
+
+        PokemonRecord record = { entry.pokemonID, entry.name, static_cast<uint32_t>(seen.size()), { 0, 0, 0 }, 0 };
+        for (int kind = 0; kind < 3; kind++) {
+            record.seenCounts[kind] = static_cast<uint16_t>(entry.seen[kind].size());
+            seen.insert(seen.end(), entry.seen[kind].begin(), entry.seen[kind].end());
+        }
+        pokemonRecords.push_back(record);
+    }
+
+    const std::vector<char>& pool = strings.getBytes();
+    auto nameOf = [&pool](uint32_t offset) {
+        return std::string_view(pool.data() + offset + 1, static_cast<unsigned char>(pool[offset]));
+    };
+    std::vector<uint32_t> trainersByName(trainers.size());
+    for (size_t i = 0; i < trainersByName.size(); i++) trainersByName[i] = static_cast<uint32_t>(i);
+    std::sort(trainersByName.begin(), trainersByName.end(), [&](uint32_t a, uint32_t b) {
+        return nameOf(trainers[a].name) < nameOf(trainers[b].name);
+    });
+    std::vector<uint32_t> pokemonByID(pokemonRecords.size());
+    for (size_t i = 0; i < pokemonByID.size(); i++) pokemonByID[i] = static_cast<uint32_t>(i);
+    std::sort(pokemonByID.begin(), pokemonByID.end(), [&](uint32_t a, uint32_t b) {
+        return pokemonRecords[a].pokemonID < pokemonRecords[b].pokemonID;
+    });
+
+    header.trainerCount = static_cast<uint32_t>(trainers.size());
+    header.pokemonCount = static_cast<uint32_t>(pokemonRecords.size());
+    header.seenCount = static_cast<uint32_t>(seen.size());
+    header.stringBytes = static_cast<uint32_t>(pool.size());
+
+    std::vector<char> file(sizeof(Header));
+    appendSection(file, header.trainersOffset, trainers);
+    appendSection(file, header.trainersByNameOffset, trainersByName);
+    appendSection(file, header.pokemonOffset, pokemonRecords);
+    appendSection(file, header.pokemonByIDOffset, pokemonByID);
+    appendSection(file, header.seenOffset, seen);
+    appendSection(file, header.stringsOffset, pool);
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            std::cerr << "Error writing knowledge snapshot " << temporary << std::endl;
+            return false;
+        }
+    }
+    if (!replaceFile(temporary, path)) {
+        std::cerr << "Error replacing knowledge snapshot " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool KnowledgeSnapshot::refresh(sqlite3* db, const std::string& path, bool* exported) {
+    if (exported) *exported = false;
+    {
+        KnowledgeSnapshot current;
+        if (current.open(path) && current.isCurrent(db)) return true;
+    }
+    if (!exportFrom(db, path)) return false;
+    if (exported) *exported = true;
+    return true;
+}
+
+bool KnowledgeSnapshot::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= static_cast<LONGLONG>(sizeof(Header))) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        size = static_cast<size_t>(fileSize.QuadPart);
+    }
+#else
+    file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(Header))) {
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+        if (view != MAP_FAILED) data = static_cast<const char*>(view);
+        size = static_cast<size_t>(status.st_size);
+    }
+#endif
+    if (!data) {
+        close();
+        return false;
+    }
+
+    // Every section has to lie inside the file, and every index entry name a record in its section, after that lookups
+    // trust it.
+    const Header& head = header();
+    auto fits = [this](uint32_t offset, uint64_t count, size_t itemSize) {
+        return offset % 4 == 0 && offset >= sizeof(Header) && offset <= size && count * itemSize <= size - offset;
+    };
+    bool valid = std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) == 0 && head.formatVersion == FORMAT_VERSION
+        && fits(head.trainersOffset, head.trainerCount, sizeof(TrainerRecord))
+        && fits(head.trainersByNameOffset, head.trainerCount, sizeof(uint32_t))
+        && fits(head.pokemonOffset, head.pokemonCount, sizeof(PokemonRecord))
+        && fits(head.pokemonByIDOffset, head.pokemonCount, sizeof(uint32_t))
+        && fits(head.seenOffset, head.seenCount, sizeof(uint32_t))
+        && fits(head.stringsOffset, head.stringBytes, 1);
+    auto indexFits = [this](uint32_t offset, uint32_t count) {
+        const uint32_t* entries = table(offset);
+        return std::all_of(entries, entries + count, [count](uint32_t index) { return index < count; });
+    };
+    valid = valid && indexFits(head.trainersByNameOffset, head.trainerCount) && indexFits(head.pokemonByIDOffset, head.pokemonCount);
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void KnowledgeSnapshot::close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (data) munmap(const_cast<char*>(data), size);
+    if (file >= 0) ::close(file);
+    file = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool KnowledgeSnapshot::isOpen() const {
+    return data != nullptr;
+}
+
+bool KnowledgeSnapshot::isCurrent(sqlite3* db) const {
+    if (!data || !db) return false;
+    uint32_t schemaVersion = 0;
+    int64_t stamps[STAMP_COUNT] = {};
+    if (!readStamps(db, schemaVersion, stamps)) return false;
+    return schemaVersion == header().schemaVersion
+        && std::equal(stamps, stamps + STAMP_COUNT, header().tableStamps);
+}
+
+const KnowledgeSnapshot::Header& KnowledgeSnapshot::header() const {
+    return *reinterpret_cast<const Header*>(data);
+}
+
+const KnowledgeSnapshot::TrainerRecord& KnowledgeSnapshot::trainer(int index) const {
+    return reinterpret_cast<const TrainerRecord*>(data + header().trainersOffset)[index];
+}
+
+const KnowledgeSnapshot::PokemonRecord& KnowledgeSnapshot::pokemon(int index) const {
+    return reinterpret_cast<const PokemonRecord*>(data + header().pokemonOffset)[index];
+}
+
+const uint32_t* KnowledgeSnapshot::table(uint32_t offset) const {
+    return reinterpret_cast<const uint32_t*>(data + offset);
+}
+
+std::string_view KnowledgeSnapshot::stringAt(uint32_t offset) const {
+    if (offset >= header().stringBytes) return std::string_view();
+    const char* text = data + header().stringsOffset + offset;
+    size_t length = std::min<size_t>(static_cast<unsigned char>(*text), header().stringBytes - offset - 1);
+    return std::string_view(text + 1, length);
+}
+
+int KnowledgeSnapshot::getTrainerCount() const {
+    return data ? static_cast<int>(header().trainerCount) : 0;
+}
+
+int KnowledgeSnapshot::getPokemonCount() const {
+    return data ? static_cast<int>(header().pokemonCount) : 0;
+}
+
+int KnowledgeSnapshot::findTrainer(std::string_view name) const {
+    if (!data) return NOT_FOUND;
+    const uint32_t* byName = table(header().trainersByNameOffset);
+    const uint32_t* end = byName + header().trainerCount;
+    const uint32_t* found = std::lower_bound(byName, end, name, [this](uint32_t index, std::string_view key) {
+        return stringAt(trainer(static_cast<int>(index)).name) < key;
+    });
+    if (found == end || *found >= header().trainerCount || stringAt(trainer(static_cast<int>(*found)).name) != name) return NOT_FOUND;
+    return static_cast<int>(*found);
+}
+
+int KnowledgeSnapshot::findTrainerByID(int trainerID) const {
+    if (!data || trainerID < 0) return NOT_FOUND;
+    const TrainerRecord* first = &trainer(0);
+    const TrainerRecord* end = first + header().trainerCount;
+    const TrainerRecord* found = std::lower_bound(first, end, static_cast<uint32_t>(trainerID),
+        [](const TrainerRecord& record, uint32_t key) { return record.trainerID < key; });
+    if (found == end || found->trainerID != static_cast<uint32_t>(trainerID)) return NOT_FOUND;
+    return static_cast<int>(found - first);
+}
+
+int KnowledgeSnapshot::getTrainerID(int trainerIndex) const {
+    return static_cast<int>(trainer(trainerIndex).trainerID);
+}
+
+std::string_view KnowledgeSnapshot::getTrainerName(int trainerIndex) const {
+    return stringAt(trainer(trainerIndex).name);
+}
+
+KnowledgeSnapshot::Team KnowledgeSnapshot::getTeam(int trainerIndex) const {
+    const TrainerRecord& record = trainer(trainerIndex);
+    Team team;
+    if (record.firstPokemon > header().pokemonCount || record.pokemonCount > header().pokemonCount - record.firstPokemon) return team;
+    team.first = static_cast<int>(record.firstPokemon);
+    team.count = static_cast<int>(record.pokemonCount);
+    return team;
+}
+
+int KnowledgeSnapshot::findPokemonByID(int pokemonID) const {
+    if (!data || pokemonID < 0) return NOT_FOUND;
+    const uint32_t* byID = table(header().pokemonByIDOffset);
+    const uint32_t* end = byID + header().pokemonCount;
+    const uint32_t* found = std::lower_bound(byID, end, static_cast<uint32_t>(pokemonID), [this](uint32_t index, uint32_t key) {
+        return index < header().pokemonCount && pokemon(static_cast<int>(index)).pokemonID < key;
+    });
+    if (found == end || *found >= header().pokemonCount || pokemon(static_cast<int>(*found)).pokemonID != static_cast<uint32_t>(pokemonID)) return NOT_FOUND;
+    return static_cast<int>(*found);
+}
+
+int KnowledgeSnapshot::getPokemonID(int pokemonIndex) const {
+    return static_cast<int>(pokemon(pokemonIndex).pokemonID);
+}
+
+std::string_view KnowledgeSnapshot::getPokemonName(int pokemonIndex) const {
+    return stringAt(pokemon(pokemonIndex).name);
+}
+
+int KnowledgeSnapshot::getSeenCount(int pokemonIndex, EntityType type) const {
+    int kind = seenKind(type);
+    if (kind < 0) return 0;
+    const PokemonRecord& record = pokemon(pokemonIndex);
+    uint64_t end = static_cast<uint64_t>(record.firstSeen) + record.seenCounts[0] + record.seenCounts[1] + record.seenCounts[2];
+    return end <= header().seenCount ? record.seenCounts[kind] : 0;
+}
+
+std::string_view KnowledgeSnapshot::getSeen(int pokemonIndex, EntityType type, int seenIndex) const {
+    if (seenIndex < 0 || seenIndex >= getSeenCount(pokemonIndex, type)) return std::string_view();
+    const PokemonRecord& record = pokemon(pokemonIndex);
+    uint32_t position = record.firstSeen + static_cast<uint32_t>(seenIndex);
+    for (int kind = 0; kind < seenKind(type); kind++) position += record.seenCounts[kind];
+    return stringAt(table(header().seenOffset)[position]);
+}
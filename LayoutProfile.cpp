@@ -0,0 +1,181 @@
+/*
+Layout profiles: where the GBA screen sits in a capture, and the regions of it the reader looks at.
+*/
+
+#include "layoutprofile.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+    // Teal interior of the battle dialogue box in native pixels, the target calibration looks for. Fractional because
+    // the capture blurs the box edges, measured with the same colour test on the TestScreenshots battle frames.
+    const float BOX_LEFT = 10.0f, BOX_TOP = 117.5f, BOX_RIGHT = 231.75f, BOX_BOTTOM = 155.75f;
+    const int CALIBRATION_STEP = 2; // Sample every other pixel, the box is hundreds of pixels wide in any real capture
+
+    bool isBoxTeal(const uchar* bgr) {
+        int b = bgr[0], g = bgr[1], r = bgr[2];
+        return g > r + 30 && b > r + 30 && g >= 80 && g <= 150 && b >= 80 && b <= 150;
+    }
+
+    // First and last index whose count reaches half of the largest count. Text inside the box lowers the counts of
+    // some rows and columns, but never by half.
+    bool denseSpan(const std::vector<int>& counts, int& first, int& last) {
+        int peak = *std::max_element(counts.begin(), counts.end());
+        if (peak == 0) return false;
+        first = -1;
+        for (int i = 0; i < static_cast<int>(counts.size()); ++i) {
+            if (counts[i] * 2 >= peak) {
+                if (first < 0) first = i;
+                last = i;
+            }
+        }
+        return true;
+    }
+
+    template <typename Rect>
+    void writeRect(std::ofstream& file, const char* key, const Rect& rect) {
+        file << key << ' ' << rect.x << ' ' << rect.y << ' ' << rect.width << ' ' << rect.height << '\n';
+    }
+}
+
+LayoutProfile LayoutProfile::gameBoyPlayer() {
+    LayoutProfile layout;
+    layout.name = "GameBoyPlayer";
+    layout.screen = cv::Rect(245, 106, 1530, 784);
+    // The crops used before there were profiles, in capture pixels. The dialogue crop starts just left of the screen.
+    layout.dialogue = layout.toNative(cv::Rect(242, 670, 1300, 211));
+    layout.streakLevel50 = layout.toNative(cv::Rect(1580, 375, 120, 90));
+    layout.streakLevel100 = layout.toNative(cv::Rect(1580, 620, 120, 90));
+    return layout;
+}
+
+cv::Rect LayoutProfile::toCapture(const cv::Rect2d& native) const {
+    const double scaleX = static_cast<double>(screen.width) / NATIVE_WIDTH;
+    const double scaleY = static_cast<double>(screen.height) / NATIVE_HEIGHT;
+    int left = screen.x + static_cast<int>(std::lround(native.x * scaleX));
+    int top = screen.y + static_cast<int>(std::lround(native.y * scaleY));
+    int right = screen.x + static_cast<int>(std::lround((native.x + native.width) * scaleX));
+    int bottom = screen.y + static_cast<int>(std::lround((native.y + native.height) * scaleY));
+    return cv::Rect(left, top, right - left, bottom - top);
+}
+
+cv::Rect2d LayoutProfile::toNative(const cv::Rect& capture) const {
+    const double scaleX = static_cast<double>(screen.width) / NATIVE_WIDTH;
+    const double scaleY = static_cast<double>(screen.height) / NATIVE_HEIGHT;
+    return cv::Rect2d((capture.x - screen.x) / scaleX, (capture.y - screen.y) / scaleY, capture.width / scaleX, capture.height / scaleY);
+}
+
+LayoutProfile LayoutProfile::scaledToNative(int multiple) const {
+    LayoutProfile scaled = *this;
+    scaled.screen = cv::Rect(0, 0, NATIVE_WIDTH * multiple, NATIVE_HEIGHT * multiple);
+    return scaled;
+}
+
+bool LayoutProfile::calibrate(const cv::Mat& referenceFrame) {
+    if (referenceFrame.empty() || referenceFrame.channels() < 3) return false;
+
+    const int channels = referenceFrame.channels();
+    const int sampledRows = (referenceFrame.rows + CALIBRATION_STEP - 1) / CALIBRATION_STEP;
+    const int sampledCols = (referenceFrame.cols + CALIBRATION_STEP - 1) / CALIBRATION_STEP;
+    std::vector<int> rowCounts(sampledRows, 0), colCounts(sampledCols, 0);
+    int tealSamples = 0;
+    for (int sy = 0; sy < sampledRows; ++sy) {
+        const uchar* row = referenceFrame.ptr<uchar>(sy * CALIBRATION_STEP);
+        for (int sx = 0; sx < sampledCols; ++sx) {
+            if (isBoxTeal(row + sx * CALIBRATION_STEP * channels)) {
+                rowCounts[sy]++;
+                colCounts[sx]++;
+                tealSamples++;
+            }
+        }
+    }
+
+    int top, bottom, left, right;
+    if (!denseSpan(rowCounts, top, bottom) || !denseSpan(colCounts, left, right)) return false;
+
+    // The box spans most of the screen width and a fair share of its height, and is mostly teal.
+    const int boxWidth = (right - left + 1) * CALIBRATION_STEP;
+    const int boxHeight = (bottom - top + 1) * CALIBRATION_STEP;
+    const double tealShare = static_cast<double>(tealSamples) / ((right - left + 1) * (bottom - top + 1));
+    if (boxWidth * 3 < referenceFrame.cols || boxHeight * 12 < referenceFrame.rows || tealShare < 0.5) {
+        return false;
+    }
+
+    const double scaleX = boxWidth / (BOX_RIGHT - BOX_LEFT);
+    const double scaleY = boxHeight / (BOX_BOTTOM - BOX_TOP);
+    screen = cv::Rect(static_cast<int>(std::lround(left * CALIBRATION_STEP - BOX_LEFT * scaleX)),
+        static_cast<int>(std::lround(top * CALIBRATION_STEP - BOX_TOP * scaleY)),
+        static_cast<int>(std::lround(NATIVE_WIDTH * scaleX)), static_cast<int>(std::lround(NATIVE_HEIGHT * scaleY)));
+    return true;
+}
+
+bool LayoutProfile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening layout profile: " << path << std::endl;
+        return false;
+    }
+
+    LayoutProfile loaded = gameBoyPlayer(); // Regions missing from the file keep their defaults
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "name") {
+            fields >> loaded.name;
+            continue;
+        }
+
+        cv::Rect2d rect;
+        fields >> rect.x >> rect.y >> rect.width >> rect.height;
+        if (!fields) {
+            std::cerr << "Bad line in layout profile: " << line << std::endl;
+            return false;
+        }
+        if (key == "screen") loaded.screen = cv::Rect(rect);
+        else if (key == "dialogue") loaded.dialogue = rect;
+        else if (key == "streak50") loaded.streakLevel50 = rect;
+        else if (key == "streak100") loaded.streakLevel100 = rect;
+    }
+    *this = loaded;
+    return screen.width > 0 && screen.height > 0;
+}
+
+bool LayoutProfile::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error writing layout profile: " << path << std::endl;
+        return false;
+    }
+
+    file << "# Layout profile: screen is in capture pixels, regions are x y width height in GBA pixels (240x160)" << '\n';
+    file << "name " << name << '\n';
+    file << std::setprecision(10); // Enough for regions to map back to the same capture pixels
+    writeRect(file, "screen", screen);
+    writeRect(file, "dialogue", dialogue);
+    writeRect(file, "streak50", streakLevel50);
+    writeRect(file, "streak100", streakLevel100);
+    return static_cast<bool>(file);
+}
+
+const LayoutProfile& defaultLayoutProfile() {
+    static const LayoutProfile layout = LayoutProfile::gameBoyPlayer();
+    return layout;
+}
+
+void downscaleToNative(const cv::Mat& capture, const LayoutProfile& layout, int multiple, cv::Mat& output) {
+    cv::Rect screen = layout.screen & cv::Rect(0, 0, capture.cols, capture.rows);
+    if (multiple <= 0 || screen.empty()) {
+        output = capture;
+        return;
+    }
+    cv::resize(capture(screen), output, cv::Size(LayoutProfile::NATIVE_WIDTH * multiple, LayoutProfile::NATIVE_HEIGHT * multiple),
+        0, 0, cv::INTER_AREA);
+}
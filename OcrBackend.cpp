@@ -0,0 +1,12 @@
+#include "ocrbackend.h"
+#include "imageprocessing.h"
+
+TesseractBackend::TesseractBackend(OcrEnginePool& ocrPool, OcrProfile profile) : ocrPool(ocrPool), profile(profile) {}
+
+std::string TesseractBackend::recognize(const cv::Mat& preprocessed) {
+    return analyzeImage(preprocessed, ocrPool, profile);
+}
+
+const char* TesseractBackend::getName() const {
+    return "tesseract";
+}
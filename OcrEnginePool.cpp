@@ -0,0 +1,97 @@
+/*
+Pool of reusable Tesseract engines shared by the OCR calls in the capture loop.
+*/
+
+#include "ocrenginepool.h"
+#include <iostream>
+
+OcrEnginePool::Lease::Lease(OcrEnginePool* pool, OcrProfile profile, tesseract::TessBaseAPI* engine)
+    : pool(pool), profile(profile), engine(engine) {}
+
+OcrEnginePool::Lease::Lease(Lease&& other) noexcept : pool(other.pool), profile(other.profile), engine(other.engine) {
+    other.engine = nullptr;
+}
+
+OcrEnginePool::Lease::~Lease() {
+    if (engine) {
+        pool->release(profile, engine);
+    }
+}
+
+OcrEnginePool::OcrEnginePool(size_t enginesPerProfile) : enginesPerProfile(enginesPerProfile > 0 ? enginesPerProfile : 1) {}
+
+OcrEnginePool::~OcrEnginePool() {
+    for (ProfileSlots* slots : { &dialogueSlots, &streakSlots }) {
+        for (auto& engine : slots->engines) {
+            engine->End();
+        }
+    }
+}
+
+OcrEnginePool::ProfileSlots& OcrEnginePool::slotsFor(OcrProfile profile) {
+    return profile == OcrProfile::Streak ? streakSlots : dialogueSlots;
+}
+
+// Loads the model and applies the settings for a profile. Returns nullptr if Tesseract fails to initialize.
+std::unique_ptr<tesseract::TessBaseAPI> OcrEnginePool::createEngine(OcrProfile profile) {
+    auto engine = std::make_unique<tesseract::TessBaseAPI>();
+    if (engine->Init(NULL, "eng", tesseract::OEM_LSTM_ONLY)) {
+        std::cerr << "Error intiializing tesseract" << std::endl;
+        return nullptr;
+    }
+
+    engine->SetPageSegMode(tesseract::PSM_SINGLE_BLOCK);
+    if (profile == OcrProfile::Streak) {
+        engine->SetVariable("tessedit_char_whitelist", "0123456789");
+    }
+    else {
+        engine->SetVariable("tessedit_char_whitelist", "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.!?'(),- ");
+    }
+    return engine;
+}
+
+OcrEnginePool::Lease OcrEnginePool::acquire(OcrProfile profile) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    ProfileSlots& slots = slotsFor(profile);
+
+    // Waits for an engine to be returned, or for a reservation to be given back by a failed initialization, in which
+    // case this thread makes the next attempt.
+    engineReturned.wait(lock, [this, &slots] { return !slots.idle.empty() || slots.reserved < enginesPerProfile; });
+    if (slots.idle.empty()) {
+        // Initialization happens outside the lock so other profiles are not held up by the model load.
+        slots.reserved++;
+        lock.unlock();
+        auto engine = createEngine(profile);
+        lock.lock();
+        if (!engine) {
+            slots.reserved--;
+            lock.unlock();
+            engineReturned.notify_all();
+            return Lease(this, profile, nullptr);
+        }
+        slots.engines.push_back(std::move(engine));
+        return Lease(this, profile, slots.engines.back().get());
+    }
+
+    tesseract::TessBaseAPI* engine = slots.idle.back();
+    slots.idle.pop_back();
+    return Lease(this, profile, engine);
+}
+
+void OcrEnginePool::release(OcrProfile profile, tesseract::TessBaseAPI* engine) {
+    engine->Clear(); // Drops the last image and its results, the loaded model stays in memory.
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        slotsFor(profile).idle.push_back(engine);
+    }
+    engineReturned.notify_all();
+}
+
+void OcrEnginePool::warmUp() {
+    for (OcrProfile profile : { OcrProfile::Dialogue, OcrProfile::Streak }) {
+        std::vector<Lease> leases;
+        for (size_t i = 0; i < enginesPerProfile; ++i) {
+            leases.push_back(acquire(profile));
+        }
+    }
+}
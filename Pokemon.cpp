@@ -1,29 +1,18 @@
 #include "pokemon.h"
+#include <algorithm>
 
-Pokemon::Pokemon() : trainerId(-1), Name(""), SeenAbility(""), SeenItem("") {}
-Pokemon::Pokemon(const std::string& name) : trainerId(-1), Name(name), SeenAbility(""), SeenItem("") {}
-Pokemon::Pokemon(const std::string& name, int trainerId) : trainerId(trainerId), Name(name), SeenAbility(""), SeenItem("") {}
-
-std::string Pokemon::getName() const{
-    return Name;
-}
-
-std::string Pokemon::getSeenAbility() const {
-    return SeenAbility;
+bool Pokemon::isEmpty() const {
+    return species == NONE;
 }
 
-std::vector<std::string> Pokemon::getSeenMoves() const {
-    return seenMoves;
+bool Pokemon::addMove(int move) {
+    if (move < 0 || std::find(moves.begin(), moves.end(), move) != moves.end()) return false;
+    auto slot = std::find(moves.begin(), moves.end(), NONE);
+    if (slot == moves.end()) return false;
+    *slot = static_cast<int16_t>(move);
+    return true;
 }
 
-std::string Pokemon::getSeenItem() const {
-    return SeenItem;
+size_t Pokemon::getMoveCount() const {
+    return static_cast<size_t>(std::find(moves.begin(), moves.end(), NONE) - moves.begin());
 }
-
-void Pokemon::setAbility(const std::string& Ability) {
-    SeenAbility = Ability;
-}
-
-void Pokemon::setItem(const std::string& Item) {
-    SeenItem = Item;
-}
\ No newline at end of file
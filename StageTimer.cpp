@@ -0,0 +1,77 @@
+/*
+Per stage latency recording for the benchmarks.
+*/
+
+#include "stagetimer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    std::atomic<LatencyRecorder*> activeRecorder(nullptr);
+
+    const char* const STAGE_NAMES[PIPELINE_STAGE_COUNT] = {
+        "decode", "crop", "detect", "preprocess", "streak", "ocr", "dialogue_logic", "database"
+    };
+
+    // Nearest rank percentile of sorted samples.
+    double percentile(const std::vector<double>& sorted, double fraction) {
+        size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+}
+
+const char* getStageName(PipelineStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < PIPELINE_STAGE_COUNT ? STAGE_NAMES[index] : "unknown";
+}
+
+void LatencyRecorder::record(PipelineStage stage, double micros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    samples[static_cast<size_t>(stage)].push_back(micros);
+}
+
+StageLatency LatencyRecorder::summarize(PipelineStage stage) const {
+    std::vector<double> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = samples[static_cast<size_t>(stage)];
+    }
+
+    StageLatency latency;
+    if (sorted.empty()) return latency;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0;
+    for (double sample : sorted) total += sample;
+    latency.count = sorted.size();
+    latency.mean = total / sorted.size();
+    latency.p50 = percentile(sorted, 0.50);
+    latency.p95 = percentile(sorted, 0.95);
+    latency.p99 = percentile(sorted, 0.99);
+    latency.max = sorted.back();
+    return latency;
+}
+
+void LatencyRecorder::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& stageSamples : samples) stageSamples.clear();
+}
+
+void LatencyRecorder::install(LatencyRecorder* recorder) {
+    activeRecorder = recorder;
+}
+
+LatencyRecorder* LatencyRecorder::active() {
+    return activeRecorder.load(std::memory_order_relaxed);
+}
+
+ScopedStageTimer::ScopedStageTimer(PipelineStage stage) : stage(stage), recorder(LatencyRecorder::active()) {
+    if (recorder) start = std::chrono::steady_clock::now();
+}
+
+ScopedStageTimer::~ScopedStageTimer() {
+    if (!recorder) return;
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    recorder->record(stage, elapsed.count());
+}
@@ -0,0 +1,310 @@
+/*
+Template based reader for the streak counter, replacing Tesseract for the handful of digits it shows.
+*/
+
+#include "streakreader.h"
+#include "imageprocessing.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const int GRID_W = 12;
+    const int GRID_H = 16;
+    const float DIGIT_ASPECT = 0.75f; // Width over height of a digit cell in the game font
+    const int MAX_DIGITS = 3;
+
+    // Rough digits of the game font at native resolution, for digits no labeled capture has shown yet.
+    const char* const DIGIT_SHAPES[10][8] = {
+        { ".####.", "##..##", "##..##", "##..##", "##..##", "##..##", "##..##", ".####." },
+        { "..##..", ".###..", "..##..", "..##..", "..##..", "..##..", "..##..", ".####." },
+        { ".####.", "##..##", "....##", "...##.", "..##..", ".##...", "##....", "######" },
+        { ".####.", "##..##", "....##", "..###.", "....##", "....##", "##..##", ".####." },
+        { "...##.", "..###.", ".####.", "##.##.", "##.##.", "######", "...##.", "...##." },
+        { "######", "##....", "#####.", "....##", "....##", "....##", "##..##", ".####." },
+        { ".####.", "##....", "##....", "#####.", "##..##", "##..##", "##..##", ".####." },
+        { "######", "....##", "....##", "...##.", "...##.", "..##..", "..##..", "..##.." },
+        { ".####.", "##..##", "##..##", ".####.", "##..##", "##..##", "##..##", ".####." },
+        { ".####.", "##..##", "##..##", "##..##", ".#####", "....##", "....##", ".####." }
+    };
+
+    int popcount64(uint64_t value) {
+        int count = 0;
+        while (value) {
+            value &= value - 1;
+            count++;
+        }
+        return count;
+    }
+
+    // Samples a glyph box onto the grid, centred in a box as wide as a digit cell of the same height so that
+    // narrow digits such as 1 keep their shape instead of being stretched.
+    template <typename InkAt>
+    void sampleDigit(InkAt inkAt, int left, int right, int top, int bottom, uint64_t bits[3]) {
+        bits[0] = bits[1] = bits[2] = 0;
+        const float height = static_cast<float>(bottom - top);
+        const float boxWidth = height * DIGIT_ASPECT;
+        const float boxLeft = (left + right) / 2.0f - boxWidth / 2.0f;
+        for (int gy = 0; gy < GRID_H; ++gy) {
+            int y = top + static_cast<int>((gy + 0.5f) * height / GRID_H);
+            for (int gx = 0; gx < GRID_W; ++gx) {
+                int x = static_cast<int>(std::floor(boxLeft + (gx + 0.5f) * boxWidth / GRID_W));
+                if (x >= left && x < right && inkAt(x, y)) {
+                    int bit = gy * GRID_W + gx;
+                    bits[bit / 64] |= uint64_t(1) << (bit % 64);
+                }
+            }
+        }
+    }
+
+    // Otsu threshold over a 256 bin histogram.
+    int otsuThreshold(const int histogram[256], int total) {
+        double sumAll = 0;
+        for (int i = 0; i < 256; ++i) sumAll += static_cast<double>(i) * histogram[i];
+
+        double sumBackground = 0, bestVariance = -1;
+        int weightBackground = 0, threshold = 0;
+        for (int t = 0; t < 256; ++t) {
+            weightBackground += histogram[t];
+            if (weightBackground == 0) continue;
+            int weightForeground = total - weightBackground;
+            if (weightForeground == 0) break;
+
+            sumBackground += static_cast<double>(t) * histogram[t];
+            double meanBackground = sumBackground / weightBackground;
+            double meanForeground = (sumAll - sumBackground) / weightForeground;
+            double variance = static_cast<double>(weightBackground) * weightForeground * (meanBackground - meanForeground) * (meanBackground - meanForeground);
+            if (variance > bestVariance) {
+                bestVariance = variance;
+                threshold = t;
+            }
+        }
+        return threshold;
+    }
+
+    std::string trim(const std::string& text) {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(start, end - start + 1);
+    }
+}
+
+std::vector<StreakLabel> readStreakLabels(const std::string& labelsPath) {
+    std::vector<StreakLabel> labels;
+    std::ifstream file(labelsPath);
+    if (!file) {
+        std::cerr << "Error opening labels file: " << labelsPath << std::endl;
+        return labels;
+    }
+
+    size_t slash = labelsPath.find_last_of("/\\");
+    std::string baseDir = slash == std::string::npos ? "" : labelsPath.substr(0, slash + 1);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string path, region, value;
+        std::getline(fields, path, '|');
+        std::getline(fields, region, '|');
+        std::getline(fields, value, '|');
+        StreakLabel label;
+        label.imagePath = baseDir + trim(path);
+        std::istringstream rect(region);
+        std::istringstream number(value);
+        if (!(rect >> label.region.x >> label.region.y >> label.region.width >> label.region.height) || !(number >> label.value) || label.value < 0) {
+            std::cerr << "Skipping malformed streak label: " << line << std::endl;
+            continue;
+        }
+        labels.push_back(label);
+    }
+    return labels;
+}
+
+StreakReader::StreakReader() {
+    for (int digit = 0; digit < 10; ++digit) {
+        DigitTemplate digitTemplate;
+        digitTemplate.digit = digit;
+        digitTemplate.learned = false;
+        const char* const* shape = DIGIT_SHAPES[digit];
+        sampleDigit([shape](int x, int y) { return shape[y][x] == '#'; }, 0, 6, 0, 8, digitTemplate.shape.bits);
+        templates.push_back(digitTemplate);
+    }
+}
+
+size_t StreakReader::learnFromLabels(const std::vector<StreakLabel>& labels) {
+    // Votes per grid cell and the number of samples, per digit.
+    std::array<std::array<int, GRID_W * GRID_H>, 10> votes{};
+    std::array<int, 10> samples{};
+    size_t learned = 0;
+
+    for (const StreakLabel& label : labels) {
+        cv::Mat image = cv::imread(label.imagePath);
+        if (image.empty()) {
+            std::cerr << "Error loading: " << label.imagePath << std::endl;
+            continue;
+        }
+        cv::Rect region = label.region & cv::Rect(0, 0, image.cols, image.rows);
+        if (region.empty() || !sampleDigits(image(region))) continue;
+
+        std::string digits = std::to_string(label.value);
+        if (digits.size() != sampled.size()) {
+            std::cerr << "Found " << sampled.size() << " digits instead of " << digits.size() << " in " << label.imagePath << ", skipping it" << std::endl;
+            continue;
+        }
+        for (size_t i = 0; i < digits.size(); ++i) {
+            int digit = digits[i] - '0';
+            for (int bit = 0; bit < GRID_W * GRID_H; ++bit) {
+                votes[digit][bit] += (sampled[i].bits[bit / 64] >> (bit % 64)) & 1;
+            }
+            samples[digit]++;
+            learned++;
+        }
+    }
+
+    for (DigitTemplate& digitTemplate : templates) {
+        const int digit = digitTemplate.digit;
+        if (samples[digit] == 0) continue;
+        digitTemplate.shape = DigitBits{ { 0, 0, 0 } };
+        for (int bit = 0; bit < GRID_W * GRID_H; ++bit) {
+            if (votes[digit][bit] * 2 > samples[digit]) digitTemplate.shape.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+        digitTemplate.learned = true;
+    }
+    return learned;
+}
+
+size_t StreakReader::getLearnedDigits() const {
+    return static_cast<size_t>(std::count_if(templates.begin(), templates.end(), [](const DigitTemplate& digitTemplate) {
+        return digitTemplate.learned;
+    }));
+}
+
+StreakReading StreakReader::read(const cv::Mat& screenshot, const std::string& level, const LayoutProfile& layout) {
+    return readRegion(cropToStreakCount(screenshot, level, layout));
+}
+
+StreakReading StreakReader::readRegion(const cv::Mat& streakCrop) {
+    StreakReading reading;
+    if (!sampleDigits(streakCrop)) return reading;
+
+    int value = 0;
+    float confidence = 1.0f;
+    for (const DigitBits& digitBits : sampled) {
+        int bestDigit = 0;
+        int bestDistance = GRID_W * GRID_H + 1;
+        for (const auto& digitTemplate : templates) {
+            int distance = popcount64(digitBits.bits[0] ^ digitTemplate.shape.bits[0]) + popcount64(digitBits.bits[1] ^ digitTemplate.shape.bits[1])
+                + popcount64(digitBits.bits[2] ^ digitTemplate.shape.bits[2]);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestDigit = digitTemplate.digit;
+            }
+        }
+
+        value = value * 10 + bestDigit;
+        confidence = std::min(confidence, std::max(0.0f, 1.0f - bestDistance / (GRID_W * GRID_H / 2.0f)));
+    }
+
+    reading.value = value;
+    reading.confidence = confidence;
+    return reading;
+}
+
+bool StreakReader::sampleDigits(const cv::Mat& streakCrop) {
+    sampled.clear();
+    if (streakCrop.empty()) return false;
+
+    const int width = streakCrop.cols;
+    const int height = streakCrop.rows;
+    const int channels = streakCrop.channels();
+
+    // Threshold the luminance, digits are whichever side of the threshold covers fewer pixels.
+    ink.resize(static_cast<size_t>(width) * height);
+    int histogram[256] = { 0 };
+    for (int y = 0; y < height; ++y) {
+        const uchar* row = streakCrop.ptr<uchar>(y);
+        for (int x = 0; x < width; ++x) {
+            const uchar* px = row + x * channels;
+            int value = channels >= 3 ? (px[0] * 29 + px[1] * 150 + px[2] * 77) >> 8 : px[0];
+            ink[static_cast<size_t>(y) * width + x] = static_cast<uchar>(value);
+            histogram[value]++;
+        }
+    }
+    const int threshold = otsuThreshold(histogram, width * height);
+    size_t dark = 0;
+    for (uchar value : ink) dark += value <= threshold;
+    const bool digitsAreDark = dark < ink.size() / 2;
+    for (uchar& value : ink) value = (value <= threshold) == digitsAreDark;
+
+    // Column projection: every run of columns containing ink is a blob with its own vertical extent.
+    struct Blob { int left, right, top, bottom; };
+    std::vector<Blob> blobs;
+    int runStart = -1;
+    for (int x = 0; x <= width; ++x) {
+        int top = height, bottom = -1;
+        if (x < width) {
+            for (int y = 0; y < height; ++y) {
+                if (ink[static_cast<size_t>(y) * width + x]) {
+                    top = std::min(top, y);
+                    bottom = y;
+                }
+            }
+        }
+
+        if (bottom >= 0 && runStart < 0) {
+            runStart = x;
+        }
+        else if (bottom < 0 && runStart >= 0) {
+            Blob blob = { runStart, x, height, 0 };
+            for (int bx = blob.left; bx < blob.right; ++bx) {
+                for (int y = 0; y < height; ++y) {
+                    if (ink[static_cast<size_t>(y) * width + bx]) {
+                        blob.top = std::min(blob.top, y);
+                        blob.bottom = std::max(blob.bottom, y + 1);
+                    }
+                }
+            }
+            blobs.push_back(blob);
+            runStart = -1;
+        }
+    }
+    if (blobs.empty()) return false;
+
+    // Specks and punctuation are much shorter than the digits.
+    int tallest = 0;
+    for (const auto& blob : blobs) tallest = std::max(tallest, blob.bottom - blob.top);
+    blobs.erase(std::remove_if(blobs.begin(), blobs.end(), [tallest](const Blob& blob) {
+        return (blob.bottom - blob.top) * 2 < tallest;
+    }), blobs.end());
+
+    auto inkAt = [this, width, height](int x, int y) {
+        return x >= 0 && x < width && y >= 0 && y < height && ink[static_cast<size_t>(y) * width + x] != 0;
+    };
+
+    for (const auto& blob : blobs) {
+        // Blurred captures can join neighbouring digits, so wide blobs are split by the expected digit width.
+        const int blobHeight = blob.bottom - blob.top;
+        const float digitWidth = blobHeight * DIGIT_ASPECT * 1.05f;
+        const int parts = std::max(1, static_cast<int>(std::lround((blob.right - blob.left) / digitWidth)));
+
+        for (int part = 0; part < parts; ++part) {
+            if (sampled.size() == MAX_DIGITS) {
+                sampled.clear();
+                return false;
+            }
+
+            int left = blob.left + (blob.right - blob.left) * part / parts;
+            int right = blob.left + (blob.right - blob.left) * (part + 1) / parts;
+            sampled.emplace_back();
+            sampleDigit(inkAt, left, right, blob.top, blob.bottom, sampled.back().bits);
+        }
+    }
+    return true;
+}
@@ -1,33 +1,25 @@
 #include "trainer.h"
-#include "databaseinterface.h"
+#include "databasewriter.h"
 
 
-Trainer::Trainer(std::string trainerName) { //Constructor
-    db = DatabaseInterface::getDB();
+Trainer::Trainer(std::string_view trainerName) { //Constructor
     name = trainerName;
 
-    trainerID = DatabaseInterface::getOrCreateTrainer(name);
     initActiveTeam();
 }
 
-Trainer::Trainer(std::string trainerName, int streakNumber) { //Constructor with streak number
-    db = DatabaseInterface::getDB();
+Trainer::Trainer(std::string_view trainerName, int streakNumber) { //Constructor with streak number
     name = trainerName;
 
     streakNumber = streakNumber;
-    trainerID = DatabaseInterface::getOrCreateTrainer(name);
     initActiveTeam();
 }
 
-int Trainer::getTrainerID() const {
-    return trainerID;
-}
-
-std::vector<Pokemon> Trainer::grabMon(const std::string& pokeName) { //Awkward with the unneeded vectors, but will leave like so for future 2D ActiveTeam
+std::vector<Pokemon> Trainer::grabMon(int species) { //Awkward with the unneeded vectors, but will leave like so for future 2D ActiveTeam
     std::vector<Pokemon> matches;
 
     for (const auto& p : potentialTeam) {
-        if (p.getName() == pokeName) {
+        if (p.species == species) {
             matches.push_back(p);
         }
     }
@@ -37,56 +29,52 @@ std::vector<Pokemon> Trainer::grabMon(const std::string& pokeName) { //Awkward w
 
 void Trainer::initActiveTeam() {
     //3 slots for a singles Pokemon battle.
-    activeTeam.resize(3);
+    activeTeam.fill(Pokemon());
+    activeSlot = -1;
 }
 
-std::string Trainer::getTrainerName() const {
+std::string_view Trainer::getTrainerName() const {
     return name;
 }
 
-void Trainer::updateActiveSlot(const std::string& pokemonName) {
-    //std::vector<Pokemon> NewMon = grabMon(pokemonName); //Leave as vector for change to 2D Active Team later one
-
-	activeTeam.push_back(Pokemon(pokemonName)); //Add the Pokemon to the active team
+void Trainer::updateActiveSlot(int species) {
+    //std::vector<Pokemon> NewMon = grabMon(species); //Leave as vector for change to 2D Active Team later one
 
-}
-
-bool Trainer::isPokemonInActive(const std::string& pokemonName) {
-    for (const auto& p : activeTeam) {
-        if (p.getName() == pokemonName) {
-            return true;
+    for (size_t i = 0; i < activeTeam.size(); i++) { //Switched back in
+        if (activeTeam[i].species == species) {
+            activeSlot = static_cast<int>(i);
+            return;
         }
     }
-    return false;
-}
-
-int Trainer::getPokemonID(const std::string& name) {
-    int pokemonID = DatabaseInterface::getPokemonID(trainerID, name);
-
-    return pokemonID;
-}
-
-void Trainer::trainerAddSeenMove(int pokemonID, const std::string& moveName) {
-    DatabaseInterface::addSeenMove(pokemonID, moveName);
+    for (size_t i = 0; i < activeTeam.size(); i++) {
+        if (activeTeam[i].isEmpty()) {
+            activeTeam[i].species = static_cast<int16_t>(species); //Add the Pokemon to the active team
+            activeSlot = static_cast<int>(i);
+            return;
+        }
+    }
+    activeSlot = -1;
 }
 
-void Trainer::trainerAddSeenAbility(int pokemonID, const std::string& ability) {
-    DatabaseInterface::addSeenAbility(pokemonID, ability);
+Pokemon* Trainer::getActivePokemon() {
+    return activeSlot >= 0 ? &activeTeam[activeSlot] : nullptr;
 }
 
-void Trainer::trainerAddSeenItem(int pokemonID, const std::string& item) {
-    DatabaseInterface::addSeenItem(pokemonID, item);
+void Trainer::clearActiveSlot() {
+    activeSlot = -1;
 }
 
-
-std::vector<std::string> Trainer::getSeenMoves(int pokemonID) {
-    return DatabaseInterface::getSeenMoves(pokemonID);
+bool Trainer::isPokemonInActive(int species) const {
+    for (const auto& p : activeTeam) {
+        if (!p.isEmpty() && p.species == species) {
+            return true;
+        }
+    }
+    return false;
 }
 
 Trainer::~Trainer() { //Deconstructor to save new information gained at the end of the battle
-    //Save new information
-    DatabaseInterface::persistTrainerData(trainerID, activeTeam);
-
-    //Safely close the database
-    DatabaseInterface::closeDB();
+    //Hand the new information to the database writer, the battle reading thread does not wait for it to be saved.
+    //The connection stays open for the next trainer.
+    DatabaseWriter::shared().enqueue({ name, activeTeam });
 }
\ No newline at end of file
@@ -0,0 +1,206 @@
+/*
+In-memory copy of the trainer knowledge in the database, for scouting a trainer the moment they are detected.
+*/
+
+#include "trainerknowledge.h"
+#include "gamedata.h"
+#include "knowledgesnapshot.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // Database IDs count up from 1, so the vectors grow to the highest ID seen.
+    template <typename T>
+    T& growTo(std::vector<T>& items, int index, const T& fill = T()) {
+        if (static_cast<size_t>(index) >= items.size()) items.resize(index + 1, fill);
+        return items[index];
+    }
+
+    const char* columnText(sqlite3_stmt* stmt, int column) {
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        return text ? reinterpret_cast<const char*>(text) : "";
+    }
+
+    // Runs a query and hands every row to visit. Returns false if the query could not be run.
+    template <typename Visit>
+    bool forEachRow(sqlite3* db, const char* query, const Visit& visit) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error loading trainer knowledge: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        int result;
+        while ((result = sqlite3_step(stmt)) == SQLITE_ROW) visit(stmt);
+        sqlite3_finalize(stmt);
+        return result == SQLITE_DONE;
+    }
+}
+
+TrainerKnowledge::TrainerKnowledge() : loaded(false), trainerCount(0), pokemonCount(0) {}
+
+void TrainerKnowledge::clearLocked() {
+    loaded = false;
+    trainers.assign(GameData::trainers.size(), TrainerHistory());
+    trainerNames.clear();
+    pokemonLocations.clear();
+    trainerCount = 0;
+    pokemonCount = 0;
+}
+
+bool TrainerKnowledge::load(sqlite3* db) {
+    std::lock_guard<std::mutex> guard(lock);
+    clearLocked();
+    if (!db) return false;
+
+    bool ok = forEachRow(db, "SELECT trainer_id, name FROM Trainers;", [this](sqlite3_stmt* stmt) {
+        addTrainerLocked(sqlite3_column_int(stmt, 0), columnText(stmt, 1));
+    });
+    ok = ok && forEachRow(db, "SELECT pokemon_id, trainer_id, name FROM Pokemon ORDER BY pokemon_id;", [this](sqlite3_stmt* stmt) {
+        addPokemonLocked(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), columnText(stmt, 2));
+    });
+    const std::pair<const char*, EntityType> seenTables[] = {
+        { "SELECT pokemon_id, move FROM SeenMoves;", EntityType::Move },
+        { "SELECT pokemon_id, ability FROM SeenAbilities;", EntityType::Ability },
+        { "SELECT pokemon_id, item FROM SeenItems;", EntityType::Item }
+    };
+    for (const auto& table : seenTables) {
+        ok = ok && forEachRow(db, table.first, [this, &table](sqlite3_stmt* stmt) {
+            addSeenLocked(sqlite3_column_int(stmt, 0), table.second, columnText(stmt, 1));
+        });
+    }
+
+    if (!ok) {
+        trainers.clear();
+        trainerNames.clear();
+        pokemonLocations.clear();
+        trainerCount = 0;
+        pokemonCount = 0;
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool TrainerKnowledge::load(const KnowledgeSnapshot& snapshot) {
+    std::lock_guard<std::mutex> guard(lock);
+    clearLocked();
+    if (!snapshot.isOpen()) return false;
+
+    const EntityType seenTypes[] = { EntityType::Move, EntityType::Ability, EntityType::Item };
+    for (int trainer = 0; trainer < snapshot.getTrainerCount(); trainer++) {
+        int trainerID = snapshot.getTrainerID(trainer);
+        addTrainerLocked(trainerID, snapshot.getTrainerName(trainer));
+        KnowledgeSnapshot::Team team = snapshot.getTeam(trainer);
+        for (int pokemon = team.first; pokemon < team.first + team.count; pokemon++) {
+            int pokemonID = snapshot.getPokemonID(pokemon);
+            addPokemonLocked(pokemonID, trainerID, snapshot.getPokemonName(pokemon));
+            for (EntityType type : seenTypes) {
+                for (int seen = 0; seen < snapshot.getSeenCount(pokemon, type); seen++) {
+                    addSeenLocked(pokemonID, type, snapshot.getSeen(pokemon, type, seen));
+                }
+            }
+        }
+    }
+    loaded = true;
+    return true;
+}
+
+bool TrainerKnowledge::isLoaded() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return loaded;
+}
+
+void TrainerKnowledge::addTrainerLocked(int trainerID, std::string_view name) {
+    int gameDataID = GameData::trainers.find(name);
+    if (trainerID < 0 || gameDataID == GameData::NOT_FOUND) return;
+    if (trainers[gameDataID].trainerID < 0) trainerCount++;
+    trainers[gameDataID].trainerID = trainerID;
+    growTo(trainerNames, trainerID, -1) = gameDataID;
+}
+
+void TrainerKnowledge::addPokemonLocked(int pokemonID, int trainerID, std::string_view name) {
+    if (pokemonID < 0 || trainerID < 0 || static_cast<size_t>(trainerID) >= trainerNames.size()) return;
+    int trainer = trainerNames[trainerID];
+    int species = GameData::pokemon.find(name);
+    if (trainer < 0 || species == GameData::NOT_FOUND) return;
+
+    std::vector<PokemonHistory>& team = trainers[trainer].pokemon;
+    PokemonHistory& pokemon = team.emplace_back();
+    pokemon.pokemonID = pokemonID;
+    pokemon.species = species;
+    growTo(pokemonLocations, pokemonID) = { trainer, static_cast<int>(team.size()) - 1 };
+    pokemonCount++;
+}
+
+void TrainerKnowledge::addSeenLocked(int pokemonID, EntityType type, std::string_view name) {
+    if (pokemonID < 0 || static_cast<size_t>(pokemonID) >= pokemonLocations.size()) return;
+    const PokemonLocation& location = pokemonLocations[pokemonID];
+    if (location.trainer < 0) return;
+    PokemonHistory& pokemon = trainers[location.trainer].pokemon[location.slot];
+
+    std::vector<int>* seen;
+    int id;
+    switch (type) {
+    case EntityType::Move: seen = &pokemon.moves; id = GameData::moves.find(name); break;
+    case EntityType::Ability: seen = &pokemon.abilities; id = GameData::abilities.find(name); break;
+    case EntityType::Item: seen = &pokemon.items; id = GameData::items.find(name); break;
+    default: return;
+    }
+    if (id != GameData::NOT_FOUND && std::find(seen->begin(), seen->end(), id) == seen->end()) seen->push_back(id);
+}
+
+int TrainerKnowledge::findTrainerID(std::string_view name) const {
+    int gameDataID = GameData::trainers.find(name);
+    std::lock_guard<std::mutex> guard(lock);
+    if (!loaded || gameDataID == GameData::NOT_FOUND) return -1;
+    return trainers[gameDataID].trainerID;
+}
+
+bool TrainerKnowledge::getHistory(std::string_view name, TrainerHistory& history) const {
+    int gameDataID = GameData::trainers.find(name);
+    std::lock_guard<std::mutex> guard(lock);
+    if (!loaded || gameDataID == GameData::NOT_FOUND || trainers[gameDataID].trainerID < 0) return false;
+
+    const TrainerHistory& known = trainers[gameDataID];
+    history.trainerID = known.trainerID;
+    history.pokemon.resize(known.pokemon.size());
+    for (size_t i = 0; i < known.pokemon.size(); i++) {
+        PokemonHistory& pokemon = history.pokemon[i];
+        pokemon.pokemonID = known.pokemon[i].pokemonID;
+        pokemon.species = known.pokemon[i].species;
+        pokemon.moves.assign(known.pokemon[i].moves.begin(), known.pokemon[i].moves.end());
+        pokemon.abilities.assign(known.pokemon[i].abilities.begin(), known.pokemon[i].abilities.end());
+        pokemon.items.assign(known.pokemon[i].items.begin(), known.pokemon[i].items.end());
+    }
+    return true;
+}
+
+void TrainerKnowledge::addTrainer(int trainerID, std::string_view name) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (loaded) addTrainerLocked(trainerID, name);
+}
+
+void TrainerKnowledge::addPokemon(int pokemonID, int trainerID, std::string_view name) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (loaded) addPokemonLocked(pokemonID, trainerID, name);
+}
+
+void TrainerKnowledge::addSeen(int pokemonID, EntityType type, std::string_view name) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (loaded) addSeenLocked(pokemonID, type, name);
+}
+
+size_t TrainerKnowledge::getTrainerCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return trainerCount;
+}
+
+size_t TrainerKnowledge::getPokemonCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return pokemonCount;
+}
+
+TrainerKnowledge& TrainerKnowledge::shared() {
+    static TrainerKnowledge knowledge;
+    return knowledge;
+}
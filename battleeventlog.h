@@ -0,0 +1,127 @@
+#pragma once
+#ifndef BATTLEEVENTLOG_H
+#define BATTLEEVENTLOG_H
+
+#include "databaseinterface.h"
+#include "pokemon.h"
+#include "trainerknowledge.h"
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// What the battle logic read from a line. Values are GameData IDs unless noted.
+enum class BattleEventType : uint8_t {
+    StreakDetected,  // value: sets completed before this one
+    TrainerFound,    // value: trainer
+    PokemonSentOut,  // value: species
+    MoveSeen,        // value: move, used by the Pokemon out
+    AbilitySeen,     // value: ability
+    ItemSeen,        // value: item
+    FoeFainted,      // value: species of the Pokemon out, or -1
+    TrainerDefeated, // value: trainer
+    StreakWon,       // value: sets completed after the win
+    StreakLost,      // value: 0
+    Count
+};
+
+struct BattleEvent {
+    BattleEventType type = BattleEventType::Count;
+    int32_t value = -1;
+    uint32_t frame = 0;     // Capture sequence number of the frame the line was read from
+    double timestamp = 0.0; // Seconds from the start of the run to the capture of that frame
+};
+
+// Counts from reading a log.
+struct BattleEventLogStats {
+    uint64_t events = 0;
+    uint64_t blocks = 0;
+    uint64_t intactBytes = 0;  // Header and every block before the first damaged one
+    bool damagedTail = false;  // A block was cut short or failed its checksum, the log was read up to it
+};
+
+// Append-only file of battle events. Events are held until a block of them is full, or flush is called, and each
+// block is written with its event count and a CRC-32 of its records, so a block torn by a crash is found and left out
+// on reading. Records are 16 bytes with the timestamp in milliseconds.
+class BattleEventLog {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+    static const size_t BLOCK_EVENTS = 256;
+
+private:
+    std::ofstream file;
+    std::vector<BattleEvent> pending;
+    std::vector<char> encoded; // Block being written, reused between blocks
+    uint64_t eventsWritten;
+    uint64_t blocksWritten;
+
+public:
+    BattleEventLog();
+    ~BattleEventLog();
+
+    BattleEventLog(const BattleEventLog&) = delete;
+    BattleEventLog& operator=(const BattleEventLog&) = delete;
+
+    //Creates the log, or opens it to append after its last intact block, cutting off a damaged tail. Returns false
+    //when the file can't be written or is not an event log.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    //Adds an event, writing the block once it is full.
+    void append(const BattleEvent& event);
+
+    //Writes the events held so far as a block, even a short one.
+    void flush();
+
+    uint64_t getEventsWritten() const;
+    uint64_t getBlocksWritten() const;
+
+    //Reads the intact blocks of a log in order and hands every event to visit, stopping at the first damaged block.
+    //Returns false when the file can't be read or is not an event log.
+    static bool read(const std::string& path, const std::function<void(const BattleEvent&)>& visit, BattleEventLogStats* stats = nullptr);
+};
+
+// Rebuilds what the battles in a log taught, by playing the events through the same rules as BattleLogic and Trainer:
+// a battle's Pokemon fill the three team slots in the order sent out, details go to the Pokemon out, and a team is
+// added to its trainer's history when the battle ends. Trainers are kept by GameData ID, with no database IDs.
+class BattleEventReplayer {
+private:
+    std::vector<TrainerHistory> trainers; // By GameData trainer ID
+    Team team;                            // Pokemon of the battle being played
+    int currentTrainer;                   // GameData ID, -1 between battles
+    int activeSlot;                       // Team slot of the Pokemon out, -1 before one is sent out
+    int currentStreak;
+    uint64_t eventsApplied;
+    uint64_t eventsRejected;
+    uint64_t battles;
+
+    void endBattle();
+
+public:
+    BattleEventReplayer();
+
+    //Plays one event. Events with a value out of range for their type are counted and ignored.
+    void apply(const BattleEvent& event);
+
+    //Plays a whole log, then ends the battle it stops in. Returns false when the log can't be read.
+    bool replay(const std::string& path, BattleEventLogStats* stats = nullptr);
+
+    //Ends the battle being played, as the program exiting mid battle would.
+    void finish();
+
+    //A trainer's Pokemon and what they were seen with, empty when the trainer was not battled.
+    const TrainerHistory& getHistory(int trainer) const;
+
+    //Appends one record per Pokemon and per detail seen, for DatabaseInterface::ingestSightings. Trainers that were
+    //found but never sent out a Pokemon have nothing to ingest and are left out.
+    void toSightings(std::vector<SightingRecord>& records) const;
+
+    int getCurrentStreak() const;
+    uint64_t getEventsApplied() const;
+    uint64_t getEventsRejected() const;
+    uint64_t getBattles() const;
+};
+
+#endif
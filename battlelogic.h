@@ -2,18 +2,51 @@
 #ifndef BATTLELOGIC_H
 #define BATTLELOGIC_H
 
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "trainer.h"
+#include "battleeventlog.h"
 #include "databaseinterface.h"
+#include "dialoguestatemachine.h"
+#include "dialoguetokenizer.h"
+#include "entitymatcher.h"
+#include "fuzzyentityindex.h"
+#include "trainerknowledge.h"
 
 class BattleLogic {
 private:
 	int currentStreak; // Initialized to -1 to indicate that no streak number has been set yet
+	int streakReadings[2]; // Level 50 and open level counters of the results screen, -1 until read. Held until the level being challenged is known
+	int facilityLevel; // 50 or 100 once the level being challenged has been told apart, 0 before
 	int state; // 0: Waiting for streak to be displayed or dialogue indicating a streak is being entered, 1: Waiting for the battle to start and see the trainer name, 2: Looking for Pokemon to be displayed and double checking that user's Pokemon is not being added as well as the trainer has a max of 3 Pokemon, 3: Waiting for Pokemon moves, items, or abilities to be revealed while that specific Pokemon is out. 
-	Trainer* currentTrainer; //Current trainer in the battle
+	std::optional<Trainer> currentTrainer; //Current trainer in the battle, held in place so starting a battle does not allocate
+	DialogueTokenizer tokens; //Words of the line being handled, reused so that handling a line does not allocate
+	std::vector<EntitySpan> entities; //Names found in the line, reused like tokens
+	DialogueStateMachine dialogueStates; //Triggers of the battle facility being read
+	TrainerHistory scouting; //What the current trainer has shown before, reused between trainers
+	BattleEventLog* eventLog; //Where what is read gets recorded, null when it is not
+	uint32_t lineFrame; //Frame the line being handled was read from
+	double lineTimestamp;
+
+	//Carries out a matched trigger's action, returns false when the line turned out not to be what the trigger expects.
+	bool runAction(const TriggerMatch& trigger);
+	void startTrainerBattle(std::string_view trainerName);
+
+	//Takes the streak of the level whose counter fits the opponent number announced from tokens[firstToken] on.
+	void chooseFacilityLevel(size_t firstToken);
+
+	//Records a move, ability or item revealed by the foe on the Pokemon it has out.
+	void revealDetail(EntityType type, int id);
+	void recordEvent(BattleEventType type, int value);
+
+	//Best fuzzy match above the confidence threshold among windows of minWords to maxWords tokens that lie within
+	//tokens [firstToken, endToken).
+	bool findMisreadName(size_t firstToken, size_t endToken, size_t minWords, size_t maxWords, unsigned typeMask, FuzzyMatch& best) const;
 
 public:
-	BattleLogic();
+	explicit BattleLogic(const std::vector<DialogueTrigger>& facilityTriggers = battleTowerSingles());
 	~BattleLogic();
 
 	void resetState(bool win);
@@ -25,10 +58,24 @@ public:
 	int getCurrentStreak() const;
 	void setCurrentStreak(int streak);
 
-	void handleDialogueLine(const std::string& dialogue);
+	//Records every event read to the log from now on, nullptr to stop. The log is flushed at the end of each battle.
+	void setEventLog(BattleEventLog* log);
+
+	//The frame the next lines and streak numbers come from, stamped on the events they cause.
+	void setFrame(uint64_t frame, double timestamp);
+
+	//Reads one line and acts on it. Once the first lines have built the shared name indexes and started the database
+	//writer, this makes no heap allocations. The scouting report grows its reused history to the largest one seen, and
+	//a trainer not yet in the database is added through SQLite.
+	void handleDialogueLine(std::string_view dialogue);
 	void handleStreakNumber(int streak);
 
-	std::vector<std::string> tokenizeDialogue(const std::string& dialogue);
+	//Both streak counters of the results screen, -1 for one that was not read. Until the level being challenged is
+	//known, neither is taken before the next challenge is announced.
+	void handleStreakNumbers(int level50Streak, int openLevelStreak);
+
+	//50 or 100 once the level being challenged is known, 0 before.
+	int getFacilityLevel() const;
 };
 
 
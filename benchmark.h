@@ -0,0 +1,85 @@
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+
+//Offline benchmarks that replay the TestScreenshots corpus, ran from the command line with --bench <name> [corpus directory].
+namespace Benchmark {
+
+    //Replays a frame source (a screenshot directory or "video:<file>") through the full pipeline and reports
+    //frames/sec and p50/p95/p99 latency per stage. Results are also written to resultsPath when given, as JSON
+    //(.json, overwritten) or CSV (anything else, appended so runs of successive builds can be compared). Each row
+    //carries the build and the UTC time the run started.
+    void pipeline(const std::string& sourceSpec, const std::string& resultsPath = "", const std::string& atlasPath = "");
+
+    //Compares OCR throughput of a fresh Tesseract engine per crop against the reusable engine pool.
+    void ocrEnginePool(const std::string& corpusDir, int passes = 3);
+
+    //Times the blank dialogue detector and scores it against whether OCR finds any text in the same crop.
+    void blankDetector(const std::string& corpusDir, int repetitions = 1000);
+
+    //Times the fused preprocessing kernel, plain and colour keyed, against the cvtColor + Otsu + resize chain it
+    //replaced on the dialogue box crop, and counts output pixels where the fused kernel differs from the chain.
+    void preprocessKernel(const std::string& corpusDir, int repetitions = 200);
+
+    //Times the per frame preprocess stage work (crop, blank detection, preprocessing, streak reading) at capture
+    //resolution against frames first shrunk to a multiple of the GBA resolution, and compares the dialogue pixels.
+    void nativeScale(const std::string& corpusDir, int multiple = 2, int repetitions = 20);
+
+    //Compares the glyph recognizer with Tesseract on the frames listed in <corpus>/labels.txt, on speed and on
+    //character accuracy against the labeled text.
+    void glyphRecognizer(const std::string& corpusDir, const std::string& atlasPath, int repetitions = 20);
+
+    //Compares the compile time GameData tables with the unordered_set<string> lists they replaced: the cost of
+    //building the sets at startup, their memory and lookup ns/op for names in the lists and near misses.
+    void gameData(int repetitions = 200);
+
+    //Builds the fuzzy GameData index and measures lookups per second and recall on names with OCR style errors put
+    //in (confused glyphs, dropped and doubled characters), and how many ordinary dialogue words it wrongly resolves.
+    void fuzzyIndex(int samples = 5000);
+
+    //Writes teams the way persistTrainerData does into a scratch database, preparing every statement per call as
+    //DatabaseInterface used to and through its statement cache, and reports statements per second for both.
+    void databaseInserts(int trainers = 2000);
+
+    //Bulk ingests generated sessions into a scratch database, with its normal durability settings, and reports
+    //records per second and the rows added.
+    void bulkIngest(int sessions = 20000, int batches = 10);
+
+    //Loads the trainer knowledge cache from a scratch database of generated sessions, then times the scouting report
+    //for every trainer from the cache against querying the Pokemon and Seen tables for it.
+    void trainerKnowledge(int sessions = 2000);
+
+    //Fills a scratch database at the first schema version with the duplicate Pokemon it used to collect, migrates it
+    //to the latest version, and prints the row counts, query plans and Pokemon ID lookup time before and after.
+    void databaseSchema(int sessions = 2000);
+
+    //Saves battles on one thread while readerThreads make lookups, through the shared writer connection and then
+    //through the read-only pool, and reports reads and saves per second for both.
+    void databaseConcurrency(int seconds = 2, int readerThreads = 3);
+
+    //Exports a knowledge snapshot of a scratch database of generated sessions, then times mapping it, loading the
+    //trainer knowledge cache from it against loading by query, reports read from the mapping, and refreshing it.
+    void knowledgeSnapshot(int sessions = 20000, int repetitions = 100);
+
+    //Plays battles from generated OCR names into a team of Pokemon held as strings, as Pokemon used to be, and into
+    //one held as GameData IDs, and reports battles per second and the size of a team for both.
+    void teamLayout(int battles = 200000);
+
+    //Feeds the line stabilizer the box changes and glyph column counts of generated dialogue printing a few
+    //characters a frame, and reports OCR calls per line against reading every changed box, and lines read once.
+    void lineStabilizer(int lines = 1000, int charactersPerFrame = 3, int stableFrames = 2);
+
+    //Measures the CPU a captured frame costs before OCR, then plays hours of a Battle Tower state timeline on a
+    //simulated clock with the old sleep after every frame, fixed deadlines and deadlines by battle state, and reports
+    //the capture rate, missed deadlines and CPU per hour of each.
+    void captureScheduler(const std::string& corpusDir, double hours = 1.0, double fixedInterval = 0.333);
+
+    //Writes the events of generated Battle Tower sets to a scratch event log, flushed after every battle, then reports
+    //events per second read, replayed into memory, the database rebuilt from them, and recovery from a torn last block.
+    void eventLog(int battles = 200000);
+
+}
+
+#endif
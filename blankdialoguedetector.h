@@ -0,0 +1,54 @@
+#pragma once
+#ifndef BLANKDIALOGUEDETECTOR_H
+#define BLANKDIALOGUEDETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// What the dialogue region of a frame contains, as far as the blank detector can tell.
+enum class DialogueContent {
+    Text,     // Glyph-like ink on a uniform background, worth running OCR on
+    EmptyBox, // Uniform box background with no ink
+    NoBox     // No dominant background color, a transition, menu or animation covers the region
+};
+
+// Pre-OCR classifier that decides from a sparse sample of the dialogue crop whether any glyphs are present.
+// The most common luminance is taken as the box background, pixels far from it count as ink, and the row
+// projection of the ink has to contain a run at least one glyph tall. Rows and columns that are almost entirely
+// ink are treated as the box frame and ignored.
+class BlankDialogueDetector {
+private:
+    int sampleStep;             // Every sampleStep-th pixel and row is looked at
+    int inkDelta;               // Luminance distance from the background that counts as ink
+    double minBackgroundShare;  // Fraction of samples the background must cover for a box to be present
+    double minInkRatio;         // Ink fraction below which a box is considered empty
+    int minGlyphRows;           // Consecutive sampled rows with ink needed to look like a line of text
+
+    std::vector<uchar> lumaSamples;     // Reused between frames, so classify() is not thread safe
+    std::vector<int> columnInkCounts;
+    std::vector<uchar> textColumns;     // Sampled columns with ink on a text row
+    int glyphColumns;
+
+    std::atomic<uint64_t> framesWithText;
+    std::atomic<uint64_t> framesBlank;
+
+public:
+    BlankDialogueDetector(int sampleStep = 3, int inkDelta = 64, double minBackgroundShare = 0.5,
+        double minInkRatio = 0.002, int minGlyphRows = 4);
+
+    //Classifies a BGR dialogue crop.
+    DialogueContent classify(const cv::Mat& dialogueCrop);
+
+    //True when the crop is worth sending to OCR.
+    bool hasText(const cv::Mat& dialogueCrop);
+
+    //Sampled columns with glyph ink in the last crop classified as Text, 0 otherwise. Grows as a line prints.
+    int getGlyphColumns() const;
+
+    uint64_t getFramesWithText() const;
+    uint64_t getFramesBlank() const;
+};
+
+#endif
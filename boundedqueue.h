@@ -0,0 +1,122 @@
+#pragma once
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// Fixed capacity lock-free queue used to hand frames between pipeline stages. Any number of threads may push
+// and pop. Each cell carries a sequence number that tells producers and consumers whether it is free or filled,
+// so neither side ever takes a lock.
+template <typename T>
+class BoundedQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+public:
+    //Capacity is rounded up to the next power of two.
+    explicit BoundedQueue(size_t capacity) : enqueuePos(0), dequeuePos(0) {
+        size_t size = roundUpToPowerOfTwo(capacity);
+        buffer.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    //Adds an item if there is room. The item is left untouched when the queue is full.
+    bool tryPush(T&& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Full
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Removes the oldest item if there is one.
+    bool tryPop(T& item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Empty
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Backpressure: waits for the consumer to make room before adding the item.
+    void push(T&& item) {
+        while (!tryPush(std::move(item))) {
+            std::this_thread::yield();
+        }
+    }
+
+    //Adds an item, evicting the oldest queued items while the queue is full and handing each one to onEvicted.
+    //Returns how many were evicted. A consumer that has claimed a cell but not yet released it keeps the queue full,
+    //so one push can evict more than one item even with a single producer.
+    template <typename OnEvicted>
+    size_t pushDropOldest(T&& item, OnEvicted&& onEvicted) {
+        size_t evicted = 0;
+        T dropped;
+        while (!tryPush(std::move(item))) {
+            if (tryPop(dropped)) {
+                evicted++;
+                onEvicted(std::move(dropped));
+            }
+        }
+        return evicted;
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef CAPTURESCHEDULER_H
+#define CAPTURESCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+// Seconds between frames for what BattleLogic is waiting for. A line of battle text holds for about a second, and
+// the line stabilizer reads it on its second unchanged frame, so no interval in a battle is over half that. State 3
+// fills most of a set, so over a Battle Tower session these capture fewer frames than the old 0.333 s fixed interval.
+struct CaptureRates {
+    double idleInterval = 2.0;    // State 0, waiting for a streak to be entered
+    double burstInterval = 0.25;  // States 1 and 2, a trainer or "SENT OUT" line is expected
+    double activeInterval = 0.4;  // State 3, moves, abilities and items come a line every second or so
+
+    //The same interval in every state, the way the reader used to capture.
+    static CaptureRates fixed(double interval);
+};
+
+// Paces live capture by deadlines. Each frame is due one interval, for the current state, after the previous one
+// was due, so the time spent reading a frame comes out of the wait instead of being added to it and the rate does not
+// drift. A frame that is already late when asked for is taken at once and counted as a missed deadline, and the
+// next ones are timed from it, so a slow frame never leaves a backlog of frames to catch up on.
+class CaptureScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    CaptureRates rates;
+    bool started;
+    Clock::time_point firstDeadline;
+    Clock::time_point lastDeadline;
+    uint64_t framesScheduled;
+    uint64_t deadlinesMissed;
+
+public:
+    explicit CaptureScheduler(const CaptureRates& rates = CaptureRates());
+
+    //Interval for a BattleLogic state.
+    double intervalFor(int state) const;
+
+    //When the next frame is due, given the state and the time now. Does not wait, so a simulated clock can drive it.
+    Clock::time_point nextDeadline(int state, Clock::time_point now);
+
+    //Sleeps until the next frame is due.
+    void waitForNextFrame(int state);
+
+    //Frames per second over the deadlines so far.
+    double getEffectiveRate() const;
+    uint64_t getFramesScheduled() const;
+    uint64_t getDeadlinesMissed() const;
+};
+
+#endif
@@ -4,17 +4,72 @@
 
 #include "pokemon.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sqlite3.h>
 #include <iostream>
 
+// One battle's worth of what persistTrainerData writes, copied out of the Trainer so it can be written later. The
+// trainer is found, or added, by name when the snapshot is written, so the reading threads never query for its ID.
+struct TrainerSnapshot {
+	std::string_view trainerName; // GameData's copy of the name
+	Team activeTeam;
+};
+
+// What an archived sighting tells about the Pokemon: only that it was used, or a move, ability or item it showed.
+enum class SightingKind { Pokemon, Move, Ability, Item };
+
+// One line of an archived session.
+struct SightingRecord {
+	std::string trainer;
+	std::string pokemon;
+	SightingKind kind = SightingKind::Pokemon;
+	std::string detail; // Move, ability or item name, empty for SightingKind::Pokemon
+};
+
+// Rows added to the database by bulk ingest.
+struct IngestCounts {
+	size_t trainers = 0;
+	size_t pokemon = 0;
+	size_t sightings = 0;
+};
+
+// A read-only connection borrowed from DatabaseInterface's pool, for queries that should not wait on writes. It goes
+// back to the pool when it goes out of scope, so statements prepared on it must be finalized before then.
+class ReadConnection {
+private:
+	sqlite3* db;
+	unsigned generation;
+
+public:
+	ReadConnection(sqlite3* db, unsigned generation);
+	ReadConnection(ReadConnection&& other) noexcept;
+	~ReadConnection();
+
+	ReadConnection(const ReadConnection&) = delete;
+	ReadConnection& operator=(const ReadConnection&) = delete;
+	ReadConnection& operator=(ReadConnection&&) = delete;
+
+	sqlite3* get() const { return db; }
+	explicit operator bool() const { return db != nullptr; }
+};
+
 class DatabaseInterface {
+private:
+	static void writeTrainerData(int trainerID, const Team& activeTeam);
+
 public:
-	// Singleton pattern
+	// Singleton pattern. The writer connection, in WAL mode and migrated to the latest schema when opened
 	static sqlite3* getDB();
 
+	// Opens the database at path in place of pokemon_db.sqlite, for benchmarks that work on a scratch copy
+	static bool openDB(const std::string& path);
+
+	// Borrows a read-only connection to the same database, which reads while the writer writes
+	static ReadConnection openReader();
+
 	// Trainer method
-	static int getOrCreateTrainer(const std::string& trainerName);
+	static int getOrCreateTrainer(std::string_view trainerName);
 
 	// Pokemon methods
 	static int getPokemonID(int trainerID, const std::string& pokeName);
@@ -25,9 +80,26 @@ public:
 	static void addSeenAbility(int pokemonID, const std::string& abilityName);
 	static void addSeenItem(int pokemonID, const std::string& itemName);
 	static std::vector<std::string> getSeenMoves(int pokemonID);
-	static void persistTrainerData(int trainerID, const std::vector<Pokemon>& activeTeam);
+	static void persistTrainerData(int trainerID, const Team& activeTeam);
+	static void persistTrainerSnapshots(const std::vector<TrainerSnapshot>& snapshots);
+
+	// Bulk ingest of archived sessions, a whole batch in one transaction. Adds the rows written to added
+	static bool ingestSightings(const std::vector<SightingRecord>& records, IngestCounts& added);
+
+	// Loads TrainerKnowledge::shared(), which the write methods keep current from then on. Given a snapshot path, it
+	// loads from the snapshot there when that is current and otherwise writes a new one after loading, warning when
+	// the old one can't be replaced
+	static bool preloadKnowledge(const std::string& snapshotPath = "");
 
+	// Rewrites the knowledge snapshot at snapshotPath if the database has changed since it was made
+	static bool refreshSnapshot(const std::string& snapshotPath, bool* exported = nullptr);
+
+	// Finalizes the cached statements and closes the writer and idle readers, the next call reopens it. Also done at exit
 	static void closeDB();
 };
 
+// Appends the sightings of an archive file to records. Lines are trainer|pokemon or trainer|pokemon|kind|name, where
+// kind is move, ability or item
+bool readSightingArchive(const std::string& archivePath, std::vector<SightingRecord>& records);
+
 #endif
\ No newline at end of file
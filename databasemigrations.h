@@ -0,0 +1,28 @@
+#pragma once
+#ifndef DATABASEMIGRATIONS_H
+#define DATABASEMIGRATIONS_H
+
+#include <vector>
+#include <sqlite3.h>
+
+// One step of the schema. A database at version - 1 is brought to version by running sql, and PRAGMA user_version
+// records the version it is at.
+struct Migration {
+    int version;
+    const char* description;
+    const char* sql;
+};
+
+//Every migration, in version order. New ones are only ever appended.
+const std::vector<Migration>& databaseMigrations();
+
+int latestSchemaVersion();
+
+//The database's PRAGMA user_version, or -1 if it could not be read.
+int getSchemaVersion(sqlite3* db);
+
+//Runs the migrations above the database's version up to targetVersion, each in its own transaction, so a failure
+//leaves the database at the last version that completed. Returns false on a failure.
+bool migrateDatabase(sqlite3* db, int targetVersion = latestSchemaVersion());
+
+#endif
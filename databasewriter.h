@@ -0,0 +1,77 @@
+#pragma once
+#ifndef DATABASEWRITER_H
+#define DATABASEWRITER_H
+
+#include "boundedqueue.h"
+#include "databaseinterface.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes battle snapshots to SQLite on its own thread, so the capture and OCR threads never wait on a commit.
+// Snapshots are gathered into batches and each batch is written in one transaction, once MAX_BATCH are waiting or
+// the oldest has waited FLUSH_INTERVAL. The thread sleeps on a condition variable until one of those, a flush or a stop
+// is due. Whatever is still queued is written when the writer is stopped.
+class DatabaseWriter {
+public:
+    static const size_t MAX_BATCH = 16;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 500 };
+
+private:
+    BoundedQueue<TrainerSnapshot> pending;
+    std::mutex stopLock;               // Held by enqueue while it queues and by stop throughout, so nothing is queued after the last drain
+    bool stopped;                      // Under stopLock
+    std::atomic<bool> stopRequested;   // Tells the writer thread to drain the queue and exit
+    std::atomic<bool> writerRunning;   // Until stop has joined the thread, read by flush instead of asking the thread
+    std::atomic<int> flushWaiters;
+    std::atomic<uint64_t> snapshotsQueued;
+    std::atomic<uint64_t> snapshotsTaken; // Popped by the writer thread, written or in the batch being gathered
+    std::atomic<uint64_t> snapshotsWritten;
+    std::atomic<uint64_t> batchesWritten;
+    std::mutex snapshotLock;
+    std::string snapshotPath;
+    std::thread writerThread;
+    std::mutex wakeLock;                  // Held while the writer checks whether to sleep, so no wake up is missed
+    std::condition_variable wakeWriter;   // A snapshot was queued, or a flush or stop asked for
+    std::condition_variable batchWritten; // For flush
+
+    void writerLoop();
+    void notify(std::condition_variable& condition);
+
+public:
+    //Capacity is the number of snapshots that can wait, enqueue only blocks once that many are unwritten.
+    explicit DatabaseWriter(size_t capacity = 64);
+
+    //Stops the writer if it is still running.
+    ~DatabaseWriter();
+
+    DatabaseWriter(const DatabaseWriter&) = delete;
+    DatabaseWriter& operator=(const DatabaseWriter&) = delete;
+
+    //Hands a snapshot to the writer thread and returns without touching the database.
+    void enqueue(TrainerSnapshot&& snapshot);
+
+    //Waits until every snapshot enqueued so far has been committed.
+    void flush();
+
+    //Writes everything still queued, then stops the thread. Call before the program returns from main, rather than
+    //leave it to the shared writer's static destructor, which may run after the database's. Snapshots enqueued
+    //afterwards are written straight away on the calling thread.
+    void stop();
+
+    //Keeps the knowledge snapshot at path current by refreshing it after every batch written, empty stops.
+    void setSnapshotPath(const std::string& path);
+
+    uint64_t getSnapshotsWritten() const;
+    uint64_t getBatchesWritten() const;
+
+    //Writer used by Trainer, started on first use and flushed at program exit.
+    static DatabaseWriter& shared();
+};
+
+#endif
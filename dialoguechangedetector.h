@@ -0,0 +1,38 @@
+#pragma once
+#ifndef DIALOGUECHANGEDETECTOR_H
+#define DIALOGUECHANGEDETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+
+// Cheap check for whether the dialogue box changed since the last frame, so an unchanged box can reuse the
+// previous OCR text. The crop is reduced to a grid of cell averages and compared cell by cell against the last
+// fingerprint. A single new glyph moves at least one cell well past the tolerance, while capture noise averages out.
+class DialogueChangeDetector {
+private:
+    int cellSize;      // Side length in pixels of each fingerprint cell
+    int cellTolerance; // Largest per-cell gray level difference still counted as unchanged
+    cv::Mat previousFingerprint;
+
+    std::atomic<uint64_t> framesSkipped;
+    std::atomic<uint64_t> framesProcessed;
+
+public:
+    explicit DialogueChangeDetector(int cellSize = 8, int cellTolerance = 12);
+
+    //Compares the dialogue crop against the previous frame and remembers it for the next call.
+    //Returns false when the box is unchanged within tolerance and OCR can be skipped.
+    bool hasChanged(const cv::Mat& dialogueCrop);
+
+    //Forgets the previous frame so the next one is always treated as changed.
+    void reset();
+
+    uint64_t getFramesSkipped() const;
+    uint64_t getFramesProcessed() const;
+
+    //Fraction of frames that skipped OCR so far.
+    double getSkipRate() const;
+};
+
+#endif
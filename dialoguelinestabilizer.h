@@ -0,0 +1,49 @@
+#pragma once
+#ifndef DIALOGUELINESTABILIZER_H
+#define DIALOGUELINESTABILIZER_H
+
+#include <atomic>
+#include <cstdint>
+
+// What DialogueLineStabilizer makes of a frame's dialogue box.
+enum class LineStatus {
+    Blank,    // No text in the box
+    Printing, // Text still appearing, or not unchanged for long enough yet
+    Ready,    // Text has stopped changing and has not been read, OCR this frame
+    Read      // The text on screen has been read already
+};
+
+// Waits for dialogue to finish printing before it is read. Emerald prints a line a character at a time, so the number
+// of glyph columns in the box grows from frame to frame. Once the count and the box have held for stableFrames frames
+// the line is read, once, and nothing more is read until the box changes again.
+class DialogueLineStabilizer {
+private:
+    int stableFrames;
+    int glyphColumns;    // Of the last frame with text
+    int unchangedFrames; // Frames in a row the text has looked the same, counting the first
+    bool read;
+
+    std::atomic<uint64_t> linesReady;
+    std::atomic<uint64_t> framesPrinting;
+    std::atomic<uint64_t> framesRead;
+
+public:
+    explicit DialogueLineStabilizer(int stableFrames = 2);
+
+    //Takes whether the box changed since the last frame, from DialogueChangeDetector, and the glyph columns in it,
+    //from BlankDialogueDetector with 0 for a box without text. Call once per frame, in capture order.
+    LineStatus observe(bool boxChanged, int glyphColumns);
+
+    //Lets the text on screen be read again, for when the frame it was to be read from never reached OCR.
+    void rearm();
+
+    //Forgets the box, the next frame with text starts a new line.
+    void reset();
+
+    //Lines handed to OCR, and frames with text that were not.
+    uint64_t getLinesReady() const;
+    uint64_t getFramesPrinting() const;
+    uint64_t getFramesRead() const;
+};
+
+#endif
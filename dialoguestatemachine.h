@@ -0,0 +1,77 @@
+#pragma once
+#ifndef DIALOGUESTATEMACHINE_H
+#define DIALOGUESTATEMACHINE_H
+
+#include "dialoguetokenizer.h"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// What BattleLogic does when a trigger matches.
+enum class DialogueAction {
+    AnnounceStreak, // Streak entry dialogue
+    StartBattle,    // Trainer name anywhere in the line
+    SendOutPokemon, // Pokemon name at the last token of the match
+    RevealDetail,   // Move, ability or item after the first token
+    FoeFainted,
+    WinStreak,
+    LoseStreak,
+    DefeatTrainer
+};
+
+// One transition: in state, a line matching pattern runs action and, if the action succeeds, moves to nextState
+// (-1 stays). Patterns are space separated tokens as DialogueTokenizer makes them, matched from the first token of the
+// line. "*" matches any one token and a leading "..." lets the pattern start at any token. An empty pattern matches
+// every line. When several triggers match, the one listed first wins.
+struct DialogueTrigger {
+    int state;
+    const char* pattern; // Must outlive the machine
+    DialogueAction action;
+    int nextState;
+};
+
+// Where a trigger matched: tokens [firstToken, endToken).
+struct TriggerMatch {
+    const DialogueTrigger* trigger;
+    size_t firstToken;
+    size_t endToken;
+};
+
+// The triggers of a battle facility compiled into one token trie, rooted per state. Finding the trigger for a line is
+// a single walk over its tokens that follows every partial match at once, so adding triggers does not add passes.
+class DialogueStateMachine {
+private:
+    static const size_t MAX_ACTIVE = 16; // Partial matches followed at once, more are dropped
+
+    struct Node {
+        int wildcard = -1; // Child for "*"
+        int trigger = -1;  // First trigger whose pattern ends here
+    };
+
+    struct Roots {
+        int anchored = -1; // Patterns matched from the first token
+        int floating = -1; // Patterns that start with "..."
+    };
+
+    std::vector<DialogueTrigger> triggers;
+    std::unordered_map<std::string_view, int> wordIds;
+    std::unordered_map<uint64_t, int> transitions; // (node << 32 | word) to child
+    std::vector<Node> nodes;
+    std::vector<Roots> roots; // By state
+
+    int addNode();
+    int child(int node, int word) const;
+
+public:
+    explicit DialogueStateMachine(const std::vector<DialogueTrigger>& facilityTriggers);
+
+    //Finds the first listed trigger of state that matches the line. Does not allocate.
+    bool match(int state, const DialogueTokenizer& tokens, TriggerMatch& found) const;
+};
+
+//Battle Tower single battles, the facility the reader was written for. States: 0 waiting for a streak to be entered,
+//1 waiting for the trainer, 2 waiting for a Pokemon to be sent out or the battle to end, 3 watching the Pokemon out.
+const std::vector<DialogueTrigger>& battleTowerSingles();
+
+#endif
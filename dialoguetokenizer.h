@@ -0,0 +1,42 @@
+#pragma once
+#ifndef DIALOGUETOKENIZER_H
+#define DIALOGUETOKENIZER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Splits an OCR line into uppercase words. The words are copied once into a buffer reserved up front, joined by single
+// spaces with trailing '!' and ',' dropped, and handed out as views into it. Tokenizing allocates nothing.
+class DialogueTokenizer {
+public:
+    static const size_t MAX_TOKENS = 32;       // The dialogue box holds two short lines, words past this are dropped
+    static const size_t MAX_LINE_LENGTH = 256; // Characters past this are dropped, so the buffer never grows
+
+private:
+    std::string buffer;
+    std::array<std::string_view, MAX_TOKENS> tokens;
+    size_t count;
+
+public:
+    DialogueTokenizer();
+
+    //Replaces the tokens with the words of dialogue. Views from an earlier call are invalidated.
+    void tokenize(std::string_view dialogue);
+
+    size_t size() const;
+    bool empty() const;
+    std::string_view operator[](size_t index) const;
+
+    //Words [first, first + length) as one view, separated by single spaces like the names in GameData.
+    std::string_view span(size_t first, size_t length) const;
+
+    //The whole line as tokenized.
+    std::string_view text() const;
+
+    const std::string_view* begin() const;
+    const std::string_view* end() const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef ENTITYMATCHER_H
+#define ENTITYMATCHER_H
+
+#include "dialoguetokenizer.h"
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Kinds of names the matcher knows, one per GameData list.
+enum class EntityType {
+    Trainer,
+    Pokemon,
+    Move,
+    Ability,
+    Item
+};
+
+const char* getEntityTypeName(EntityType type);
+
+//Calls add with the type, GameData ID and name of every entry of every GameData list.
+void forEachGameDataName(const std::function<void(EntityType, int, std::string_view)>& add);
+
+//GameData name of an ID, empty if out of range.
+std::string_view getGameDataName(EntityType type, int id);
+
+// A name found in a line: tokens [firstToken, firstToken + tokenCount) spell the name with this GameData ID.
+struct EntitySpan {
+    EntityType type;
+    int id;
+    size_t firstToken;
+    size_t tokenCount;
+};
+
+// Aho-Corasick automaton over words rather than characters. Every name is a path of word IDs through a trie, and the
+// failure links let one left to right pass over a line find every name in it, whatever its length, with one hash
+// lookup and usually one transition per token.
+class EntityMatcher {
+private:
+    struct Node {
+        int fail = 0;        // Longest proper suffix of this path that is also a path
+        int match = -1;      // Nearest node on the fail chain, this one included, that ends a name
+        int depth = 0;       // Words on the path
+        int entityBegin = 0; // Names ending here, in entities
+        int entityCount = 0;
+    };
+
+    struct Entity {
+        EntityType type;
+        int id;
+    };
+
+    std::unordered_map<std::string_view, int> wordIds; // Views into the names, which must outlive the matcher
+    std::unordered_map<uint64_t, int> transitions;     // (node << 32 | word) to child
+    std::vector<Node> nodes;
+    std::vector<Entity> entities;
+    std::vector<std::vector<Entity>> pendingEntities;  // Per node until build()
+    bool built;
+
+    int child(int node, int word) const;
+    int step(int node, int word) const;
+
+public:
+    EntityMatcher();
+
+    //Adds a name of space separated words. Call build() once all names are added.
+    void add(EntityType type, int id, std::string_view name);
+
+    //Links the automaton, after which find() can be used.
+    void build();
+
+    //Replaces matches with the names in tokens from firstToken on. Overlapping names resolve leftmost first, then
+    //longest, so "SLUDGE BOMB" wins over "SLUDGE". A name in more than one list gives one span per list. matches is
+    //cleared, not shrunk, so a reused vector stops allocating.
+    void find(const DialogueTokenizer& tokens, std::vector<EntitySpan>& matches, size_t firstToken = 0) const;
+
+    //Matcher over every GameData list, built on first use.
+    static const EntityMatcher& gameData();
+};
+
+#endif
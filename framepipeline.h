@@ -0,0 +1,146 @@
+#pragma once
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "battlelogic.h"
+#include "boundedqueue.h"
+#include "blankdialoguedetector.h"
+#include "dialoguechangedetector.h"
+#include "dialoguelinestabilizer.h"
+#include "layoutprofile.h"
+#include "ocrbackend.h"
+#include "streakreader.h"
+
+// A dialogue line that has finished printing, handed to BattleLogic once.
+struct DialogueLine {
+    std::string_view text; // Valid for the duration of the observer call
+    uint64_t frame;        // Sequence number of the frame it was read from
+    double timestamp;      // Seconds from the start of the run to the capture of that frame
+};
+
+// Runs capture, crop + preprocess, OCR and the battle state machine as separate stages on their own threads,
+// joined by bounded lock-free queues. When OCR falls behind, the oldest preprocessed frame is dropped so the
+// reader stays close to real time. Every frame keeps its capture sequence number and the state machine stage
+// reorders on it, so BattleLogic always sees lines in capture order. Dialogue is only read once a line has finished
+// printing, and each line reaches BattleLogic once however many frames it stays on screen.
+class FramePipeline {
+public:
+    //Fills the frame and returns true, or returns false once there are no more frames to read. The frame passed in
+    //is a recycled buffer when one is free, so providers that write into it avoid a new allocation per frame.
+    using FrameProvider = std::function<bool(cv::Mat& frame)>;
+
+    //Called from the state machine stage with every line, just before BattleLogic handles it.
+    using LineObserver = std::function<void(const DialogueLine& line)>;
+
+private:
+    struct CapturedFrame {
+        uint64_t sequence = 0;
+        double timestamp = 0.0;
+        cv::Mat image;
+    };
+
+    struct PreparedFrame {
+        uint64_t sequence = 0;
+        double timestamp = 0.0;
+        LineStatus line = LineStatus::Blank; // Only a Ready line is preprocessed and read
+        bool hasStreak = false; // The streak counters were looked for on this frame
+        StreakReading streak;     // Level 50 counter, not read once the open level is known to be the one challenged
+        StreakReading openStreak; // Open level counter, not read once level 50 is known to be the one challenged
+        cv::Mat dialogue; // Preprocessed dialogue box
+    };
+
+    struct OcrResult {
+        uint64_t sequence = 0;
+        double timestamp = 0.0;
+        bool dropped = false; // Frame was dropped before OCR, only advances the reorder position
+        LineStatus line = LineStatus::Blank;
+        bool hasStreak = false;
+        StreakReading streak;
+        StreakReading openStreak;
+        std::string dialogueText; // Read for a Ready line only
+    };
+
+    BattleLogic& battleLogic;
+    OcrBackend& dialogueOcr;
+    size_t ocrWorkers;
+    bool dropWhenBehind;
+
+    BoundedQueue<CapturedFrame> capturedFrames;
+    BoundedQueue<PreparedFrame> preparedFrames;
+    BoundedQueue<OcrResult> ocrResults;
+    BoundedQueue<cv::Mat> freeFrames; // Frame buffers the preprocess stage is done with, refilled by the provider
+
+    std::atomic<bool> captureDone;
+    std::atomic<bool> preprocessDone;
+    std::atomic<size_t> ocrWorkersRunning;
+    std::atomic<bool> streakWanted; // Published by the state machine stage, read by the preprocess stage
+    std::atomic<int> battleState;   // Published by the state machine stage, read by the frame provider
+    std::atomic<int> facilityLevel; // Published by the state machine stage, read by the preprocess stage
+
+    DialogueChangeDetector changeDetector; // Only used from the preprocess stage
+    BlankDialogueDetector blankDetector;   // Only used from the preprocess stage
+    DialogueLineStabilizer lineStabilizer; // Only used from the preprocess stage
+    StreakReader streakReader;             // Only used from the preprocess stage
+    int dialogueGlyphColumns;              // Of the last changed box, only used from the preprocess stage
+    std::string lastLineText;              // Last line handed on, until the box empties. Only used from the state machine stage
+    LineObserver lineObserver;
+    LayoutProfile captureLayout;           // Layout of the frames the provider returns
+    LayoutProfile frameLayout;             // Layout of the frames the preprocess stage crops, after any downscale
+    int nativeMultiple;                    // 0 keeps frames at capture resolution
+    cv::Mat nativeFrame;                   // Downscaled frame, reused by the preprocess stage
+
+    std::atomic<uint64_t> framesCaptured;
+    std::atomic<uint64_t> framesDropped;
+    std::atomic<uint64_t> framesProcessed;
+    std::atomic<uint64_t> linesEmitted;
+
+    void captureStage(const FrameProvider& nextFrame);
+    void preprocessStage();
+    void ocrStage();
+    void stateMachineStage();
+    void applyResult(const OcrResult& result);
+
+public:
+    //ocrWorkers should not exceed the number of workers the dialogue backend can serve at once. Replays that must
+    //see every frame pass dropWhenBehind = false, which applies backpressure in front of OCR instead of dropping.
+    FramePipeline(BattleLogic& battleLogic, OcrBackend& dialogueOcr, size_t ocrWorkers = 1, size_t queueCapacity = 8,
+        bool dropWhenBehind = true);
+
+    //Sets where the regions are in the captured frames. With a nativeMultiple above 0 every frame is first shrunk to
+    //that multiple of the GBA resolution. Call before run.
+    void setLayout(const LayoutProfile& layout, int nativeMultiple = 0);
+
+    //Replaces the streak reader, e.g. with one that has learned its digits from labeled captures. Call before run.
+    void setStreakReader(const StreakReader& reader);
+
+    //Sets a function to see each dialogue line with its frame and timestamp. Call before run.
+    void setLineObserver(const LineObserver& observer);
+
+    //Runs every stage until the provider runs out of frames and all queued frames have been handled.
+    void run(const FrameProvider& nextFrame);
+
+    //BattleLogic's state as of the last frame handled, safe to call from the frame provider.
+    int getBattleState() const;
+
+    uint64_t getFramesCaptured() const;
+    uint64_t getFramesDropped() const;
+    uint64_t getFramesProcessed() const;
+
+    //Frames with text whose OCR was skipped, as the line was still printing or already read, and OCR calls made.
+    uint64_t getDialogueOcrSkipped() const;
+    uint64_t getDialogueOcrPerformed() const;
+
+    //Changed frames the blank detector kept away from OCR.
+    uint64_t getDialogueBlankSkipped() const;
+
+    //Distinct lines handed to BattleLogic.
+    uint64_t getLinesEmitted() const;
+};
+
+#endif
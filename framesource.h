@@ -0,0 +1,105 @@
+#pragma once
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where captured frames come from. Every backend writes into the Mat it is given, so a caller that hands back the
+// same buffer each time gets frames without a new allocation once the size has settled.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    //Fills frame with the next BGR frame, reusing its buffer when the size matches. Returns false when there are no
+    //more frames or capture failed.
+    virtual bool next(cv::Mat& frame) = 0;
+
+    //Live sources capture the screen as it is now and should be paced by the caller, replays run as fast as read.
+    virtual bool isLive() const = 0;
+
+    virtual const char* getName() const = 0;
+};
+
+// Replays the images of a directory in natural order (screenshot_2 before screenshot_10). Files are read into one
+// reused byte buffer and decoded into the caller's frame.
+class DirectoryFrameSource : public FrameSource {
+private:
+    std::vector<std::string> paths;
+    size_t nextIndex;
+    std::vector<uchar> fileBytes;
+
+public:
+    explicit DirectoryFrameSource(const std::string& directory, const std::string& pattern = "*.png");
+
+    bool next(cv::Mat& frame) override;
+    bool isLive() const override;
+    const char* getName() const override;
+
+    size_t getFrameCount() const;
+};
+
+// Replays a recorded video file, or reads a capture device by index.
+class VideoFrameSource : public FrameSource {
+private:
+    cv::VideoCapture capture;
+    bool live;
+
+public:
+    explicit VideoFrameSource(const std::string& path);
+    explicit VideoFrameSource(int deviceIndex);
+
+    bool isOpened() const;
+    bool next(cv::Mat& frame) override;
+    bool isLive() const override;
+    const char* getName() const override;
+};
+
+#ifdef _WIN32
+// Captures the client area of a window through GDI. The device contexts and bitmap are kept between frames and only
+// recreated when the window changes size.
+class WindowFrameSource : public FrameSource {
+private:
+    struct GdiState;
+    std::unique_ptr<GdiState> gdi;
+    cv::Mat bgra; // GetDIBits target, 32 bit rows need no padding
+
+public:
+    explicit WindowFrameSource(const std::wstring& windowTitle);
+    ~WindowFrameSource() override;
+
+    bool isOpened() const;
+    bool next(cv::Mat& frame) override;
+    bool isLive() const override;
+    const char* getName() const override;
+};
+#endif
+
+#ifdef __linux__
+// Captures a region of an X11 screen with MIT-SHM. One shared memory image is attached when the source opens and
+// every frame is read into it by the X server, so nothing is allocated per frame. Works under Xvfb for testing. Where
+// shared memory is not available, as on a remote display, every frame is copied out with XGetImage instead.
+class X11ShmFrameSource : public FrameSource {
+private:
+    struct ShmState;
+    std::unique_ptr<ShmState> shm;
+
+public:
+    //An empty display name uses $DISPLAY, an empty region captures the whole root window.
+    X11ShmFrameSource(const std::string& displayName = "", const cv::Rect& region = cv::Rect());
+    ~X11ShmFrameSource() override;
+
+    bool isOpened() const;
+    bool next(cv::Mat& frame) override;
+    bool isLive() const override;
+    const char* getName() const override;
+};
+#endif
+
+//Creates a source from a command line spec: "dir:<directory>", "video:<file>", "device:<index>", "window:<title>"
+//(Windows) or "x11[:<display>]" (Linux). A bare path is treated as a directory. Returns nullptr if it cannot open.
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec);
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef FUZZYENTITYINDEX_H
+#define FUZZYENTITYINDEX_H
+
+#include "entitymatcher.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Bit of a type in the type masks taken by FuzzyEntityIndex::lookup.
+inline unsigned entityTypeMask(EntityType type) {
+    return 1u << static_cast<unsigned>(type);
+}
+
+const unsigned ALL_ENTITY_TYPES = 0x1F;
+
+// Nearest name to a misread piece of text.
+struct FuzzyMatch {
+    EntityType type;
+    int id;          // GameData ID
+    int distance;    // Edit distance between the text and the name
+    float confidence; // 1 - distance / name length, halved when another name is just as close
+};
+
+// Finds names within a few edits of OCR text ("GEODUDF" for GEODUDE), by symmetric delete: every string reachable
+// from a name by deleting up to its allowed distance in characters is indexed by hash, the text's own deletions are
+// looked up, and the candidates found are checked with a real edit distance. Short names allow fewer edits, so
+// common dialogue words do not turn into three letter moves.
+class FuzzyEntityIndex {
+public:
+    static const int MAX_DISTANCE = 2;
+    static const size_t MAX_NAME_LENGTH = 32;
+
+private:
+    struct Entry {
+        EntityType type;
+        int id;
+        std::string_view name; // Must outlive the index
+    };
+
+    struct Posting {
+        uint64_t hash; // Of a deletion variant of the entry's name
+        int entry;
+    };
+
+    static const int DIRECTORY_BITS = 16;
+
+    std::vector<Entry> entries;
+    std::vector<Posting> postings; // Sorted by hash after build()
+    // Index of the first posting for each value of the top DIRECTORY_BITS of the hash, so a lookup goes straight to
+    // a run of about one posting instead of searching.
+    std::vector<uint32_t> directory;
+
+public:
+    //Edits allowed for a name of this length: none up to 3 characters, 1 up to 7 and MAX_DISTANCE beyond.
+    static int maxDistanceFor(size_t length);
+
+    //Adds a name. Call build() once all names are added.
+    void add(EntityType type, int id, std::string_view name);
+    void build();
+
+    //Finds the name of one of the types in typeMask closest to text, within the distance its length allows. Ties
+    //go to the name added first. Returns false when no name is close enough. Does not allocate.
+    bool lookup(std::string_view text, FuzzyMatch& match, unsigned typeMask = ALL_ENTITY_TYPES) const;
+
+    size_t getPostingCount() const;
+
+    //Index over every GameData list, built on first use.
+    static const FuzzyEntityIndex& gameData();
+};
+
+#endif
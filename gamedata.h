@@ -1,13 +1,164 @@
 #pragma once
 #ifndef GAMEDATA_H
 #define GAMEDATA_H
-#include <string>
-#include <unordered_set>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
 
-//Static game data that is used to properly categorize information parsed from the dialogue box
+//Static game data that is used to properly categorize information parsed from the dialogue box. Every list is turned
+//into a perfect hash table at compile time, so nothing is built at startup and a lookup is one hash, one probe and one
+//compare, without allocating. The ID of a name is its index in its list.
 namespace GameData {
 
-    const std::unordered_set<std::string> setTrainers = { "YOUNGSTER BRADY", "YOUNGSTER CONNER", "YOUNGSTER BRADLEY", "LASS CYBIL",
+    //Returned by the lookups for names that are not in the list.
+    constexpr int NOT_FOUND = -1;
+
+    namespace detail {
+        constexpr uint64_t readByte(const char* text) {
+            return static_cast<unsigned char>(*text);
+        }
+
+        // Little endian words. Spelled out with shifts to stay constexpr, optimizers merge them into a single load.
+        constexpr uint64_t readWord32(const char* text) {
+            return readByte(text) | readByte(text + 1) << 8 | readByte(text + 2) << 16 | readByte(text + 3) << 24;
+        }
+
+        constexpr uint64_t readWord64(const char* text) {
+            return readWord32(text) | readWord32(text + 4) << 32;
+        }
+
+        // Hashes a word at a time, names are short enough that this is a couple of multiplies. The last word overlaps
+        // the ones before it instead of being read a character at a time, which is fine since the length is mixed in.
+        constexpr uint64_t hashName(std::string_view name) {
+            const char* text = name.data();
+            size_t size = name.size();
+            uint64_t hash = 0x9E3779B97F4A7C15ull ^ size;
+            for (size_t offset = 0; offset + 8 <= size; offset += 8) {
+                hash = (hash ^ readWord64(text + offset)) * 0xFF51AFD7ED558CCDull;
+                hash ^= hash >> 32;
+            }
+            uint64_t last = size >= 8 ? readWord64(text + size - 8)
+                : size >= 4 ? readWord32(text) | readWord32(text + size - 4) << 32
+                : size > 0 ? readByte(text) | readByte(text + size / 2) << 8 | readByte(text + size - 1) << 16
+                : 0;
+            hash = (hash ^ last) * 0xC4CEB9FE1A85EC53ull;
+            return hash ^ (hash >> 29);
+        }
+
+        // Slot of a name hash under a bucket displacement (splitmix64 finalizer).
+        constexpr uint64_t mixSlot(uint64_t hash, uint64_t displacement) {
+            uint64_t x = hash + displacement * 0x9E3779B97F4A7C15ull;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        constexpr size_t slotCountFor(size_t names) {
+            size_t slots = 1;
+            while (slots < names * 2) slots <<= 1;
+            return slots;
+        }
+
+        // Hash and displace: names are spread over buckets by the high half of their hash, then each bucket, largest
+        // first, gets the first displacement that moves all of its names into free slots. A duplicate name can never
+        // be placed, which leaves the table unbuilt and trips the static_assert below.
+        template <size_t N>
+        class PerfectHashTable {
+        public:
+            static constexpr size_t BUCKETS = N / 2 + 1;
+            static constexpr size_t SLOTS = slotCountFor(N);
+
+        private:
+            const std::string_view* names;
+            std::array<uint16_t, BUCKETS> displacements{};
+            std::array<int16_t, SLOTS> slots{};
+            bool built = false;
+
+            static constexpr size_t bucketOf(uint64_t hash) {
+                return static_cast<size_t>(hash >> 32) % BUCKETS;
+            }
+
+            static constexpr size_t slotOf(uint64_t hash, uint64_t displacement) {
+                return static_cast<size_t>(mixSlot(hash, displacement) & (SLOTS - 1));
+            }
+
+        public:
+            constexpr explicit PerfectHashTable(const std::string_view (&list)[N]) : names(list) {
+                static_assert(N < 32768, "IDs are stored as int16_t");
+                std::array<uint64_t, N> hashes{};
+                std::array<size_t, BUCKETS + 1> bucketStart{}; // Names of bucket b are byBucket[bucketStart[b], bucketStart[b + 1])
+                std::array<size_t, BUCKETS> bucketFill{};
+                std::array<int16_t, N> byBucket{};
+
+                for (size_t i = 0; i < N; i++) {
+                    hashes[i] = hashName(list[i]);
+                    bucketStart[bucketOf(hashes[i]) + 1]++;
+                }
+                size_t largest = 0;
+                for (size_t b = 0; b < BUCKETS; b++) {
+                    largest = bucketStart[b + 1] > largest ? bucketStart[b + 1] : largest;
+                    bucketStart[b + 1] += bucketStart[b];
+                    bucketFill[b] = bucketStart[b];
+                }
+                for (size_t i = 0; i < N; i++) byBucket[bucketFill[bucketOf(hashes[i])]++] = static_cast<int16_t>(i);
+                for (auto& slot : slots) slot = NOT_FOUND;
+
+                for (size_t size = largest; size > 0; size--) {
+                    for (size_t b = 0; b < BUCKETS; b++) {
+                        if (bucketStart[b + 1] - bucketStart[b] != size) continue;
+
+                        bool placed = false;
+                        for (uint32_t displacement = 0; displacement <= UINT16_MAX && !placed; displacement++) {
+                            placed = true;
+                            for (size_t k = bucketStart[b]; k < bucketStart[b + 1] && placed; k++) {
+                                size_t slot = slotOf(hashes[byBucket[k]], displacement);
+                                placed = slots[slot] == NOT_FOUND;
+                                for (size_t j = bucketStart[b]; j < k && placed; j++) {
+                                    placed = slotOf(hashes[byBucket[j]], displacement) != slot;
+                                }
+                            }
+                            if (placed) {
+                                displacements[b] = static_cast<uint16_t>(displacement);
+                                for (size_t k = bucketStart[b]; k < bucketStart[b + 1]; k++) {
+                                    slots[slotOf(hashes[byBucket[k]], displacement)] = byBucket[k];
+                                }
+                            }
+                        }
+                        if (!placed) return;
+                    }
+                }
+                built = true;
+            }
+
+            constexpr bool isBuilt() const {
+                return built;
+            }
+
+            //ID of name, or NOT_FOUND.
+            constexpr int find(std::string_view name) const {
+                uint64_t hash = hashName(name);
+                int id = slots[slotOf(hash, displacements[bucketOf(hash)])];
+                return id != NOT_FOUND && names[id] == name ? id : NOT_FOUND;
+            }
+
+            constexpr bool contains(std::string_view name) const {
+                return find(name) != NOT_FOUND;
+            }
+
+            //Name of an ID, empty for IDs out of range.
+            constexpr std::string_view nameOf(int id) const {
+                return id >= 0 && static_cast<size_t>(id) < N ? names[id] : std::string_view();
+            }
+
+            constexpr size_t size() const {
+                return N;
+            }
+        };
+    }
+
+    inline constexpr std::string_view trainerNames[] = { "YOUNGSTER BRADY", "YOUNGSTER CONNER", "YOUNGSTER BRADLEY", "LASS CYBIL",
     "LASS RODETTE", "LASS PEGGY", "SCHOOL KID KEITH", "SCHOOL KID GRAYSON", "SCHOOL KID GLENN", "SCHOOL KID LILIANA", 
         "SCHOOL KID ELISE", "SCHOOL KID ZOEY", "RICH BOY MANUEL", "RICH BOY RUSS", "RICH BOY DUSTIN", 
         "LADY TINA", "LADY GILLIAN", "LADY ZOE", "CAMPER CHEN", "CAMPER AL", "CAMPER MITCH", 
@@ -56,7 +207,7 @@ namespace GameData {
         "SAILOR OMAR", "SAILOR PETER", "HIKER DEV", "HIKER COREY", "KINDLER ANDRE", "KINDLER FERRIS", "PARASOL LADY ALIVIA", "PARASOL LADY PAIGE", "BEAUTY ANYA", 
         "BEAUTY DAWN", "AROMA LADY ABBY", "AROMA LADY GRETEL"};
 
-    const std::unordered_set<std::string> setItems = { "BLUE SCARF", "RED SCARF", "GREEN SCARF", "PINK SCARF", "YELLOW SCARF",
+    inline constexpr std::string_view itemNames[] = { "BLUE SCARF", "RED SCARF", "GREEN SCARF", "PINK SCARF", "YELLOW SCARF",
         "BLUE FLUTE", "YELLOW FLUTE", "RED FLUTE", "BLACK FLUTE", "WHITE FLUTE",
         "RARE CANDY", "BEAD MAIL", "DREAM MAIL", "FAB MAIL", "GLITTER MAIL",
         "HARBOR MAIL", "MECH MAIL", "RETRO MAIL", "TROPIC MAIL", "WAVE MAIL",
@@ -72,9 +223,8 @@ namespace GameData {
         "X ATTACK","X DEFEND","X SPEED","X ACCURACY","X SPECIAL","POKE DOLL","FLUFFY TAIL","SUPER REPEL",
         "MAX REPEL","ESCAPE ROPE","REPEL","SUN STONE","MOON STONE","FIRE STONE","THUNDERSTONE",
         "WATER STONE","LEAF STONE","TINY MUSHROOM","BIG MUSHROOM","PEARL","BIG PEARL","STARDUST",
-        "STAR PIECE","NUGGET","HEART SCALE","ORANGE MAIL","HARBOR MAIL","GLITTER MAIL","MECH MAIL",
-        "WOOD MAIL","WAVE MAIL","BEAD MAIL","SHADOW MAIL","TROPIC MAIL","DREAM MAIL","FAB MAIL",
-        "RETRO MAIL","CHERI BERRY","CHESTO BERRY","PECHA BERRY","RAWST BERRY","ASPEAR BERRY",
+        "STAR PIECE","NUGGET","HEART SCALE",
+        "CHERI BERRY","CHESTO BERRY","PECHA BERRY","RAWST BERRY","ASPEAR BERRY",
         "LEPPA BERRY","ORAN BERRY","PERSIM BERRY","LUM BERRY","SITRUS BERRY","FIGY BERRY",
         "WIKI BERRY","MAGO BERRY","AGUAV BERRY","IAPAPA BERRY","RAZZ BERRY","BLUK BERRY",
         "NANAB BERRY","WEPEAR BERRY","PINAP BERRY","POMEG BERRY","KELPSY BERRY","QUALOT BERRY",
@@ -95,7 +245,7 @@ namespace GameData {
         "TM31","TM32","TM33","TM34","TM35","TM36","TM37","TM38","TM39","TM40",
         "TM41","TM42","TM43","TM44","TM45","TM46","TM47","TM48","TM49","TM50" };
 
-    const std::unordered_set<std::string> setMoves = { "POUND","KARATE CHOP","DOUBLE SLAP","COMET PUNCH","MEGA PUNCH","PAY DAY",
+    inline constexpr std::string_view moveNames[] = { "POUND","KARATE CHOP","DOUBLE SLAP","COMET PUNCH","MEGA PUNCH","PAY DAY",
         "FIRE PUNCH","ICE PUNCH","THUNDER PUNCH","SCRATCH","VICEGRIP","GUILLOTINE",
         "RAZOR WIND","SWORDS DANCE","CUT","GUST","WING ATTACK","WHIRLWIND","FLY","BIND",
         "SLAM","VINE WHIP","STOMP","DOUBLE KICK","MEGA KICK","JUMP KICK","ROLLING KICK",
@@ -146,7 +296,7 @@ namespace GameData {
         "VOLT TACKLE","MAGICAL LEAF","WATER SPORT","CALM MIND","LEAF BLADE","DRAGON DANCE",
         "ROCK BLAST","SHOCK WAVE","WATER PULSE","DOOM DESIRE","PSYCHO BOOST" };
 
-    const std::unordered_set<std::string> setAbilities = { "STENCH", "DRIZZLE", "SPEED BOOST", "BATTLE ARMOR", "STURDY", "DAMP",
+    inline constexpr std::string_view abilityNames[] = { "STENCH", "DRIZZLE", "SPEED BOOST", "BATTLE ARMOR", "STURDY", "DAMP",
     "LIMBER", "SAND VEIL", "STATIC", "VOLT ABSORB", "WATER ABSORB", "OBLIVIOUS",
     "CLOUD NINE", "COMPOUND EYES", "INSOMNIA", "COLOR CHANGE", "IMMUNITY", "FLASH FIRE",
     "SHIELD DUST", "OWN TEMPO", "SUCTION CUPS", "INTIMIDATE", "SHADOW TAG", "ROUGH SKIN",
@@ -160,12 +310,12 @@ namespace GameData {
     "TORRENT", "SWARM", "ROCK HEAD", "DROUGHT", "ARENA TRAP", "VITAL SPIRIT",
     "WHITE SMOKE", "PURE POWER", "SHELL ARMOR", "AIR LOCK"};
 
-    const std::unordered_set<std::string> setPokemon = { "BULBASAUR", "IVYSAUR", "VENUSAUR", "CHARMANDER", "CHARMELEON", "CHARIZARD",
+    inline constexpr std::string_view pokemonNames[] = { "BULBASAUR", "IVYSAUR", "VENUSAUR", "CHARMANDER", "CHARMELEON", "CHARIZARD",
     "SQUIRTLE", "WARTORTLE", "BLASTOISE", "CATERPIE", "METAPOD", "BUTTERFREE",
     "WEEDLE", "KAKUNA", "BEEDRILL", "PIDGEY", "PIDGEOTTO", "PIDGEOT",
     "RATTATA", "RATICATE", "SPEAROW", "FEAROW", "EKANS", "ARBOK",
     "PIKACHU", "RAICHU", "SANDSHREW", "SANDSLASH", "NIDORAN", "NIDORINA",
-    "NIDOQUEEN", "NIDORAN", "NIDORINO", "NIDOKING", "CLEFAIRY", "CLEFABLE",
+    "NIDOQUEEN", "NIDORINO", "NIDOKING", "CLEFAIRY", "CLEFABLE",
     "VULPIX", "NINETALES", "JIGGLYPUFF", "WIGGLYTUFF", "ZUBAT", "GOLBAT",
     "ODDISH", "GLOOM", "VILEPLUME", "PARAS", "PARASECT", "VENONAT",
     "VENOMOTH", "DIGLETT", "DUGTRIO", "MEOWTH", "PERSIAN", "PSYDUCK",
@@ -226,6 +376,18 @@ namespace GameData {
     "REGISTEEL", "LATIAS", "LATIOS", "KYOGRE", "GROUDON", "RAYQUAZA",
     "JIRACHI", "DEOXYS" };
 
+    inline constexpr detail::PerfectHashTable<std::size(trainerNames)> trainers(trainerNames);
+    inline constexpr detail::PerfectHashTable<std::size(itemNames)> items(itemNames);
+    inline constexpr detail::PerfectHashTable<std::size(moveNames)> moves(moveNames);
+    inline constexpr detail::PerfectHashTable<std::size(abilityNames)> abilities(abilityNames);
+    inline constexpr detail::PerfectHashTable<std::size(pokemonNames)> pokemon(pokemonNames);
+
+    static_assert(trainers.isBuilt(), "Duplicate name in trainerNames");
+    static_assert(items.isBuilt(), "Duplicate name in itemNames");
+    static_assert(moves.isBuilt(), "Duplicate name in moveNames");
+    static_assert(abilities.isBuilt(), "Duplicate name in abilityNames");
+    static_assert(pokemon.isBuilt(), "Duplicate name in pokemonNames");
+
 }
 
 #endif
\ No newline at end of file
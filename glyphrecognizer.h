@@ -0,0 +1,81 @@
+#pragma once
+#ifndef GLYPHRECOGNIZER_H
+#define GLYPHRECOGNIZER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "layoutprofile.h"
+#include "ocrbackend.h"
+
+// 16x16 one bit per cell image of a glyph, packed four rows per word.
+struct GlyphBitmap {
+    uint64_t bits[4] = { 0, 0, 0, 0 };
+};
+
+// One glyph cut out of a dialogue box.
+struct GlyphCell {
+    int line = 0;             // Line of dialogue the glyph sits on
+    bool spaceBefore = false; // A word gap separates it from the previous glyph on the line
+    float aspect = 0.0f;      // Glyph width over the font cell height
+    GlyphBitmap bitmap;
+};
+
+// Reference bitmap for a character of the game font.
+struct GlyphTemplate {
+    char symbol = ' ';
+    float aspect = 0.0f;
+    GlyphBitmap bitmap;
+};
+
+// A screenshot with the known text of its dialogue box, one entry per line of dialogue.
+struct DialogueLabel {
+    std::string imagePath;
+    std::vector<std::string> lines;
+};
+
+//Reads a labels file where every line is "image path|first dialogue line|second dialogue line". Image paths are
+//relative to the labels file.
+std::vector<DialogueLabel> readDialogueLabels(const std::string& labelsPath);
+
+// Glyph templates for the dialogue font at the capture scale, built offline from labeled screenshots.
+class GlyphAtlas {
+private:
+    int cellHeight; // Font cell height in pixels of the preprocessed image
+    std::vector<GlyphTemplate> templates;
+
+public:
+    GlyphAtlas();
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    //Learns templates from labeled screenshots. Lines whose glyph count does not match their label are skipped.
+    //Returns the number of glyphs that were learned from. nativeMultiple must match the one frames are read at.
+    size_t buildFromLabels(const std::vector<DialogueLabel>& labels, const LayoutProfile& captureLayout = defaultLayoutProfile(),
+        int nativeMultiple = 0);
+
+    int getCellHeight() const;
+    const std::vector<GlyphTemplate>& getTemplates() const;
+};
+
+//Splits a preprocessed dialogue box into glyph cells, line by line, using row and column projections.
+void segmentGlyphs(const cv::Mat& preprocessed, int cellHeight, std::vector<GlyphCell>& cells);
+
+// OCR backend for the fixed bitmap font of the dialogue box. Each segmented glyph is matched against the atlas by
+// Hamming distance of the packed bitmaps (XOR + popcount), so a whole box is recognized in well under a millisecond.
+class GlyphRecognizer : public OcrBackend {
+private:
+    const GlyphAtlas& atlas;
+    int maxCost; // Worst match cost still accepted, out of 256 bitmap cells
+
+public:
+    explicit GlyphRecognizer(const GlyphAtlas& atlas, int maxCost = 48);
+
+    //Returns uppercase text like BattleLogic expects. Glyphs without an acceptable match are left out.
+    std::string recognize(const cv::Mat& preprocessed) override;
+    const char* getName() const override;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef IMAGEPROCESSING_H
+#define IMAGEPROCESSING_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "layoutprofile.h"
+#include "ocrenginepool.h"
+
+//Crops a full capture down to the battle dialogue box. Empty if the box lies outside the capture.
+cv::Mat cropToDialogue(const cv::Mat& screenshot, const LayoutProfile& layout = defaultLayoutProfile());
+
+//Crops a full capture down to the streak counter for the given level ("50" or "100").
+cv::Mat cropToStreakCount(const cv::Mat& screenshot, const std::string& level = "50", const LayoutProfile& layout = defaultLayoutProfile());
+
+// Known text colour of a dialogue box. Pixels within tolerance of it on every channel are text. The defaults match
+// the battle dialogue text of the test captures, tolerance covers its anti-aliased edges.
+struct TextColorKey {
+    uchar b = 190, g = 189, r = 153;
+    int tolerance = 64;
+};
+
+//Converts a crop to a 2x upscaled, Otsu thresholded image ready for OCR.
+cv::Mat preprocessImage(const cv::Mat& input);
+
+//Same result as preprocessImage, computed by a fused kernel in two passes over the crop (luma histogram for Otsu,
+//then threshold + upscale straight into output). Output is only reallocated when its size changes.
+void preprocessImageInto(const cv::Mat& input, cv::Mat& output);
+
+//Keyed variant for boxes with a known text colour: skips Otsu and writes text as white, everything else as black.
+void preprocessImageInto(const cv::Mat& input, cv::Mat& output, const TextColorKey& key);
+
+//Runs OCR on a preprocessed image with an engine checked out from the pool for that profile.
+std::string analyzeImage(const cv::Mat& image, OcrEnginePool& ocrPool, OcrProfile profile = OcrProfile::Dialogue);
+
+#endif
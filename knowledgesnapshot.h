@@ -0,0 +1,91 @@
+#pragma once
+#ifndef KNOWLEDGESNAPSHOT_H
+#define KNOWLEDGESNAPSHOT_H
+
+#include "entitymatcher.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sqlite3.h>
+
+// Read-only copy of the Trainers, Pokemon and Seen tables in a file that is used where it is mapped, so opening it
+// costs a header check and any number of processes can share it. Trainers are sorted by ID with an index sorted by
+// name, each trainer's Pokemon are contiguous with an index sorted by Pokemon ID, and every name is an offset into
+// one pool of interned strings. Lookups are binary searches over the mapping. The database stays the source of truth:
+// the file records the highest row ID of each table it was made from and is only rewritten once one has moved.
+class KnowledgeSnapshot {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+    static const int NOT_FOUND = -1;
+
+    //Index range of a trainer's Pokemon.
+    struct Team {
+        int first = 0;
+        int count = 0;
+    };
+
+private:
+    struct Header;
+    struct TrainerRecord;
+    struct PokemonRecord;
+
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#else
+    int file;
+#endif
+
+    const Header& header() const;
+    const TrainerRecord& trainer(int index) const;
+    const PokemonRecord& pokemon(int index) const;
+    const uint32_t* table(uint32_t offset) const;
+    std::string_view stringAt(uint32_t offset) const;
+
+public:
+    KnowledgeSnapshot();
+    ~KnowledgeSnapshot();
+
+    KnowledgeSnapshot(const KnowledgeSnapshot&) = delete;
+    KnowledgeSnapshot& operator=(const KnowledgeSnapshot&) = delete;
+
+    //Writes a snapshot of the database to path, through a temporary file so a reader never sees half of one. Fails,
+    //leaving the old file, when it can't be replaced, as on Windows while another process has it open.
+    static bool exportFrom(sqlite3* db, const std::string& path);
+
+    //Exports only when the file at path is missing, unreadable or older than the database. Returns false on a
+    //failed export.
+    static bool refresh(sqlite3* db, const std::string& path, bool* exported = nullptr);
+
+    //Maps the file and checks its header. Returns false, and stays closed, when it is not a snapshot of this format.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    //Whether the snapshot was made from the database as it is now.
+    bool isCurrent(sqlite3* db) const;
+
+    int getTrainerCount() const;
+    int getPokemonCount() const;
+
+    //Trainer index by name or by database ID, or NOT_FOUND.
+    int findTrainer(std::string_view name) const;
+    int findTrainerByID(int trainerID) const;
+    int getTrainerID(int trainerIndex) const;
+    std::string_view getTrainerName(int trainerIndex) const;
+    Team getTeam(int trainerIndex) const;
+
+    //Pokemon index by database ID, or NOT_FOUND.
+    int findPokemonByID(int pokemonID) const;
+    int getPokemonID(int pokemonIndex) const;
+    std::string_view getPokemonName(int pokemonIndex) const;
+
+    //Moves, abilities or items a Pokemon has been seen with.
+    int getSeenCount(int pokemonIndex, EntityType type) const;
+    std::string_view getSeen(int pokemonIndex, EntityType type, int seenIndex) const;
+};
+
+#endif
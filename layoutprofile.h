@@ -0,0 +1,48 @@
+#pragma once
+#ifndef LAYOUTPROFILE_H
+#define LAYOUTPROFILE_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+// Where the game screen sits in a capture and the regions the reader crops from it. Regions are kept in GBA screen
+// pixels (240x160), so the same profile fits any capture size once the screen rectangle has been found. They are
+// fractional, so a region measured in capture pixels maps back to exactly the pixels it was measured as.
+struct LayoutProfile {
+    static const int NATIVE_WIDTH = 240;
+    static const int NATIVE_HEIGHT = 160;
+
+    std::string name;
+    cv::Rect screen;         // GBA screen in capture pixels, capture setups often stretch one axis more than the other
+    cv::Rect2d dialogue;       // Battle dialogue box, native pixels
+    cv::Rect2d streakLevel50;  // Current streak on the results screen for level 50, native pixels
+    cv::Rect2d streakLevel100; // Same for open level, native pixels
+
+    //Game Boy Player capture the TestScreenshots were taken with (1920x1017 capture window).
+    static LayoutProfile gameBoyPlayer();
+
+    //Maps a native rectangle into capture pixels, rounding each edge to the nearest pixel.
+    cv::Rect toCapture(const cv::Rect2d& native) const;
+
+    //Maps a rectangle in capture pixels to native ones, the exact inverse of toCapture.
+    cv::Rect2d toNative(const cv::Rect& capture) const;
+
+    //Profile for frames made by downscaleToNative with the same multiple.
+    LayoutProfile scaledToNative(int multiple) const;
+
+    //Finds the screen rectangle from a reference frame that shows the battle dialogue box. Leaves the profile
+    //unchanged and returns false when there is no box to calibrate from.
+    bool calibrate(const cv::Mat& referenceFrame);
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+};
+
+//Profile used by the crop functions when none is given.
+const LayoutProfile& defaultLayoutProfile();
+
+//Crops the screen out of a capture and shrinks it to multiple times the native resolution, so everything downstream
+//works on a few hundred thousand pixels whatever the capture size. output is reused when its size already matches.
+void downscaleToNative(const cv::Mat& capture, const LayoutProfile& layout, int multiple, cv::Mat& output);
+
+#endif
@@ -6,142 +6,111 @@ and will grab screenshots of the screen while battling to display relevant infor
 for the player to conserve time spent using these tools separately.
 */
 
+#include <fstream>
 #include <iostream>
-#include <windows.h>
 #include <opencv2/opencv.hpp>
 #include <opencv2/opencv_modules.hpp>
 #include <tesseract/baseapi.h>
 #include <leptonica/allheaders.h>
 #include <thread>
 #include <chrono>
+#include "battleeventlog.h"
 #include "battlelogic.h"
+#include "capturescheduler.h"
+#include "imageprocessing.h"
+#include "ocrenginepool.h"
+#include "benchmark.h"
+#include "databaseinterface.h"
+#include "databasewriter.h"
+#include "framepipeline.h"
+#include "framesource.h"
+#include "glyphrecognizer.h"
+#include "layoutprofile.h"
+#include "ocrbackend.h"
+#include "streakreader.h"
 using namespace std;
 
-cv::Mat captureScreen(HWND hwnd) {
-    RECT rc;
-    GetClientRect(hwnd, &rc);
-    int width = rc.right - rc.left;
-    int height = rc.bottom - rc.top;
-
-    HDC hdcWindow = GetDC(hwnd);
-    HDC hdcMemDC = CreateCompatibleDC(hdcWindow);
-    HBITMAP hbmScreen = CreateCompatibleBitmap(hdcWindow, width, height);
-    SelectObject(hdcMemDC, hbmScreen);
-    BitBlt(hdcMemDC, 0, 0, width, height, hdcWindow, 0, 0, SRCCOPY);
-
-    BITMAPINFO bmi = { 0 };
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = width;
-    bmi.bmiHeader.biHeight = -height; // Negative to indicate top-down bitmap
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 24;
-    bmi.bmiHeader.biCompression = BI_RGB;
-
-    cv::Mat mat(height, width, CV_8UC3);
-    GetDIBits(hdcMemDC, hbmScreen, 0, height, mat.data, &bmi, DIB_RGB_COLORS);
-
-    DeleteObject(hbmScreen);
-    DeleteDC(hdcMemDC);
-    ReleaseDC(hwnd, hdcWindow);
-
-    return mat;
-}
-
-cv::Mat cropToDialogue(const cv::Mat& screenshot) {
-    cv::Rect dialogueBox(242, 670, 1300, 211); //Coordinates for the dialogue box area to capture
-    return screenshot(dialogueBox);
-}
-
-cv::Mat cropToStreakCount(const cv::Mat& screenshot, const std::string& level = "50") { //Currently hardcoded to level 50, can be changed to take either 50 or 100 from user when ready to move beyond 50.
-    cv::Rect streakBox;
-    if (level == "50") {
-        streakBox = cv::Rect(1580, 375, 120, 90); //Coordinates for the streak count area for level 50
-    } else if (level == "100") {
-        streakBox = cv::Rect(1580, 620, 120, 90); //Coordinates for the streak count area for level 100
-    } else {
-        cerr << "Invalid level selected for scropToStreakCount()." << endl;
-        return cv::Mat();
+void captureLoop(const CaptureRates& rates, const string& glyphAtlasPath, const string& streakLabelsPath, const LayoutProfile& layout, int nativeMultiple,
+    const string& sourceSpec, const string& snapshotPath, const string& eventLogPath) {
+    cv::setNumThreads(1);
+    unique_ptr<FrameSource> source = openFrameSource(sourceSpec); //e.g. window:4K Capture Utility, ensure the title matches your setup
+    if (!source) {
+        return;
     }
-    return screenshot(streakBox);
-}
-
-cv::Mat preprocessImage(const cv::Mat& input) {
-    cv::Mat gray, thresh;
-    cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
-    cv::threshold(gray, thresh, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-    cv::resize(thresh, thresh, cv::Size(), 2, 2, cv::INTER_LINEAR);
-    return thresh;
-}
+    cout << "Frame source: " << source->getName() << endl;
 
-string analyzeImage(cv::Mat image) {
-    string result;
-    tesseract::TessBaseAPI tess;
-    if (tess.Init(NULL, "eng", tesseract::OEM_LSTM_ONLY)) {
-        cerr << "Error intiializing tesseract" << endl;
-        return "";
+    DatabaseInterface::preloadKnowledge(snapshotPath); //Trainers are scouted from memory from here on
+    DatabaseWriter::shared().setSnapshotPath(snapshotPath);
+    BattleLogic battleLogic;
+    BattleEventLog eventLog;
+    if (!eventLogPath.empty()) {
+        if (!eventLog.open(eventLogPath)) return;
+        battleLogic.setEventLog(&eventLog);
     }
+    OcrEnginePool ocrPool;
+    ocrPool.warmUp();
 
-    tess.SetPageSegMode(tesseract::PSM_SINGLE_BLOCK);
-    tess.SetVariable("tessedit_char_whitelist", "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789.!?'(),- ");
-    tess.SetImage(image.data, image.cols, image.rows, image.channels(), image.step);
-
-    result = tess.GetUTF8Text();
-    tess.End();
-    return result;
-}
-
-void captureLoop(double interval) {
-    cv::setNumThreads(1);
-    HWND hwnd = FindWindow(NULL, L"4K Capture Utility"); //Ensure window title matches your setup
-    if (hwnd == NULL) {
-        cerr << "Error: window not found." << endl;
-        return;
+    //Dialogue is read by the glyph recognizer when an atlas is given, otherwise by Tesseract.
+    TesseractBackend tesseractOcr(ocrPool);
+    GlyphAtlas glyphAtlas;
+    GlyphRecognizer glyphOcr(glyphAtlas);
+    OcrBackend* dialogueOcr = &tesseractOcr;
+    if (!glyphAtlasPath.empty()) {
+        if (!glyphAtlas.load(glyphAtlasPath)) return;
+        dialogueOcr = &glyphOcr;
     }
+    cout << "Dialogue OCR backend: " << dialogueOcr->getName() << endl;
 
-    vector<string> testImages = {
-    "C:/Users/umbre/Documents/Coding for _fun_/C++/PokemonReaderFinal/TestScreenshots/screenshot_49.png",
-    "C:/Users/umbre/Documents/Coding for _fun_/C++/PokemonReaderFinal/TestScreenshots/screenshot_100.png",
-    "C:/Users/umbre/Documents/Coding for _fun_/C++/PokemonReaderFinal/TestScreenshots/screenshot_300.png"
-    };
-    string testImagePath = "C:/Users/umbre/Documents/Coding for _fun_/C++/PokemonReaderFinal/TestScreenshots/screenshot_"; //Path to test images
+    //Replays wait on OCR instead of dropping frames, live capture drops to stay current.
+    FramePipeline pipeline(battleLogic, *dialogueOcr, 1, 8, source->isLive());
+    pipeline.setLayout(layout, nativeMultiple);
+    if (!streakLabelsPath.empty()) {
+        StreakReader streakReader;
+        size_t learned = streakReader.learnFromLabels(readStreakLabels(streakLabelsPath));
+        cout << "Streak digits learned from " << learned << " samples, " << streakReader.getLearnedDigits() << " of 10 digits" << endl;
+        pipeline.setStreakReader(streakReader);
+    }
+    pipeline.setLineObserver([](const DialogueLine& line) {
+        cout << "Line at " << line.timestamp << " s (frame " << line.frame << "): " << line.text << endl;
+    });
 
-    BattleLogic battleLogic;
-    for (int i = 0; i < 2700; ++i) {
-        cv::Mat img = cv::imread(testImagePath + to_string(i) + ".png");
-        if (img.empty()) {
-            cerr << "Error loading: " << testImagePath + to_string(i) + ".png" << endl;
-            continue;
-        }
-
-        cout << "Processing image: " << i + 1 << endl;
-
-        if (battleLogic.getCurrentStreak() < 0 && battleLogic.getState() == 0) {
-            cv::Mat foundStreak = preprocessImage(cropToStreakCount(img));
-            //cout << "Streak Test " << i + 1 << " Text: \n" << analyzeImage(foundStreak) << endl;
-            string foundStreakText = analyzeImage(foundStreak);
-            if (foundStreakText.size() <= 3) {
-                try {
-                    battleLogic.handleStreakNumber(stoi(foundStreakText));
-                }
-                catch (const std::invalid_argument& e) {
-                }
-                catch (const std::out_of_range& e) {
-                }
-            }
+    //Live capture runs faster while a line is expected, and keeps time however long a frame took to read.
+    CaptureScheduler scheduler(rates);
+    int i = 0;
+    pipeline.run([&](cv::Mat& img) {
+        if (source->isLive()) {
+            scheduler.waitForNextFrame(pipeline.getBattleState());
         }
+        if (!source->next(img)) {
+            return false;
+        }
+        cout << "Processing image: " << ++i << endl;
+        return true;
+    });
 
-        cv::Mat foundDialogue = preprocessImage(cropToDialogue(img));
-        string foundDialogueText = analyzeImage(foundDialogue);
-        //cout << "Dialogue Test " << i + 1 << " Text: \n" << analyzeImage(foundDialogue) << endl;
-        battleLogic.handleDialogueLine(foundDialogueText);
-
+    cout << "Frames captured: " << pipeline.getFramesCaptured() << ", processed: " << pipeline.getFramesProcessed()
+        << ", dropped before OCR: " << pipeline.getFramesDropped() << endl;
+    cout << "Dialogue OCR skipped (line printing or already read): " << pipeline.getDialogueOcrSkipped() << ", performed: " << pipeline.getDialogueOcrPerformed() << endl;
+    cout << "Dialogue OCR skipped (blank box): " << pipeline.getDialogueBlankSkipped() << endl;
+    cout << "Dialogue lines handled: " << pipeline.getLinesEmitted() << endl;
+    if (eventLog.isOpen()) {
+        eventLog.flush();
+        cout << "Battle events logged: " << eventLog.getEventsWritten() << " in " << eventLog.getBlocksWritten() << " blocks" << endl;
+    }
+    if (source->isLive()) {
+        cout << "Capture rate: " << scheduler.getEffectiveRate() << " frames/s, missed deadlines: " << scheduler.getDeadlinesMissed()
+            << " of " << scheduler.getFramesScheduled() << endl;
+    }
 
+    //The battle in progress is queued, and every queued battle written, while the database is still open.
+    battleLogic.clearCurrentTrainer();
+    DatabaseWriter::shared().stop();
 
         //Proper loop, currently commented out to prevent infinite loop during testing
         /*
          while (true) {
-            cv::Mat screenshot = captureScreen(hwnd);
-            if (!screenshot.empty()){
+            cv::Mat screenshot;
+            if (source->next(screenshot)){
                 string filename = "C:/Users/umbre/Documents/Coding for _fun_/C++/PokemonReader/TestScreenshots/screenshot.png"; //No longer proper path, change to within program directory and have it overwrite the same screenshot after processing.
                 cv::imwrite(filename, screenshot);
             }
@@ -158,15 +127,200 @@ void captureLoop(double interval) {
 
             //TODO: Implement proper exit condition for when the program should stop capturing screenshots.
         } */
+}
+
+
+
+//Backfills the database from archived sessions, in batches of records that are each written in one transaction.
+bool ingestArchives(const vector<string>& archivePaths) {
+    const size_t recordsPerBatch = 50000;
+    vector<SightingRecord> records;
+    IngestCounts added;
+    size_t recordsRead = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < archivePaths.size(); ++i) {
+        if (!readSightingArchive(archivePaths[i], records)) return false;
+        if (records.size() < recordsPerBatch && i + 1 < archivePaths.size()) continue;
+
+        recordsRead += records.size();
+        if (!DatabaseInterface::ingestSightings(records, added)) return false;
+        records.clear();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "Ingested " << recordsRead << " records from " << archivePaths.size() << " archives in " << elapsed.count() << " s ("
+        << recordsRead / elapsed.count() << " records/s): " << added.trainers << " new trainers, " << added.pokemon
+        << " new Pokemon, " << added.sightings << " new sightings" << endl;
+    return true;
+}
 
+//Rebuilds the database from an event log: the events are replayed into trainer histories in memory, which are then
+//added in one bulk ingest.
+bool replayEventLog(const string& logPath) {
+    BattleEventReplayer replayer;
+    BattleEventLogStats stats;
+    auto start = chrono::steady_clock::now();
+    if (!replayer.replay(logPath, &stats)) return false;
+    chrono::duration<double> replayTime = chrono::steady_clock::now() - start;
+    cout << "Replayed " << stats.events << " events in " << replayTime.count() << " s (" << stats.events / replayTime.count() << " events/s): "
+        << replayer.getBattles() << " battles, " << replayer.getEventsRejected() << " events ignored" << endl;
+    if (stats.damagedTail) {
+        cout << "Stopped at a damaged block " << stats.intactBytes << " bytes in, the events after it were lost" << endl;
     }
+
+    vector<SightingRecord> records;
+    replayer.toSightings(records);
+    IngestCounts added;
+    if (!DatabaseInterface::ingestSightings(records, added)) return false;
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "Database rebuilt in " << elapsed.count() << " s: " << added.trainers << " new trainers, " << added.pokemon << " new Pokemon, "
+        << added.sightings << " new sightings" << endl;
+    return true;
 }
 
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && string(argv[1]) == "--bench") { //Usage: --bench <name> [corpus directory]
+        string benchName = argv[2];
+        string corpusDir = argc >= 4 ? argv[3] : "TestScreenshots";
+        if (benchName == "pipeline") { //Usage: --bench pipeline [corpus directory or video:<file>] [results .json or .csv] [glyph atlas]
+            Benchmark::pipeline(corpusDir, argc >= 5 ? argv[4] : "", argc >= 6 ? argv[5] : "");
+        }
+        else if (benchName == "ocr-pool") {
+            Benchmark::ocrEnginePool(corpusDir);
+        }
+        else if (benchName == "blank-detector") {
+            Benchmark::blankDetector(corpusDir);
+        }
+        else if (benchName == "preprocess") {
+            Benchmark::preprocessKernel(corpusDir);
+        }
+        else if (benchName == "native-scale") {
+            Benchmark::nativeScale(corpusDir);
+        }
+        else if (benchName == "glyph") {
+            Benchmark::glyphRecognizer(corpusDir, argc >= 5 ? argv[4] : "glyph_atlas.txt");
+        }
+        else if (benchName == "gamedata") {
+            Benchmark::gameData();
+        }
+        else if (benchName == "fuzzy") {
+            Benchmark::fuzzyIndex();
+        }
+        else if (benchName == "db-inserts") {
+            Benchmark::databaseInserts();
+        }
+        else if (benchName == "ingest") {
+            Benchmark::bulkIngest();
+        }
+        else if (benchName == "knowledge") {
+            Benchmark::trainerKnowledge();
+        }
+        else if (benchName == "db-schema") {
+            Benchmark::databaseSchema();
+        }
+        else if (benchName == "db-concurrency") {
+            Benchmark::databaseConcurrency();
+        }
+        else if (benchName == "snapshot") {
+            Benchmark::knowledgeSnapshot();
+        }
+        else if (benchName == "team-layout") {
+            Benchmark::teamLayout();
+        }
+        else if (benchName == "line-stabilizer") {
+            Benchmark::lineStabilizer();
+        }
+        else if (benchName == "capture-scheduler") {
+            Benchmark::captureScheduler(corpusDir);
+        }
+        else if (benchName == "event-log") {
+            Benchmark::eventLog();
+        }
+        else {
+            cerr << "Unknown benchmark: " << benchName << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc >= 3 && string(argv[1]) == "--ingest") { //Usage: --ingest <archive file>..., lines are trainer|pokemon[|move, ability or item|name]
+        return ingestArchives(vector<string>(argv + 2, argv + argc)) ? 0 : 1;
+    }
+
+    if (argc >= 3 && string(argv[1]) == "--replay") { //Usage: --replay <event log>, as written with --event-log
+        return replayEventLog(argv[2]) ? 0 : 1;
+    }
+
+    if (argc >= 3 && string(argv[1]) == "--export-snapshot") { //Usage: --export-snapshot <snapshot file>, rewritten only if the database changed
+        bool exported = false;
+        if (!DatabaseInterface::refreshSnapshot(argv[2], &exported)) return 1;
+        cout << (exported ? "Exported knowledge snapshot to " : "Knowledge snapshot is current: ") << argv[2] << endl;
+        return 0;
+    }
 
+    if (argc >= 4 && string(argv[1]) == "--build-atlas") { //Usage: --build-atlas <labels file> <atlas output> [native multiple]
+        GlyphAtlas atlas;
+        size_t learned = atlas.buildFromLabels(readDialogueLabels(argv[2]), LayoutProfile::gameBoyPlayer(), argc >= 5 ? atoi(argv[4]) : 0);
+        cout << "Learned " << learned << " glyphs into " << atlas.getTemplates().size() << " templates." << endl;
+        return atlas.save(argv[3]) ? 0 : 1;
+    }
+
+    if (argc >= 4 && string(argv[1]) == "--calibrate") { //Usage: --calibrate <reference battle frame> <profile output>
+        LayoutProfile layout = LayoutProfile::gameBoyPlayer();
+        layout.name = "Calibrated";
+        if (!layout.calibrate(cv::imread(argv[2]))) {
+            cerr << "No battle dialogue box found in " << argv[2] << endl;
+            return 1;
+        }
+        cout << "Screen found at " << layout.screen.x << "," << layout.screen.y << " size " << layout.screen.width << "x" << layout.screen.height << endl;
+        return layout.save(argv[3]) ? 0 : 1;
+    }
+
+    string glyphAtlasPath;
+    string streakLabelsPath = ifstream("TestScreenshots/streak_labels.txt").good() ? "TestScreenshots/streak_labels.txt" : "";
+    string sourceSpec = "TestScreenshots";
+    LayoutProfile layout = LayoutProfile::gameBoyPlayer();
+    int nativeMultiple = 0;
+    string snapshotPath;
+    string eventLogPath;
+    CaptureRates rates; //Timing to adjust for faster or slower screenshots
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--glyph-atlas") { //Usage: --glyph-atlas <atlas file>
+            glyphAtlasPath = argv[i + 1];
+        }
+        else if (option == "--streak-labels") { //Usage: --streak-labels <labels file>, captures to learn the streak counter digits from
+            streakLabelsPath = argv[i + 1];
+        }
+        else if (option == "--layout") { //Usage: --layout <profile file>, as written by --calibrate
+            if (!layout.load(argv[i + 1])) return 1;
+        }
+        else if (option == "--source") { //Usage: --source <dir:path | video:file | device:index | window:title | x11[:display]>
+            sourceSpec = argv[i + 1];
+        }
+        else if (option == "--native-scale") { //Usage: --native-scale <multiple of 240x160>, glyph atlases must be built at the same scale
+            nativeMultiple = atoi(argv[i + 1]);
+        }
+        else if (option == "--fixed-interval") { //Usage: --fixed-interval <seconds>, captures at one rate whatever the battle state
+            double interval = atof(argv[i + 1]);
+            if (interval <= 0) {
+                cerr << "Capture interval must be above 0 seconds" << endl;
+                return 1;
+            }
+            rates = CaptureRates::fixed(interval);
+        }
+        else if (option == "--snapshot") { //Usage: --snapshot <snapshot file>, loaded at startup and kept current as battles are saved
+            snapshotPath = argv[i + 1];
+        }
+        else if (option == "--event-log") { //Usage: --event-log <log file>, every battle event read is appended to it
+            eventLogPath = argv[i + 1];
+        }
+        else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
 
-int main() {
-    double interval = 0.333; //Timing to adjust for faster or slower screenshots
-    captureLoop(interval);
+    captureLoop(rates, glyphAtlasPath, streakLabelsPath, layout, nativeMultiple, sourceSpec, snapshotPath, eventLogPath);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef OCRBACKEND_H
+#define OCRBACKEND_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "ocrenginepool.h"
+
+// Common interface for the engines that turn a preprocessed (binarized, 2x upscaled) dialogue box into text.
+class OcrBackend {
+public:
+    virtual ~OcrBackend() = default;
+
+    //Returns the text of the box, one line of dialogue per line of output.
+    virtual std::string recognize(const cv::Mat& preprocessed) = 0;
+
+    //Short name used in logs and benchmark output.
+    virtual const char* getName() const = 0;
+};
+
+// General purpose LSTM OCR through the Tesseract engine pool.
+class TesseractBackend : public OcrBackend {
+private:
+    OcrEnginePool& ocrPool;
+    OcrProfile profile;
+
+public:
+    TesseractBackend(OcrEnginePool& ocrPool, OcrProfile profile = OcrProfile::Dialogue);
+
+    std::string recognize(const cv::Mat& preprocessed) override;
+    const char* getName() const override;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef OCRENGINEPOOL_H
+#define OCRENGINEPOOL_H
+
+#include <tesseract/baseapi.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Screen regions that are read with their own Tesseract configuration.
+enum class OcrProfile {
+    Dialogue, // Full character whitelist, single block of text.
+    Streak    // Digits only, used on the streak counter.
+};
+
+// Pool of long-lived, pre-configured Tesseract engines. Loading the LSTM model is the expensive part of OCR,
+// so engines are initialized once per profile and checked out for each image instead of being rebuilt per call.
+class OcrEnginePool {
+private:
+    struct ProfileSlots {
+        std::vector<std::unique_ptr<tesseract::TessBaseAPI>> engines; // Every engine created for this profile
+        std::vector<tesseract::TessBaseAPI*> idle;                     // Engines currently free to be checked out
+        size_t reserved = 0;                                           // Engines created or being initialized
+    };
+
+    size_t enginesPerProfile;
+    ProfileSlots dialogueSlots;
+    ProfileSlots streakSlots;
+    std::mutex poolMutex;
+    std::condition_variable engineReturned;
+
+    ProfileSlots& slotsFor(OcrProfile profile);
+    static std::unique_ptr<tesseract::TessBaseAPI> createEngine(OcrProfile profile);
+    void release(OcrProfile profile, tesseract::TessBaseAPI* engine);
+
+public:
+    // Checked out engine, returned to the pool automatically when it goes out of scope.
+    class Lease {
+    private:
+        OcrEnginePool* pool;
+        OcrProfile profile;
+        tesseract::TessBaseAPI* engine;
+
+    public:
+        Lease(OcrEnginePool* pool, OcrProfile profile, tesseract::TessBaseAPI* engine);
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        // False if the engine could not be initialized.
+        explicit operator bool() const { return engine != nullptr; }
+        tesseract::TessBaseAPI* operator->() const { return engine; }
+    };
+
+    //Engines are created lazily, up to enginesPerProfile for each profile (one per worker thread using it).
+    explicit OcrEnginePool(size_t enginesPerProfile = 1);
+    ~OcrEnginePool();
+
+    OcrEnginePool(const OcrEnginePool&) = delete;
+    OcrEnginePool& operator=(const OcrEnginePool&) = delete;
+
+    //Checks out an engine for the profile, blocking while all of that profile's engines are in use.
+    Lease acquire(OcrProfile profile);
+
+    //Initializes every engine up front so the first frames do not pay for loading the model. Call before handing the pool to workers.
+    void warmUp();
+};
+
+#endif
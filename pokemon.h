@@ -2,35 +2,33 @@
 #ifndef POKEMON_H
 #define POKEMON_H
 
-#include <string>
-#include <vector>
-
-// Pokemon class that holds moves, abilities, items, and a trainer-specific ID.
-class Pokemon {
-private:
-    int trainerId;
-    std::vector<std::string> seenMoves;
-    std::string Name;
-    std::string SeenAbility;
-    std::string SeenItem;
-
-
-public:
-    Pokemon();
-    Pokemon(const std::string& name);
-    Pokemon(const std::string& name, int trainerId);
-
-    std::string getName() const;
-
-    std::string getSeenAbility() const;
-
-    std::vector<std::string> getSeenMoves() const;
-
-    std::string getSeenItem() const;
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// One of a trainer's Pokemon as seen in battle, by GameData IDs. Trivially copyable, so a team is copied and queued
+// for the database writer without allocating. Names are looked up only where text is read or shown.
+struct Pokemon {
+    static constexpr int16_t NONE = -1; // No species, or a move, ability or item not seen yet
+    static const size_t MAX_MOVES = 4;
+
+    int16_t species = NONE;
+    std::array<int16_t, MAX_MOVES> moves = { NONE, NONE, NONE, NONE }; // Seen moves first, in the order seen
+    int16_t ability = NONE;
+    int16_t item = NONE;
+
+    bool isEmpty() const;
+
+    //Adds a move not seen before. Returns false when it is already known or four moves are.
+    bool addMove(int move);
+    size_t getMoveCount() const;
+};
 
-    void setAbility(const std::string& Ability);
+static_assert(std::is_trivially_copyable<Pokemon>::value, "Pokemon is copied as plain bytes");
 
-    void setItem(const std::string& Item);
-};
+// A trainer's Pokemon in a single battle, in the order they were sent out. Empty slots have no species.
+const size_t TEAM_SIZE = 3;
+using Team = std::array<Pokemon, TEAM_SIZE>;
 
-#endif
\ No newline at end of file
+#endif
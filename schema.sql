@@ -1,3 +1,6 @@
+-- The schema at its latest version, for reference. The program creates pokemon_db.sqlite itself and brings it up to
+-- date with the migrations in DatabaseMigrations.cpp, which are where the schema changes.
+
 CREATE TABLE IF NOT EXISTS Trainers (
     trainer_id INTEGER PRIMARY KEY AUTOINCREMENT,
     name TEXT UNIQUE NOT NULL,
@@ -30,4 +33,6 @@ CREATE TABLE IF NOT EXISTS SeenAbilities (
     ability TEXT,
     PRIMARY KEY (pokemon_id, ability),
     FOREIGN KEY (pokemon_id) REFERENCES Pokemon(pokemon_id) ON DELETE CASCADE
-);
\ No newline at end of file
+);
+
+CREATE UNIQUE INDEX IF NOT EXISTS PokemonByTrainer ON Pokemon(trainer_id, name);
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Steps of handling a frame that are timed separately.
+enum class PipelineStage {
+    Decode,        // Frame source delivering a frame
+    Crop,          // Downscale to native resolution and dialogue crop
+    Detect,        // Unchanged and blank dialogue box checks
+    Preprocess,    // preprocessImage on the dialogue box
+    Streak,        // Streak counter read
+    Ocr,           // Dialogue OCR backend
+    DialogueLogic, // BattleLogic::handleDialogueLine, includes any database work it triggers
+    Database,      // Trainer lookups and persistence
+    Count
+};
+
+const size_t PIPELINE_STAGE_COUNT = static_cast<size_t>(PipelineStage::Count);
+
+const char* getStageName(PipelineStage stage);
+
+// Latency summary of one stage, in microseconds.
+struct StageLatency {
+    size_t count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+// Collects stage latencies while installed. Timers are free when no recorder is installed, so the stages stay
+// instrumented in normal runs.
+class LatencyRecorder {
+private:
+    mutable std::mutex mutex;
+    std::vector<double> samples[PIPELINE_STAGE_COUNT]; // Microseconds
+
+public:
+    void record(PipelineStage stage, double micros);
+    StageLatency summarize(PipelineStage stage) const;
+    void clear();
+
+    //Makes recorder the one timers report to, nullptr stops recording.
+    static void install(LatencyRecorder* recorder);
+    static LatencyRecorder* active();
+};
+
+// Times its own lifetime and reports it to the installed recorder, if any.
+class ScopedStageTimer {
+private:
+    PipelineStage stage;
+    LatencyRecorder* recorder;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedStageTimer(PipelineStage stage);
+    ~ScopedStageTimer();
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
+
+#endif
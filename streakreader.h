@@ -0,0 +1,70 @@
+#pragma once
+#ifndef STREAKREADER_H
+#define STREAKREADER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "layoutprofile.h"
+
+// Result of reading the streak counter.
+struct StreakReading {
+    int value = -1;          // Streak number, -1 when no digits were found
+    float confidence = 0.0f; // 0 to 1, the weakest digit match of the number
+};
+
+// A capture with a known number at a region of it, for learning the digit templates.
+struct StreakLabel {
+    std::string imagePath;
+    cv::Rect region; // Capture pixels
+    int value = -1;
+};
+
+//Reads a labels file where every line is "image path|x y width height|number", the region in capture pixels. Image
+//paths are relative to the labels file.
+std::vector<StreakLabel> readStreakLabels(const std::string& labelsPath);
+
+// Reads the win streak (at most 3 digits) straight from the raw streak counter crop without OCR. The crop is
+// thresholded with Otsu, digits are cut by column projection (touching digits are split by the expected digit
+// width) and each digit is matched against templates of the game font by Hamming distance. The templates are
+// learned from labeled captures, digits missing from them keep a built-in approximation of the font.
+class StreakReader {
+private:
+    struct DigitBits {
+        uint64_t bits[3]; // 12x16 grid
+    };
+
+    struct DigitTemplate {
+        int digit;
+        bool learned; // Taken from captures rather than built in
+        DigitBits shape;
+    };
+
+    std::vector<DigitTemplate> templates;
+    std::vector<uchar> ink;         // Reused between reads, so a reader should not be shared across threads
+    std::vector<DigitBits> sampled; // Digits of the crop being read, reused like ink
+
+    //Thresholds a crop and samples its digits onto the grid, left to right, into sampled. Returns false when there
+    //are none or more than a streak has.
+    bool sampleDigits(const cv::Mat& streakCrop);
+
+public:
+    StreakReader();
+
+    //Replaces the templates of the digits shown in the labeled captures with the digits as captured, each the
+    //majority of its samples. Labels whose digit count does not match their number are skipped. Returns the number
+    //of digits learned from.
+    size_t learnFromLabels(const std::vector<StreakLabel>& labels);
+
+    //Digits whose template was learned from captures.
+    size_t getLearnedDigits() const;
+
+    //Reads the streak counter region of a capture for level "50" or "100". Never throws.
+    StreakReading read(const cv::Mat& screenshot, const std::string& level = "50", const LayoutProfile& layout = defaultLayoutProfile());
+
+    //Reads an already cropped streak counter region.
+    StreakReading readRegion(const cv::Mat& streakCrop);
+};
+
+#endif
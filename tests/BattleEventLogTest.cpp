@@ -0,0 +1,192 @@
+/*
+Checks the battle event log: a session read by BattleLogic with a log attached, replayed, gives the rows the live run
+wrote to the database, and a block torn by a crash is left out on reading and cut off when the log is reopened.
+*/
+
+#include "check.h"
+#include "battleeventlog.h"
+#include "battlelogic.h"
+#include "databaseinterface.h"
+#include "databasewriter.h"
+#include "gamedata.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sqlite3.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+    const char* const DB_PATH = "battleeventlogtest.sqlite";
+    const char* const LOG_PATH = "battleeventlogtest.log";
+
+    typedef std::tuple<std::string, std::string, int, std::string> Row; // Trainer, Pokemon, SightingKind, detail
+
+    void removeScratchFiles() {
+        for (const char* suffix : { "", "-wal", "-shm" }) std::remove((std::string(DB_PATH) + suffix).c_str());
+        std::remove(LOG_PATH);
+    }
+
+    // Every Pokemon and detail in the database, as the sighting records that would make them.
+    std::vector<Row> readDatabase() {
+        static const char* const QUERY =
+            "SELECT t.name, p.name, 0, '' FROM Pokemon p JOIN Trainers t ON t.trainer_id = p.trainer_id "
+            "UNION ALL SELECT t.name, p.name, 1, s.move FROM SeenMoves s JOIN Pokemon p ON p.pokemon_id = s.pokemon_id JOIN Trainers t ON t.trainer_id = p.trainer_id "
+            "UNION ALL SELECT t.name, p.name, 2, s.ability FROM SeenAbilities s JOIN Pokemon p ON p.pokemon_id = s.pokemon_id JOIN Trainers t ON t.trainer_id = p.trainer_id "
+            "UNION ALL SELECT t.name, p.name, 3, s.item FROM SeenItems s JOIN Pokemon p ON p.pokemon_id = s.pokemon_id JOIN Trainers t ON t.trainer_id = p.trainer_id;";
+        std::vector<Row> rows;
+        ReadConnection reader = DatabaseInterface::openReader();
+        sqlite3_stmt* stmt = nullptr;
+        if (!reader || sqlite3_prepare_v2(reader.get(), QUERY, -1, &stmt, nullptr) != SQLITE_OK) return rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            rows.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                sqlite3_column_int(stmt, 2), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
+        }
+        sqlite3_finalize(stmt);
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    std::vector<Row> toRows(const std::vector<SightingRecord>& records) {
+        std::vector<Row> rows;
+        for (const SightingRecord& record : records) rows.emplace_back(record.trainer, record.pokemon, static_cast<int>(record.kind), record.detail);
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    size_t countEvents(BattleEventType type, const std::vector<BattleEvent>& events) {
+        return std::count_if(events.begin(), events.end(), [type](const BattleEvent& event) { return event.type == type; });
+    }
+
+    // Two battles: one the trainer loses, then one the program exits in the middle of.
+    void checkReplayMatchesDatabase() {
+        std::string first(GameData::trainerNames[5]);
+        std::string second(GameData::trainerNames[12]);
+        const std::vector<std::string> lines = {
+            "YOU WILL BE FACING OPPONENT",
+            "PKMN TRAINER " + first + " WOULD LIKE TO BATTLE!",
+            first + " SENT OUT GEODUDE!",
+            "FOE GEODUDE USED ROCK THROW!",
+            "FOE GEODUDE USED TACKLE!",
+            "FOE GEODUDE FAINTED!",
+            first + " SENT OUT ONIX!",
+            "FOE ONIX USED BIND!",
+            "FOE ONIX FAINTED!",
+            "WE WILL RESTORE YOUR POKEMON",
+            "PKMN TRAINER " + second + " WOULD LIKE TO BATTLE!",
+            second + " SENT OUT PIKACHU!",
+            "FOE PIKACHU USED THUNDERBOLT!" };
+
+        removeScratchFiles();
+        CHECK(DatabaseInterface::openDB(DB_PATH));
+        {
+            BattleEventLog log;
+            CHECK(log.open(LOG_PATH));
+            BattleLogic logic;
+            logic.setEventLog(&log);
+            logic.setFrame(1, 0.25);
+            logic.handleStreakNumber(14);
+            uint64_t frame = 2;
+            for (const std::string& line : lines) {
+                logic.setFrame(frame, frame * 0.25);
+                logic.handleDialogueLine(line);
+                frame++;
+            }
+            logic.clearCurrentTrainer();
+            logic.setEventLog(nullptr);
+        }
+        DatabaseWriter::shared().flush();
+
+        std::vector<BattleEvent> events;
+        BattleEventLogStats stats;
+        CHECK(BattleEventLog::read(LOG_PATH, [&events](const BattleEvent& event) { events.push_back(event); }, &stats));
+        CHECK(!stats.damagedTail);
+        CHECK_EQUAL(countEvents(BattleEventType::TrainerFound, events), 2u);
+        CHECK_EQUAL(countEvents(BattleEventType::PokemonSentOut, events), 3u);
+        CHECK_EQUAL(countEvents(BattleEventType::MoveSeen, events), 4u);
+        CHECK_EQUAL(countEvents(BattleEventType::TrainerDefeated, events), 1u);
+        CHECK(std::is_sorted(events.begin(), events.end(), [](const BattleEvent& a, const BattleEvent& b) { return a.frame < b.frame; }));
+
+        BattleEventReplayer replayer;
+        CHECK(replayer.replay(LOG_PATH));
+        CHECK_EQUAL(replayer.getEventsRejected(), 0u);
+        CHECK_EQUAL(replayer.getBattles(), 2u);
+        CHECK_EQUAL(replayer.getCurrentStreak(), 2);
+        std::vector<SightingRecord> records;
+        replayer.toSightings(records);
+
+        std::vector<Row> replayed = toRows(records);
+        std::vector<Row> persisted = readDatabase();
+        CHECK_EQUAL(replayed.size(), 7u); // Three Pokemon and four moves
+        CHECK_EQUAL(persisted.size(), replayed.size());
+        CHECK(persisted == replayed);
+        CHECK(std::find(persisted.begin(), persisted.end(), Row(second, "PIKACHU", 1, "THUNDERBOLT")) != persisted.end());
+
+        DatabaseWriter::shared().stop();
+        DatabaseInterface::closeDB();
+    }
+
+    // A crash partway through writing a block, then a restart appending to the same log.
+    void checkTornTail() {
+        removeScratchFiles();
+        {
+            BattleEventLog log;
+            CHECK(log.open(LOG_PATH));
+            for (uint32_t frame = 1; frame <= 10; frame++) log.append({ BattleEventType::MoveSeen, static_cast<int32_t>(frame), frame, frame * 0.25 });
+            log.flush();
+            log.append({ BattleEventType::FoeFainted, -1, 11, 2.75 });
+        }
+        std::ifstream file(LOG_PATH, std::ios::binary | std::ios::ate);
+        std::streamoff intactSize = file.tellg();
+        file.close();
+
+        // Half of a block header and record, as a write cut off by a crash would leave.
+        std::ofstream torn(LOG_PATH, std::ios::binary | std::ios::app);
+        torn.write("\x14\0\0\0\x7f\x3c\x11\x90\x01\x02\x03\x04\x05", 13);
+        torn.close();
+
+        BattleEventLogStats stats;
+        std::vector<BattleEvent> events;
+        CHECK(BattleEventLog::read(LOG_PATH, [&events](const BattleEvent& event) { events.push_back(event); }, &stats));
+        CHECK(stats.damagedTail);
+        CHECK_EQUAL(stats.events, 11u);
+        CHECK_EQUAL(stats.blocks, 2u);
+        CHECK_EQUAL(static_cast<std::streamoff>(stats.intactBytes), intactSize);
+        CHECK_EQUAL(events.back().frame, 11u);
+        CHECK_EQUAL(events.back().timestamp, 2.75);
+
+        // A checksum that does not match its records stops reading at that block, even when its length is right.
+        {
+            BattleEventLog log;
+            CHECK(log.open(LOG_PATH));
+            log.append({ BattleEventType::StreakLost, 0, 12, 3.0 });
+        }
+        stats = BattleEventLogStats();
+        CHECK(BattleEventLog::read(LOG_PATH, [](const BattleEvent&) {}, &stats));
+        CHECK(!stats.damagedTail);
+        CHECK_EQUAL(stats.events, 12u);
+
+        std::fstream corrupt(LOG_PATH, std::ios::binary | std::ios::in | std::ios::out | std::ios::ate);
+        corrupt.seekp(-4, std::ios::end);
+        corrupt.write("\x55", 1);
+        corrupt.close();
+        stats = BattleEventLogStats();
+        CHECK(BattleEventLog::read(LOG_PATH, [](const BattleEvent&) {}, &stats));
+        CHECK(stats.damagedTail);
+        CHECK_EQUAL(stats.events, 11u);
+
+        std::ofstream notALog(LOG_PATH, std::ios::binary | std::ios::trunc);
+        notALog << "SQLite format 3";
+        notALog.close();
+        CHECK(!BattleEventLog::read(LOG_PATH, [](const BattleEvent&) {}));
+        removeScratchFiles();
+    }
+}
+
+int main() {
+    checkReplayMatchesDatabase();
+    checkTornTail();
+    removeScratchFiles();
+    return Check::result();
+}
@@ -0,0 +1,200 @@
+/*
+Checks the bounded queue that hands frames between pipeline stages: capacity, order, what a full or empty queue does,
+eviction of the oldest item, and that every item pushed by several threads is popped exactly once.
+*/
+
+#include "check.h"
+#include "boundedqueue.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+    void checkCapacityAndOrder() {
+        CHECK_EQUAL(BoundedQueue<int>(1).capacity(), 2u);
+        CHECK_EQUAL(BoundedQueue<int>(5).capacity(), 8u);
+        CHECK_EQUAL(BoundedQueue<int>(8).capacity(), 8u);
+
+        BoundedQueue<int> queue(4);
+        int item = -1;
+        CHECK(!queue.tryPop(item));
+        CHECK_EQUAL(item, -1);
+        for (int i = 0; i < 4; ++i) CHECK(queue.tryPush(int(i)));
+        CHECK(!queue.tryPush(4));
+        for (int i = 0; i < 4; ++i) {
+            CHECK(queue.tryPop(item));
+            CHECK_EQUAL(item, i);
+        }
+        CHECK(!queue.tryPop(item));
+
+        // Wrapping round the buffer keeps the order.
+        for (int i = 0; i < 10; ++i) {
+            CHECK(queue.tryPush(int(i)));
+            CHECK(queue.tryPop(item));
+            CHECK_EQUAL(item, i);
+        }
+    }
+
+    void checkDropOldest() {
+        BoundedQueue<int> queue(2);
+        std::vector<int> dropped;
+        auto drop = [&dropped](int&& item) { dropped.push_back(item); };
+        CHECK_EQUAL(queue.pushDropOldest(1, drop), 0u);
+        CHECK_EQUAL(queue.pushDropOldest(2, drop), 0u);
+        CHECK_EQUAL(queue.pushDropOldest(3, drop), 1u);
+        CHECK(dropped == std::vector<int>{ 1 });
+        int item = -1;
+        CHECK(queue.tryPop(item));
+        CHECK_EQUAL(item, 2);
+        CHECK(queue.tryPop(item));
+        CHECK_EQUAL(item, 3);
+        CHECK(!queue.tryPop(item));
+    }
+
+    // Producers push with backpressure through a queue much smaller than the items, consumers count what they pop.
+    void checkManyThreads() {
+        const int producers = 4;
+        const int consumers = 4;
+        const int itemsPerProducer = 20000;
+        const int total = producers * itemsPerProducer;
+        BoundedQueue<int> queue(64);
+        std::vector<std::atomic<int>> seen(total);
+        for (std::atomic<int>& count : seen) count.store(0);
+        std::atomic<int> popped(0);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, p, itemsPerProducer]() {
+                for (int i = 0; i < itemsPerProducer; ++i) queue.push(p * itemsPerProducer + i);
+            });
+        }
+        std::vector<std::vector<int>> orders(consumers);
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&, c]() {
+                int item;
+                while (popped.load() < total) {
+                    if (!queue.tryPop(item)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    seen[item]++;
+                    orders[c].push_back(item);
+                    popped++;
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+
+        CHECK_EQUAL(popped.load(), total);
+        CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& count) { return count.load() == 1; }));
+        int item;
+        CHECK(!queue.tryPop(item));
+
+        // Each consumer sees any one producer's items in the order they were pushed.
+        for (const std::vector<int>& order : orders) {
+            std::vector<int> last(producers, -1);
+            bool ordered = true;
+            for (int value : order) {
+                int producer = value / itemsPerProducer;
+                if (value <= last[producer]) ordered = false;
+                last[producer] = value;
+            }
+            CHECK(ordered);
+        }
+    }
+
+    // Item whose move, on the consumer thread, holds the cell the consumer has claimed until the producer has evicted
+    // holdUntilEvicted items, so a push meets a queue that stays full after its first eviction.
+    std::atomic<bool> claimed(false);
+    std::atomic<size_t> evictedSoFar(0);
+    thread_local size_t holdUntilEvicted = 0;
+
+    struct HeldItem {
+        int value = -1;
+
+        HeldItem() = default;
+        HeldItem(int value) : value(value) {}
+        HeldItem& operator=(HeldItem&& other) {
+            value = other.value;
+            if (holdUntilEvicted > 0) {
+                claimed = true;
+                while (evictedSoFar.load() < holdUntilEvicted) std::this_thread::yield();
+            }
+            return *this;
+        }
+    };
+
+    // The preprocess stage drops the oldest frames while the OCR workers pop them. A worker that has claimed a cell but
+    // not released it keeps the queue full, so one push evicts every other frame, and each must be handed back.
+    void checkDropOldestWithConsumers() {
+        BoundedQueue<HeldItem> queue(4);
+        for (int i = 0; i < 4; ++i) CHECK(queue.tryPush(HeldItem(i)));
+
+        int consumed = -1;
+        std::thread consumer([&queue, &consumed]() {
+            holdUntilEvicted = 3;
+            HeldItem item;
+            if (queue.tryPop(item)) consumed = item.value;
+        });
+        while (!claimed.load()) std::this_thread::yield();
+
+        std::vector<int> evicted;
+        size_t count = queue.pushDropOldest(HeldItem(4), [&evicted](HeldItem&& dropped) {
+            evicted.push_back(dropped.value);
+            evictedSoFar++;
+        });
+        consumer.join();
+
+        CHECK_EQUAL(count, 3u);
+        CHECK_EQUAL(consumed, 0);
+        CHECK((evicted == std::vector<int>{ 1, 2, 3 }));
+        HeldItem item;
+        CHECK(queue.tryPop(item));
+        CHECK_EQUAL(item.value, 4);
+        CHECK(!queue.tryPop(item));
+    }
+
+    // Several consumers pop while one producer drops the oldest items: every item arrives exactly once, either popped
+    // or evicted.
+    void checkDropOldestUnderLoad() {
+        const int consumers = 3;
+        const int total = 100000;
+        BoundedQueue<int> queue(4);
+        std::vector<std::atomic<int>> seen(total);
+        for (std::atomic<int>& count : seen) count.store(0);
+        std::atomic<bool> producing(true);
+
+        std::vector<std::thread> threads;
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&]() {
+                int item;
+                for (;;) {
+                    if (queue.tryPop(item)) {
+                        seen[item]++;
+                        continue;
+                    }
+                    if (!producing.load()) {
+                        if (!queue.tryPop(item)) break;
+                        seen[item]++;
+                    }
+                    std::this_thread::yield();
+                }
+            });
+        }
+        for (int i = 0; i < total; ++i) queue.pushDropOldest(int(i), [&seen](int&& dropped) { seen[dropped]++; });
+        producing = false;
+        for (std::thread& thread : threads) thread.join();
+
+        CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& count) { return count.load() == 1; }));
+    }
+}
+
+int main() {
+    checkCapacityAndOrder();
+    checkDropOldest();
+    checkManyThreads();
+    checkDropOldestWithConsumers();
+    checkDropOldestUnderLoad();
+    return Check::result();
+}
@@ -0,0 +1,93 @@
+/*
+Checks the schema migrations: a new database is brought to the latest version, a version 1 database with a team added
+once per battle has its copies merged with their sightings by version 2, and a migration that fails is rolled back.
+*/
+
+#include "check.h"
+#include "databasemigrations.h"
+#include <sqlite3.h>
+#include <string>
+
+namespace {
+    bool execute(sqlite3* db, const char* sql) {
+        return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+    // The first column of the first row of a query, or -1.
+    int queryInt(sqlite3* db, const char* sql) {
+        sqlite3_stmt* stmt = nullptr;
+        int value = -1;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+        return value;
+    }
+
+    // A version 1 database after two battles with the same trainer: the team was added twice, with different moves
+    // seen each time, along with an empty slot of a team that was never filled.
+    sqlite3* openVersion1() {
+        sqlite3* db = nullptr;
+        sqlite3_open(":memory:", &db);
+        CHECK(migrateDatabase(db, 1));
+        CHECK_EQUAL(getSchemaVersion(db), 1);
+        CHECK(execute(db,
+            "INSERT INTO Trainers(trainer_id, name) VALUES (1, 'LASS CYBIL');"
+            "INSERT INTO Pokemon(pokemon_id, trainer_id, name) VALUES (1, 1, 'GEODUDE'), (2, 1, 'ONIX'), (3, 1, ''),"
+            " (4, 1, 'GEODUDE'), (5, 1, 'ONIX');"
+            "INSERT INTO SeenMoves VALUES (1, 'TACKLE'), (4, 'TACKLE'), (4, 'ROCK THROW'), (3, 'BIND');"
+            "INSERT INTO SeenItems VALUES (5, 'LEFTOVERS');"
+            "INSERT INTO SeenAbilities VALUES (2, 'STURDY'), (5, 'STURDY');"));
+        return db;
+    }
+
+    void checkNewDatabase() {
+        sqlite3* db = nullptr;
+        sqlite3_open(":memory:", &db);
+        CHECK_EQUAL(getSchemaVersion(db), 0);
+        CHECK(migrateDatabase(db));
+        CHECK_EQUAL(getSchemaVersion(db), latestSchemaVersion());
+        CHECK_EQUAL(latestSchemaVersion(), 2);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name IN ('Trainers', 'Pokemon', 'SeenMoves', 'SeenItems', 'SeenAbilities');"), 5);
+
+        // Running again finds nothing to do.
+        CHECK(migrateDatabase(db));
+        CHECK_EQUAL(getSchemaVersion(db), latestSchemaVersion());
+        sqlite3_close(db);
+    }
+
+    void checkDuplicatesMerged() {
+        sqlite3* db = openVersion1();
+        CHECK(migrateDatabase(db));
+        CHECK_EQUAL(getSchemaVersion(db), 2);
+
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM Pokemon;"), 2);
+        CHECK_EQUAL(queryInt(db, "SELECT pokemon_id FROM Pokemon WHERE name = 'GEODUDE';"), 1);
+        CHECK_EQUAL(queryInt(db, "SELECT pokemon_id FROM Pokemon WHERE name = 'ONIX';"), 2);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM SeenMoves WHERE pokemon_id = 1;"), 2);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM SeenMoves;"), 2); // The empty slot's move goes with it
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM SeenItems WHERE pokemon_id = 2 AND item = 'LEFTOVERS';"), 1);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM SeenAbilities;"), 1);
+
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = 'PokemonByTrainer';"), 1);
+        CHECK(!execute(db, "INSERT INTO Pokemon(trainer_id, name) VALUES (1, 'GEODUDE');"));
+        CHECK(execute(db, "INSERT INTO Pokemon(trainer_id, name) VALUES (1, 'NOSEPASS');"));
+        sqlite3_close(db);
+    }
+
+    void checkFailureRolledBack() {
+        sqlite3* db = openVersion1();
+        CHECK(execute(db, "CREATE INDEX PokemonByTrainer ON Pokemon(name);")); // Takes the name version 2 creates
+        CHECK(!migrateDatabase(db));
+        CHECK_EQUAL(getSchemaVersion(db), 1);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM Pokemon;"), 5);
+        CHECK_EQUAL(queryInt(db, "SELECT COUNT(*) FROM SeenMoves;"), 4);
+        CHECK(execute(db, "BEGIN; ROLLBACK;")); // No transaction was left open
+        sqlite3_close(db);
+    }
+}
+
+int main() {
+    checkNewDatabase();
+    checkDuplicatesMerged();
+    checkFailureRolledBack();
+    return Check::result();
+}
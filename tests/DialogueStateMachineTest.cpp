@@ -0,0 +1,83 @@
+/*
+Checks the dialogue state machine: which trigger of the Battle Tower table matches a line in each state and which
+tokens it covers, "*" and "..." in patterns, and that the first listed of several matching triggers wins.
+*/
+
+#include "check.h"
+#include "dialoguestatemachine.h"
+#include "dialoguetokenizer.h"
+#include <string_view>
+#include <vector>
+
+namespace {
+    // The trigger of state that matches line, or nullptr, with the tokens it covers.
+    const DialogueTrigger* matchLine(const DialogueStateMachine& machine, int state, std::string_view line, size_t* firstToken = nullptr,
+        size_t* endToken = nullptr) {
+        DialogueTokenizer tokens;
+        tokens.tokenize(line);
+        TriggerMatch found = {};
+        if (!machine.match(state, tokens, found)) return nullptr;
+        if (firstToken) *firstToken = found.firstToken;
+        if (endToken) *endToken = found.endToken;
+        return found.trigger;
+    }
+
+    bool matchesAction(const DialogueStateMachine& machine, int state, std::string_view line, DialogueAction action) {
+        const DialogueTrigger* trigger = matchLine(machine, state, line);
+        return trigger && trigger->action == action;
+    }
+
+    void checkBattleTower() {
+        DialogueStateMachine machine(battleTowerSingles());
+        size_t first = 0, end = 0;
+
+        CHECK(matchesAction(machine, 0, "You will be facing opponent no. 1", DialogueAction::AnnounceStreak));
+        CHECK(matchLine(machine, 0, "FOE GEODUDE USED TACKLE!") == nullptr);
+
+        // Every line in state 1 may hold the trainer's name, the empty pattern matches them all.
+        CHECK(matchesAction(machine, 1, "PKMN TRAINER ANNA would like to battle!", DialogueAction::StartBattle));
+        CHECK(matchesAction(machine, 1, "", DialogueAction::StartBattle));
+
+        const DialogueTrigger* sentOut = matchLine(machine, 2, "ANNA & MEG sent out ONIX!", &first, &end);
+        CHECK(sentOut && sentOut->action == DialogueAction::SendOutPokemon && sentOut->nextState == 3);
+        CHECK_EQUAL(first, 3u);
+        CHECK_EQUAL(end, 6u);
+        CHECK(matchLine(machine, 2, "ANNA sent out") == nullptr); // "*" needs a token
+        CHECK(matchesAction(machine, 2, "We will restore your POKEMON", DialogueAction::DefeatTrainer));
+
+        // "FOE * FAINTED" is listed before "FOE", so a fainting line is not taken for a detail.
+        const DialogueTrigger* fainted = matchLine(machine, 3, "Foe GEODUDE fainted!", &first, &end);
+        CHECK(fainted && fainted->action == DialogueAction::FoeFainted && fainted->nextState == 2);
+        CHECK_EQUAL(end, 3u);
+        const DialogueTrigger* detail = matchLine(machine, 3, "Foe GEODUDE used ROCK THROW!", &first, &end);
+        CHECK(detail && detail->action == DialogueAction::RevealDetail && detail->nextState == -1);
+        CHECK_EQUAL(first, 0u);
+        CHECK_EQUAL(end, 1u);
+        CHECK(matchLine(machine, 3, "The FOE GEODUDE fainted") == nullptr); // Anchored patterns start at the first token
+
+        CHECK(matchLine(machine, 4, "FOE GEODUDE FAINTED") == nullptr);
+        CHECK(matchLine(machine, -1, "FOE GEODUDE FAINTED") == nullptr);
+    }
+
+    void checkListOrder() {
+        const std::vector<DialogueTrigger> shortFirst = {
+            { 0, "SENT", DialogueAction::FoeFainted, -1 },
+            { 0, "SENT OUT", DialogueAction::SendOutPokemon, -1 },
+        };
+        const std::vector<DialogueTrigger> longFirst = {
+            { 0, "SENT OUT", DialogueAction::SendOutPokemon, -1 },
+            { 0, "SENT", DialogueAction::FoeFainted, -1 },
+            { 0, "... OUT", DialogueAction::WinStreak, -1 },
+        };
+        CHECK(matchesAction(DialogueStateMachine(shortFirst), 0, "SENT OUT", DialogueAction::FoeFainted));
+        CHECK(matchesAction(DialogueStateMachine(longFirst), 0, "SENT OUT", DialogueAction::SendOutPokemon));
+        CHECK(matchesAction(DialogueStateMachine(longFirst), 0, "SENT AWAY", DialogueAction::FoeFainted));
+        CHECK(matchesAction(DialogueStateMachine(longFirst), 0, "WAY OUT", DialogueAction::WinStreak));
+    }
+}
+
+int main() {
+    checkBattleTower();
+    checkListOrder();
+    return Check::result();
+}
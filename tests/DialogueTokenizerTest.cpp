@@ -0,0 +1,79 @@
+/*
+Checks the dialogue tokenizer: words are uppercased and joined by single spaces with trailing '!' and ',' dropped,
+spans cover the words they name, and lines past MAX_TOKENS words or MAX_LINE_LENGTH characters are cut short.
+*/
+
+#include "check.h"
+#include "dialoguetokenizer.h"
+#include <string>
+#include <string_view>
+
+namespace {
+    void checkWords() {
+        DialogueTokenizer tokenizer;
+        CHECK(tokenizer.empty());
+
+        tokenizer.tokenize("  Foe Geodude  used\tRock Throw!  ");
+        CHECK_EQUAL(tokenizer.size(), 5u);
+        CHECK_EQUAL(tokenizer[0], "FOE");
+        CHECK_EQUAL(tokenizer[1], "GEODUDE");
+        CHECK_EQUAL(tokenizer[4], "THROW");
+        CHECK_EQUAL(tokenizer.text(), "FOE GEODUDE USED ROCK THROW");
+
+        // Trailing punctuation goes, a word made of nothing else goes with it, and punctuation inside a word stays.
+        tokenizer.tokenize("Well, MR. MIME!! ! ,");
+        CHECK_EQUAL(tokenizer.size(), 3u);
+        CHECK_EQUAL(tokenizer[0], "WELL");
+        CHECK_EQUAL(tokenizer[1], "MR.");
+        CHECK_EQUAL(tokenizer.text(), "WELL MR. MIME");
+
+        tokenizer.tokenize("   ");
+        CHECK(tokenizer.empty());
+        CHECK_EQUAL(tokenizer.text(), "");
+    }
+
+    void checkSpans() {
+        DialogueTokenizer tokenizer;
+        tokenizer.tokenize("PKMN TRAINER  ANNA & MEG would like to battle!");
+        CHECK_EQUAL(tokenizer.span(2, 3), "ANNA & MEG");
+        CHECK_EQUAL(tokenizer.span(0, 1), "PKMN");
+        CHECK_EQUAL(tokenizer.span(0, tokenizer.size()), tokenizer.text());
+        CHECK(tokenizer.span(2, 0).empty());
+        CHECK(tokenizer.span(8, 2).empty());
+
+        size_t words = 0;
+        for (std::string_view token : tokenizer) {
+            CHECK(!token.empty());
+            words++;
+        }
+        CHECK_EQUAL(words, tokenizer.size());
+    }
+
+    void checkLimits() {
+        DialogueTokenizer tokenizer;
+        std::string manyWords;
+        for (size_t i = 0; i < DialogueTokenizer::MAX_TOKENS + 8; i++) manyWords += "a ";
+        tokenizer.tokenize(manyWords);
+        CHECK_EQUAL(tokenizer.size(), DialogueTokenizer::MAX_TOKENS);
+
+        std::string longLine(DialogueTokenizer::MAX_LINE_LENGTH - 2, 'x');
+        longLine += " yz";
+        tokenizer.tokenize(longLine);
+        CHECK_EQUAL(tokenizer.size(), 2u);
+        CHECK_EQUAL(tokenizer[1], "Y");
+        CHECK_EQUAL(tokenizer.text().size(), DialogueTokenizer::MAX_LINE_LENGTH);
+
+        // Views from a short line after a long one point into the same buffer, which has not moved.
+        const char* before = tokenizer.text().data();
+        tokenizer.tokenize("sent out");
+        CHECK(tokenizer.text().data() == before);
+        CHECK_EQUAL(tokenizer.span(0, 2), "SENT OUT");
+    }
+}
+
+int main() {
+    checkWords();
+    checkSpans();
+    checkLimits();
+    return Check::result();
+}
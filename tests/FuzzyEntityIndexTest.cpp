@@ -0,0 +1,95 @@
+/*
+Checks the fuzzy entity index: the edits allowed by name length, the confidence of a match against the 0.8 BattleLogic
+takes a misread name at, ties, type masks, and misreads of GameData names.
+*/
+
+#include "check.h"
+#include "fuzzyentityindex.h"
+#include "gamedata.h"
+
+namespace {
+    const float MIN_FUZZY_CONFIDENCE = 0.8f; // As in BattleLogic.cpp
+
+    void checkDistances() {
+        CHECK_EQUAL(FuzzyEntityIndex::maxDistanceFor(3), 0);
+        CHECK_EQUAL(FuzzyEntityIndex::maxDistanceFor(4), 1);
+        CHECK_EQUAL(FuzzyEntityIndex::maxDistanceFor(7), 1);
+        CHECK_EQUAL(FuzzyEntityIndex::maxDistanceFor(8), 2);
+
+        FuzzyEntityIndex index;
+        index.add(EntityType::Move, 1, "CUT");
+        index.add(EntityType::Pokemon, 2, "ONIX");
+        index.add(EntityType::Pokemon, 3, "GEODUDE");
+        index.add(EntityType::Move, 4, "THUNDERBOLT");
+        index.build();
+
+        FuzzyMatch match;
+        CHECK(index.lookup("GEODUDE", match));
+        CHECK_EQUAL(match.id, 3);
+        CHECK_EQUAL(match.distance, 0);
+        CHECK_EQUAL(match.confidence, 1.0f);
+
+        // One edit in seven letters is taken, one in four is found but falls short of the threshold.
+        CHECK(index.lookup("GEODUDF", match));
+        CHECK_EQUAL(match.id, 3);
+        CHECK_EQUAL(match.distance, 1);
+        CHECK(match.confidence >= MIN_FUZZY_CONFIDENCE);
+        CHECK(index.lookup("0NIX", match));
+        CHECK_EQUAL(match.id, 2);
+        CHECK(match.confidence < MIN_FUZZY_CONFIDENCE);
+
+        CHECK(!index.lookup("CAT", match));  // Three letters allow no edits
+        CHECK(!index.lookup("GE0DUDF", match)); // Two edits in seven letters
+        CHECK(index.lookup("THUNDFRB0LT", match));
+        CHECK_EQUAL(match.distance, 2);
+        CHECK(match.confidence >= MIN_FUZZY_CONFIDENCE);
+        CHECK(!index.lookup("THUNDFRB0L", match));
+    }
+
+    void checkTiesAndTypes() {
+        FuzzyEntityIndex index;
+        index.add(EntityType::Pokemon, 1, "ABCDEF");
+        index.add(EntityType::Move, 2, "ABCDEG");
+        index.add(EntityType::Item, 3, "ABCDEH");
+        index.build();
+
+        FuzzyMatch match;
+        CHECK(index.lookup("ABCDEX", match));
+        CHECK_EQUAL(match.id, 1); // Ties go to the name added first, at half the confidence
+        CHECK_EQUAL(match.confidence, 0.5f * (1.0f - 1.0f / 6));
+
+        CHECK(index.lookup("ABCDEX", match, entityTypeMask(EntityType::Move)));
+        CHECK(match.type == EntityType::Move);
+        CHECK_EQUAL(match.id, 2);
+        CHECK_EQUAL(match.confidence, 1.0f - 1.0f / 6);
+
+        CHECK(index.lookup("ABCDEH", match, entityTypeMask(EntityType::Move) | entityTypeMask(EntityType::Item)));
+        CHECK_EQUAL(match.id, 3);
+        CHECK(!index.lookup("ABCDEF", match, entityTypeMask(EntityType::Trainer)));
+    }
+
+    void checkGameData() {
+        const FuzzyEntityIndex& index = FuzzyEntityIndex::gameData();
+        FuzzyMatch match;
+        CHECK(index.lookup("GEODUDF", match, entityTypeMask(EntityType::Pokemon)));
+        CHECK(match.type == EntityType::Pokemon);
+        CHECK_EQUAL(match.id, GameData::pokemon.find("GEODUDE"));
+        CHECK(match.confidence >= MIN_FUZZY_CONFIDENCE);
+
+        CHECK(index.lookup("R0CK THROW", match, entityTypeMask(EntityType::Move)));
+        CHECK_EQUAL(match.id, GameData::moves.find("ROCK THROW"));
+        CHECK(match.confidence >= MIN_FUZZY_CONFIDENCE);
+
+        // Dialogue words are not taken for names.
+        for (const char* word : { "FOE", "USED", "SENT", "THE" }) {
+            CHECK(!index.lookup(word, match) || match.confidence < MIN_FUZZY_CONFIDENCE);
+        }
+    }
+}
+
+int main() {
+    checkDistances();
+    checkTiesAndTypes();
+    checkGameData();
+    return Check::result();
+}
@@ -0,0 +1,89 @@
+/*
+Checks the knowledge snapshot: a snapshot exported from a database finds its trainers and Pokemon, and a file cut short
+or with an index entry past its section is refused when opened instead of read out of bounds.
+*/
+
+#include "check.h"
+#include "databasemigrations.h"
+#include "knowledgesnapshot.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace {
+    const char* const SNAPSHOT_PATH = "knowledgesnapshottest.snap";
+
+    std::vector<char> readFile(const char* path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const char* path, const std::vector<char>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // Offset of the trainers-by-name index, read from the header: magic, two versions and five table stamps, then four
+    // counts and the trainers offset come before it.
+    uint32_t trainersByNameOffset(const std::vector<char>& bytes) {
+        uint32_t offset = 0;
+        std::copy(bytes.begin() + 8 + 2 * 4 + 5 * 8 + 5 * 4, bytes.begin() + 8 + 2 * 4 + 5 * 8 + 6 * 4, reinterpret_cast<char*>(&offset));
+        return offset;
+    }
+
+    void checkSnapshot() {
+        sqlite3* db = nullptr;
+        sqlite3_open(":memory:", &db);
+        CHECK(migrateDatabase(db));
+        CHECK_EQUAL(sqlite3_exec(db,
+            "INSERT INTO Trainers(trainer_id, name) VALUES (1, 'LASS CYBIL'), (2, 'YOUNGSTER BRADY'), (3, 'HIKER ALAN');"
+            "INSERT INTO Pokemon(pokemon_id, trainer_id, name) VALUES (1, 1, 'GEODUDE'), (2, 2, 'ONIX');"
+            "INSERT INTO SeenMoves VALUES (1, 'TACKLE');", nullptr, nullptr, nullptr), SQLITE_OK);
+        std::remove(SNAPSHOT_PATH);
+        CHECK(KnowledgeSnapshot::exportFrom(db, SNAPSHOT_PATH));
+
+        {
+            KnowledgeSnapshot snapshot;
+            CHECK(snapshot.open(SNAPSHOT_PATH));
+            CHECK(snapshot.isCurrent(db));
+            CHECK_EQUAL(snapshot.getTrainerCount(), 3);
+            int trainer = snapshot.findTrainer("YOUNGSTER BRADY");
+            CHECK(trainer != KnowledgeSnapshot::NOT_FOUND);
+            CHECK_EQUAL(snapshot.getTrainerID(trainer), 2);
+            CHECK_EQUAL(snapshot.findTrainer("LASS ANNA"), KnowledgeSnapshot::NOT_FOUND);
+            int geodude = snapshot.findPokemonByID(1);
+            CHECK(geodude != KnowledgeSnapshot::NOT_FOUND);
+            CHECK_EQUAL(snapshot.getSeen(geodude, EntityType::Move, 0), "TACKLE");
+        }
+        sqlite3_close(db);
+
+        const std::vector<char> intact = readFile(SNAPSHOT_PATH);
+        KnowledgeSnapshot snapshot;
+
+        std::vector<char> truncated(intact.begin(), intact.end() - 8);
+        writeFile(SNAPSHOT_PATH, truncated);
+        CHECK(!snapshot.open(SNAPSHOT_PATH));
+
+        // An index entry naming a trainer past the end of the trainer table.
+        std::vector<char> badIndex = intact;
+        uint32_t pastEnd = 3;
+        std::copy(reinterpret_cast<const char*>(&pastEnd), reinterpret_cast<const char*>(&pastEnd) + 4, badIndex.begin() + trainersByNameOffset(intact));
+        writeFile(SNAPSHOT_PATH, badIndex);
+        CHECK(!snapshot.open(SNAPSHOT_PATH));
+        CHECK_EQUAL(snapshot.findTrainer("LASS CYBIL"), KnowledgeSnapshot::NOT_FOUND);
+
+        writeFile(SNAPSHOT_PATH, intact);
+        CHECK(snapshot.open(SNAPSHOT_PATH));
+        snapshot.close();
+        std::remove(SNAPSHOT_PATH);
+    }
+}
+
+int main() {
+    checkSnapshot();
+    return Check::result();
+}
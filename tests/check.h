@@ -0,0 +1,37 @@
+#pragma once
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// Assertions for the test programs. A failed check prints where it is and what it found, and the test carries on, so
+// one run lists every check that fails. Each test's main returns Check::result() for ctest.
+namespace Check {
+    inline int failures = 0;
+
+    inline int result() {
+        if (failures) std::cout << failures << " checks failed" << std::endl;
+        return failures ? 1 : 0;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cout << __FILE__ << ":" << __LINE__ << ": failed: " << #condition << std::endl; \
+            ++Check::failures; \
+        } \
+    } while (false)
+
+#define CHECK_EQUAL(actual, expected) \
+    do { \
+        const auto& checkActual = (actual); \
+        const auto& checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            std::cout << __FILE__ << ":" << __LINE__ << ": failed: " << #actual << " is " << checkActual << ", expected " \
+                << checkExpected << std::endl; \
+            ++Check::failures; \
+        } \
+    } while (false)
+
+#endif
@@ -3,62 +3,52 @@
 #define TRAINER_H
 #include "pokemon.h"
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <sqlite3.h>
 
 class Trainer {
 private:
-    sqlite3* db; //SQL database, initialized within the object to prevent issues with multiple Trainers (Shouldn't happen until we start keeping track of my own Pokemon)
-    int trainerID;
     int streakNumber;
-    std::string name;
-    std::vector<Pokemon> activeTeam;
+    std::string_view name; // GameData's copy of the name, so holding it allocates nothing
+    Team activeTeam;
+    int activeSlot; // Slot of the Pokemon out, -1 when none is or it has no slot
     std::vector<Pokemon> potentialTeam;
 
 public:
-    //Constructor, passed with a name. Add Streak number to it as well later on.
-    Trainer(std::string trainerName);
+    //Constructor, passed with a name, which must outlive the trainer as GameData's names do. Add Streak number to it as well later on.
+    //Does not touch the database, the database writer finds or adds the trainer when the battle is saved.
+    explicit Trainer(std::string_view trainerName);
 
     //Overloaded constructor to include a streak number if one is given.
-    Trainer(std::string trainerName, int streakNumber);
+    Trainer(std::string_view trainerName, int streakNumber);
 
-    //Returns a Pokemon from the PotentialTeam vector with a specific name, used in conjuction with AddActive method.
-    std::vector<Pokemon> grabMon(const std::string& pokeName);
+    Trainer(const Trainer&) = delete; // The destructor queues the battle, a copy would queue it twice
+    Trainer& operator=(const Trainer&) = delete;
 
-    //Initializes the empty Active Team. This has three, mutable slots for trainers that have multiple sets of the same Pokemon.
-    void initActiveTeam();
+    //Returns a Pokemon from the PotentialTeam vector with a specific GameData species ID, used in conjuction with AddActive method.
+    std::vector<Pokemon> grabMon(int species);
 
-    //Retrieves the trainer ID generated/retrieved during construction
-    int getTrainerID() const;
+    //Empties the Active Team. This has three, mutable slots for trainers that have multiple sets of the same Pokemon.
+    void initActiveTeam();
 
 	//Retrieves the trainer name that was passed during construction
-    std::string getTrainerName() const;
-
-    //Adds a vector of Pokemon to an empty Active Team slot.
-    void updateActiveSlot(const std::string& pokemonName);
-
-    //Logic to check if a Pokemon is being resent out after being switched.
-    bool isPokemonInActive(const std::string& pokemonName);
-
+    std::string_view getTrainerName() const;
 
-    //Pulls potential moves for a Pokemon, displays as one list.
-    std::vector<std::string> getSeenMoves(int pokemonID);
+    //Makes a Pokemon, by GameData species ID, the one out: its own slot when it was sent out before, otherwise the first
+    //empty Active Team slot. A species sent out after all three are filled has no slot and is not kept.
+    void updateActiveSlot(int species);
 
-    //Adds a seen move to that Pokemon's database.
-    void trainerAddSeenMove(int PokemonID, const std::string& moveName);
+    //The Pokemon out, for moves, abilities and items it reveals. Null before one is sent out and after it faints.
+    Pokemon* getActivePokemon();
+    void clearActiveSlot();
 
-    //Adds an item seen used / knocked off to that Trainer's Pokemon's database.
-    void trainerAddSeenItem(int PokemonID, const std::string& Item);
-
-    //Adds an ability seen activated / changed to that Trainer's Pokemon's database.
-    void trainerAddSeenAbility(int PokemonID, const std::string& Ability);
+    //Logic to check if a Pokemon is being resent out after being switched.
+    bool isPokemonInActive(int species) const;
 
-    //Grabs the unique Pokemon ID assigned to each individual Pokemon from the SQLite database.
-    int getPokemonID(const std::string& name);
 
-    //Deconstructor, saves all new and changed information to the SQLite database.
+    //Deconstructor, queues all new and changed information to be saved to the SQLite database.
     ~Trainer();
 
 
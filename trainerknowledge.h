@@ -0,0 +1,80 @@
+#pragma once
+#ifndef TRAINERKNOWLEDGE_H
+#define TRAINERKNOWLEDGE_H
+
+#include "entitymatcher.h"
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <sqlite3.h>
+
+class KnowledgeSnapshot;
+
+// What one of a trainer's Pokemon has been seen with in earlier battles, as GameData IDs.
+struct PokemonHistory {
+    int pokemonID = -1; // Database ID
+    int species = -1;
+    std::vector<int> moves;
+    std::vector<int> abilities;
+    std::vector<int> items;
+};
+
+struct TrainerHistory {
+    int trainerID = -1; // Database ID
+    std::vector<PokemonHistory> pokemon;
+};
+
+// The Trainers, Pokemon and Seen tables held in memory, so scouting a trainer takes no queries. Loaded once at startup
+// and kept current by DatabaseInterface writing through to it. Trainers are kept by GameData ID and Pokemon by database
+// ID, both dense, so every map is a plain vector. Names that are not in GameData are left out.
+class TrainerKnowledge {
+private:
+    struct PokemonLocation {
+        int trainer = -1; // GameData trainer ID
+        int slot = -1;    // Index in the trainer's pokemon
+    };
+
+    mutable std::mutex lock;
+    bool loaded;
+    std::vector<TrainerHistory> trainers;          // By GameData trainer ID
+    std::vector<int> trainerNames;                 // GameData trainer ID by database trainer ID
+    std::vector<PokemonLocation> pokemonLocations; // By database Pokemon ID
+    size_t trainerCount;
+    size_t pokemonCount;
+
+    void clearLocked();
+    void addTrainerLocked(int trainerID, std::string_view name);
+    void addPokemonLocked(int pokemonID, int trainerID, std::string_view name);
+    void addSeenLocked(int pokemonID, EntityType type, std::string_view name);
+
+public:
+    TrainerKnowledge();
+
+    //Replaces the contents with the database's. Returns false, and stays empty, if a table could not be read.
+    bool load(sqlite3* db);
+
+    //Replaces the contents with a snapshot's, which is read where it is mapped instead of through queries.
+    bool load(const KnowledgeSnapshot& snapshot);
+    bool isLoaded() const;
+
+    //Database ID of a trainer, or -1 when it is not known.
+    int findTrainerID(std::string_view name) const;
+
+    //Copies what the trainer's Pokemon have shown before into history, reusing its vectors. Returns false when the
+    //trainer is not known.
+    bool getHistory(std::string_view name, TrainerHistory& history) const;
+
+    //Write-through of rows just added to the database. Ignored until loaded, a partial cache would claim a trainer
+    //had shown nothing. The type of a sighting is Move, Ability or Item.
+    void addTrainer(int trainerID, std::string_view name);
+    void addPokemon(int pokemonID, int trainerID, std::string_view name);
+    void addSeen(int pokemonID, EntityType type, std::string_view name);
+
+    size_t getTrainerCount() const;
+    size_t getPokemonCount() const;
+
+    //Cache DatabaseInterface writes through to.
+    static TrainerKnowledge& shared();
+};
+
+#endif